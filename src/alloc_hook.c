@@ -0,0 +1,96 @@
+#include "alloc_hook.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static _Atomic(alloc_hook_t) alloc_hook;
+
+void alloc_hook_set(alloc_hook_t hook) {
+    atomic_store(&alloc_hook, hook);
+}
+
+#ifdef __GLIBC__
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void  __libc_free(void *ptr);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+
+// `caller` is taken by each wrapper, this may be inlined into it.
+static void _call_hook(size_t size, void *caller) {
+    alloc_hook_t hook =
+        atomic_load_explicit(&alloc_hook, memory_order_relaxed);
+    if (hook != NULL) {
+        hook(size, caller);
+    }
+}
+
+void *malloc(size_t size) {
+    _call_hook(size, __builtin_return_address(0));
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    _call_hook(nmemb * size, __builtin_return_address(0));
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    _call_hook(size, __builtin_return_address(0));
+    return __libc_realloc(ptr, size);
+}
+
+void *reallocarray(void *ptr, size_t nmemb, size_t size) {
+    if (size != 0 && nmemb > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    _call_hook(nmemb * size, __builtin_return_address(0));
+    return __libc_realloc(ptr, nmemb * size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    _call_hook(size, __builtin_return_address(0));
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    _call_hook(size, __builtin_return_address(0));
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+    if (alignment % sizeof(void *) != 0 ||
+        (alignment & (alignment - 1)) != 0 || alignment == 0) {
+        return EINVAL;
+    }
+
+    _call_hook(size, __builtin_return_address(0));
+    void *mem = __libc_memalign(alignment, size);
+    if (mem == NULL) {
+        return ENOMEM;
+    }
+    *ptr = mem;
+    return 0;
+}
+
+void *valloc(size_t size) {
+    _call_hook(size, __builtin_return_address(0));
+    return __libc_valloc(size);
+}
+
+void *pvalloc(size_t size) {
+    _call_hook(size, __builtin_return_address(0));
+    return __libc_pvalloc(size);
+}
+
+#endif
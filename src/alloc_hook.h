@@ -0,0 +1,24 @@
+#ifndef __ALLOC_HOOK_H_INCLUDED__
+#define __ALLOC_HOOK_H_INCLUDED__
+
+#include <stddef.h>
+
+// Called with the size of each allocation and the address it was made from.
+typedef void (*alloc_hook_t)(size_t size, void *caller);
+
+/*
+ * Wrappers of the glibc allocator functions, in the programs built with
+ * alloc_hook.c, calling a hook before forwarding to glibc. Used by --stats
+ * and test_alloc.
+ *
+ * The whole family is replaced, `free` and the aligned variants included, so
+ * that memory always goes back to the allocator it came from, even with
+ * another one in LD_PRELOAD. Such an allocator is bypassed, except for its
+ * `malloc_usable_size`, which can't be used then. Other C libraries don't
+ * export their allocator under another name, the hook is never called there.
+ */
+
+// Call `hook` on every allocation from now on, on any thread. NULL stops.
+void alloc_hook_set(alloc_hook_t hook);
+
+#endif
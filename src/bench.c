@@ -0,0 +1,312 @@
+#include "bench.h"
+
+#include "log.h"
+#include "resize_params.h"
+
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_GUIDES                                                         \
+    "a:h:25% b:h:33% c:h:50% d:h:66% k:h:75% l:h:85% e:v:25% f:v:33% g:v:50% " \
+    "h:v:66% i:v:75% j:v:85%"
+
+static const struct {
+    const char *name;
+    uint32_t    type;
+    uint64_t    config;
+} counter_events[BENCH_NUM_COUNTERS] = {
+    [BENCH_CYCLES] = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [BENCH_INSTRUCTIONS] =
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    [BENCH_CACHE_MISSES] =
+        {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    [BENCH_PAGE_FAULTS] =
+        {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+double bench_now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int _open_counter(enum bench_counter counter, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size        = sizeof(attr);
+    attr.type        = counter_events[counter].type;
+    attr.config      = counter_events[counter].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    // The other counters of the group follow the leader.
+    attr.disabled   = group_fd < 0;
+    attr.exclude_hv = 1;
+    // Page faults are counted in the kernel, hardware counters are often
+    // only allowed in user space.
+    attr.exclude_kernel = attr.type == PERF_TYPE_HARDWARE;
+
+    return syscall(
+        SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC
+    );
+}
+
+void bench_counters_init(struct bench_counters *counters) {
+    counters->group_fd = -1;
+    counters->num_open = 0;
+    counters->start_ms = 0;
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        counters->fds[i]   = -1;
+        counters->slots[i] = -1;
+    }
+
+    if (getenv("BENCH_COUNTERS") == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        int fd = _open_counter(i, counters->group_fd);
+        if (fd < 0) {
+            LOG_WARN("Could not open the %s counter.", counter_events[i].name);
+            continue;
+        }
+
+        if (counters->group_fd < 0) {
+            counters->group_fd = fd;
+        }
+        counters->fds[i]   = fd;
+        counters->slots[i] = counters->num_open++;
+    }
+}
+
+void bench_counters_finish(struct bench_counters *counters) {
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->fds[i] >= 0) {
+            close(counters->fds[i]);
+        }
+        counters->fds[i]   = -1;
+        counters->slots[i] = -1;
+    }
+    counters->group_fd = -1;
+    counters->num_open = 0;
+}
+
+void bench_sample_begin(struct bench_counters *counters) {
+    if (counters->group_fd >= 0) {
+        ioctl(counters->group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    counters->start_ms = bench_now_ms();
+}
+
+void bench_sample_end(
+    struct bench_counters *counters, struct bench_sample *sample
+) {
+    sample->ms += bench_now_ms() - counters->start_ms;
+    if (counters->group_fd < 0) {
+        return;
+    }
+
+    ioctl(counters->group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // Number of counters, then their values in the order they were opened.
+    uint64_t values[1 + BENCH_NUM_COUNTERS];
+    if (read(counters->group_fd, values, sizeof(values)) <
+        (ssize_t)sizeof(uint64_t) * (1 + counters->num_open)) {
+        return;
+    }
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->slots[i] >= 0) {
+            sample->counts[i] += values[1 + counters->slots[i]];
+        }
+    }
+}
+
+void bench_sample_print_counters(
+    const char *name, struct bench_counters *counters,
+    struct bench_sample *sample, int iterations
+) {
+    if (counters->num_open == 0) {
+        return;
+    }
+
+    printf("%-20s", name);
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->slots[i] < 0) {
+            printf("  %s n/a", counter_events[i].name);
+        } else {
+            printf(
+                "  %s %.0f", counter_events[i].name,
+                (double)sample->counts[i] / iterations
+            );
+        }
+    }
+    putchar('\n');
+}
+
+void bench_state_init(struct state *state, int32_t width, int32_t height) {
+    memset(state, 0, sizeof(struct state));
+
+    char guides[] = DEFAULT_GUIDES;
+    state->resize_params = load_resize_parameters(guides);
+
+    struct focused_window *fw = &state->focused_window;
+    fw->rect = (struct rect){
+        .x = 0,
+        .y = 0,
+        .w = width / 2,
+        .h = height,
+    };
+    fw->output_rect = (struct rect){
+        .x = 0,
+        .y = 0,
+        .w = width,
+        .h = height,
+    };
+    fw->resize_right        = true;
+    fw->resize_bottom       = true;
+    fw->resize_left_limit   = 0;
+    fw->resize_right_limit  = width;
+    fw->resize_top_limit    = 0;
+    fw->resize_bottom_limit = height;
+    resize_parameters_compute_guides(state->resize_params, fw);
+    state->focused_window_ready = true;
+}
+
+void bench_state_finish(struct state *state) {
+    free_resize_params(state->resize_params);
+}
+
+static void _write_rect(
+    FILE *f, const char *name, int32_t x, int32_t y, int32_t w, int32_t h
+) {
+    fprintf(
+        f, "\"%s\":{\"x\":%d,\"y\":%d,\"width\":%d,\"height\":%d}", name, x, y,
+        w, h
+    );
+}
+
+// The fields of a window in a GET_TREE reply that are not read, so that
+// parsing costs about as much as for a real tree.
+static void _write_window_fields(FILE *f, int id) {
+    fprintf(
+        f,
+        "\"name\":\"Window %d \\u2014 \\\"bench\\\"\",\"app_id\":\"bench\","
+        "\"pid\":%d,"
+        "\"visible\":true,\"urgent\":false,\"sticky\":false,\"marks\":[],"
+        "\"border\":\"normal\",\"current_border_width\":2,"
+        "\"fullscreen_mode\":0,\"percent\":0.25,\"inhibit_idle\":false,"
+        "\"shell\":\"xdg_shell\",\"idle_inhibitors\":{\"user\":\"none\","
+        "\"application\":\"none\"},",
+        id, 1000 + id
+    );
+    _write_rect(f, "window_rect", 2, 0, 476, 336);
+    fputc(',', f);
+    _write_rect(f, "geometry", 0, 0, 476, 336);
+    fputc(',', f);
+}
+
+static void _write_window(
+    FILE *f, int id, int32_t x, int32_t y, int32_t w, int32_t h, bool focused
+) {
+    fprintf(
+        f, "{\"id\":%d,\"type\":\"con\",\"focused\":%s,", id,
+        focused ? "true" : "false"
+    );
+    _write_window_fields(f, id);
+    _write_rect(f, "rect", x, y + 24, w, h - 24);
+    fputc(',', f);
+    _write_rect(f, "deco_rect", 0, 0, w, 24);
+    fprintf(f, ",\"focus\":[],\"nodes\":[],\"floating_nodes\":[]}");
+}
+
+static void _write_focus(FILE *f, int first_id, int count, int focused) {
+    fprintf(f, "\"focus\":[%d", first_id + focused);
+    for (int i = 0; i < count; i++) {
+        if (i != focused) {
+            fprintf(f, ",%d", first_id + i);
+        }
+    }
+    fprintf(f, "]");
+}
+
+char *bench_tree(int32_t width, int32_t height, int columns, int rows) {
+    char  *tree = NULL;
+    size_t size = 0;
+    FILE  *f    = open_memstream(&tree, &size);
+    if (f == NULL) {
+        return NULL;
+    }
+
+    fprintf(f, "{\"id\":1,\"type\":\"root\",\"focus\":[2],");
+    _write_rect(f, "rect", 0, 0, width, height);
+    fprintf(f, ",\"floating_nodes\":[],\"nodes\":[");
+    fprintf(f, "{\"id\":2,\"type\":\"output\",\"name\":\"BENCH-1\",");
+    fprintf(f, "\"focus\":[3],\"floating_nodes\":[],");
+    _write_rect(f, "rect", 0, 0, width, height);
+    fprintf(f, ",\"nodes\":[");
+    fprintf(f, "{\"id\":3,\"type\":\"workspace\",\"name\":\"1\",");
+    fprintf(f, "\"orientation\":\"horizontal\",\"layout\":\"splith\",");
+    _write_focus(f, 10, columns, columns - 1);
+    fputc(',', f);
+    _write_rect(f, "rect", 0, 0, width, height);
+    fprintf(f, ",\"floating_nodes\":[],\"nodes\":[");
+
+    int32_t column_width = width / columns;
+    int32_t row_height   = height / rows;
+    for (int c = 0; c < columns; c++) {
+        int first_id = 10 + columns + c * rows;
+        fprintf(f, "%s{\"id\":%d,\"type\":\"con\",", c > 0 ? "," : "", 10 + c);
+        fprintf(f, "\"orientation\":\"vertical\",\"layout\":\"splitv\",");
+        _write_focus(f, first_id, rows, rows - 1);
+        fputc(',', f);
+        _write_rect(f, "rect", c * column_width, 0, column_width, height);
+        fprintf(f, ",\"floating_nodes\":[],\"nodes\":[");
+        for (int r = 0; r < rows; r++) {
+            if (r > 0) {
+                fputc(',', f);
+            }
+            _write_window(
+                f, first_id + r, c * column_width, r * row_height,
+                column_width, row_height, c == columns - 1 && r == rows - 1
+            );
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "]}]}]}");
+
+    if (fclose(f) != 0) {
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+char *bench_read_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        LOG_ERR("Could not open '%s'.", path);
+        return NULL;
+    }
+
+    char  *data = NULL;
+    size_t size = 0;
+    FILE  *out  = open_memstream(&data, &size);
+    char   chunk[4096];
+    size_t n;
+    while (out != NULL && (n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        fwrite(chunk, 1, n, out);
+    }
+    fclose(f);
+    if (out == NULL || fclose(out) != 0) {
+        LOG_ERR("Could not read '%s'.", path);
+        free(data);
+        return NULL;
+    }
+    return data;
+}
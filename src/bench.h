@@ -0,0 +1,71 @@
+#ifndef __BENCH_H_INCLUDED__
+#define __BENCH_H_INCLUDED__
+
+#include "state.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum bench_counter {
+    BENCH_CYCLES,
+    BENCH_INSTRUCTIONS,
+    BENCH_CACHE_MISSES,
+    BENCH_PAGE_FAULTS,
+    BENCH_NUM_COUNTERS,
+};
+
+/*
+ * Performance counters of the calling thread, read with perf_event_open when
+ * BENCH_COUNTERS is set in the environment.
+ *
+ * The counters are opened as a single group so that they are started,
+ * stopped and read together. Those that can't be opened, e.g. hardware
+ * counters in a VM or with a restrictive perf_event_paranoid, are left out.
+ */
+struct bench_counters {
+    int    fds[BENCH_NUM_COUNTERS]; // -1 if not open, the first open leads
+    int    slots[BENCH_NUM_COUNTERS]; // index in the group
+    int    group_fd;
+    int    num_open;
+    double start_ms;
+};
+
+// Time and counters accumulated over the samples of a phase.
+struct bench_sample {
+    double   ms;
+    uint64_t counts[BENCH_NUM_COUNTERS];
+};
+
+double bench_now_ms();
+
+void bench_counters_init(struct bench_counters *counters);
+void bench_counters_finish(struct bench_counters *counters);
+
+// Measure the time and counters between `begin` and `end`, and add them to
+// the sample.
+void bench_sample_begin(struct bench_counters *counters);
+void bench_sample_end(
+    struct bench_counters *counters, struct bench_sample *sample
+);
+
+// Print the counters of the sample divided by `iterations`, on one line
+// starting with `name`. Nothing is printed if no counter is open.
+void bench_sample_print_counters(
+    const char *name, struct bench_counters *counters,
+    struct bench_sample *sample, int iterations
+);
+
+// Set up the state of a half-screen window on an output of the given size,
+// with the guides from the README.
+void bench_state_init(struct state *state, int32_t width, int32_t height);
+void bench_state_finish(struct state *state);
+
+// Write a GET_TREE reply for an output of the given size, with a horizontal
+// workspace of `columns` vertical splits of `rows` windows each. The last
+// window is focused. The caller frees it.
+char *bench_tree(int32_t width, int32_t height, int columns, int rows);
+
+// Whole content of a file, NUL terminated, or NULL with an error logged.
+char *bench_read_file(const char *path);
+
+#endif
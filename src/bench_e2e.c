@@ -0,0 +1,103 @@
+#include "e2e.h"
+#include "log.h"
+
+#include <linux/input-event-codes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TIMEOUT_MS 5000
+
+struct bench_result {
+    double first_frame_ms;
+    double key_to_command_ms;
+    double buffer_mb;
+    double damage_mpx;
+};
+
+static bool _first_attach(struct e2e *e2e) {
+    return e2e->compositor.stats.attaches > 0;
+}
+
+static bool _command_received(struct e2e *e2e) {
+    return e2e->sway.num_commands > 0;
+}
+
+static int _bench_once(
+    const char *exe, int32_t width, int32_t height,
+    struct bench_result *result
+) {
+    char *args[] = {"-g", "a:h:25% b:h:75%", NULL};
+
+    struct e2e e2e;
+    if (e2e_start(&e2e, exe, args, width, height) != 0) {
+        return -1;
+    }
+
+    struct mock_compositor_stats *stats = &e2e.compositor.stats;
+    if (e2e_run_until(&e2e, _first_attach, TIMEOUT_MS) != 0) {
+        e2e_finish(&e2e, 0);
+        return -1;
+    }
+    result->first_frame_ms += (stats->first_attach_ns - e2e.start_ns) / 1e6;
+
+    uint64_t key_ns = mock_now_ns();
+    if (mock_compositor_press_key(&e2e.compositor, KEY_A) != 0 ||
+        e2e_run_until(&e2e, _command_received, TIMEOUT_MS) != 0) {
+        e2e_finish(&e2e, 0);
+        return -1;
+    }
+    result->key_to_command_ms += (e2e.sway.last_command_ns - key_ns) / 1e6;
+    result->buffer_mb         += stats->buffer_bytes / (1024. * 1024.);
+    result->damage_mpx        += stats->damage_area / 1e6;
+
+    return e2e_finish(&e2e, TIMEOUT_MS) == 0 ? 0 : -1;
+}
+
+/*
+ * Usage: bench_e2e SWAY_RESIZE [WIDTH HEIGHT [ITERATIONS]]
+ *
+ * Run sway-resize against the mock compositor and Sway, and measure the time
+ * from starting the process to its first buffer, and from a key press to the
+ * resize command, along with the buffer bytes and damage it sent.
+ */
+int main(int argc, char **argv) {
+    int32_t width      = 3840;
+    int32_t height     = 2160;
+    int     iterations = 10;
+
+    if (argc >= 4) {
+        width  = atoi(argv[2]);
+        height = atoi(argv[3]);
+    }
+    if (argc >= 5) {
+        iterations = atoi(argv[4]);
+    }
+
+    if (argc < 2 || width <= 0 || height <= 0 || iterations <= 0) {
+        LOG_ERR(
+            "Usage: %s SWAY_RESIZE [WIDTH HEIGHT [ITERATIONS]]",
+            argc > 0 ? argv[0] : "bench_e2e"
+        );
+        return 1;
+    }
+
+    printf("%dx%d output, %d iterations\n", width, height, iterations);
+
+    struct bench_result result = {0};
+    for (int i = 0; i < iterations; i++) {
+        if (_bench_once(argv[1], width, height, &result) != 0) {
+            LOG_ERR("Iteration %d failed.", i);
+            return 1;
+        }
+    }
+
+    printf(
+        "first frame %8.3f ms  key to command %8.3f ms  "
+        "%7.2f MiB attached  %7.2f Mpx damaged\n",
+        result.first_frame_ms / iterations,
+        result.key_to_command_ms / iterations, result.buffer_mb / iterations,
+        result.damage_mpx / iterations
+    );
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "bench.h"
+#include "json_tape.h"
+#include "log.h"
+#include "sway_win.h"
+
+#include <jansson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum parser {
+    PARSER_JANSSON,
+    PARSER_TAPE,
+    PARSER_TAPE_SCALAR,
+    NUM_PARSERS,
+};
+
+static const char *parser_names[NUM_PARSERS] = {
+    [PARSER_JANSSON]     = "jansson",
+    [PARSER_TAPE]        = "tape",
+    [PARSER_TAPE_SCALAR] = "tape (scalar)",
+};
+
+// Parse the tree, as done on each GET_TREE reply. The tape is kept from one
+// parse to the next, as `stream` does.
+static int _parse(
+    enum parser parser, struct json_tape *tape, const char *tree, size_t len
+) {
+    switch (parser) {
+    case PARSER_JANSSON: {
+        json_error_t error;
+        json_t      *json = json_loadb(tree, len, 0, &error);
+        if (json == NULL) {
+            LOG_ERR("Could not parse tree: %s", error.text);
+            return -1;
+        }
+        json_decref(json);
+        return 0;
+    }
+    case PARSER_TAPE:
+        return json_tape_parse(tape, tree, len);
+    case PARSER_TAPE_SCALAR:
+        return json_tape_parse_scalar(tape, tree, len);
+    default:
+        return -1;
+    }
+}
+
+static int _bench_parser(
+    enum parser parser, const char *tree, size_t len, int iterations,
+    struct bench_counters *counters
+) {
+    struct json_tape tape;
+    json_tape_init(&tape);
+
+    // Warm up the caches and the buffers of the tape.
+    int err = _parse(parser, &tape, tree, len);
+
+    struct bench_sample sample = {0};
+    for (int i = 0; i < iterations && err == 0; i++) {
+        bench_sample_begin(counters);
+        err = _parse(parser, &tape, tree, len);
+        bench_sample_end(counters, &sample);
+    }
+    json_tape_finish(&tape);
+    if (err) {
+        LOG_ERR("Could not parse tree with %s.", parser_names[parser]);
+        return -1;
+    }
+
+    double ms = sample.ms / iterations;
+    printf(
+        "%-20s %8.3f ms  %8.1f MB/s\n", parser_names[parser], ms,
+        len / ms / 1000
+    );
+    bench_sample_print_counters("", counters, &sample, iterations);
+    return 0;
+}
+
+// Walk of the tape by `find_focused_window`, to compare with the parse.
+static int _bench_find_focused_window(
+    const char *tree, size_t len, int iterations,
+    struct bench_counters *counters
+) {
+    struct json_tape tape;
+    json_tape_init(&tape);
+    if (json_tape_parse(&tape, tree, len) != 0) {
+        json_tape_finish(&tape);
+        return -1;
+    }
+
+    struct bench_sample sample = {0};
+    int                 err    = 0;
+    for (int i = 0; i < iterations && err == 0; i++) {
+        struct focused_window fw = {0};
+        bench_sample_begin(counters);
+        err = find_focused_window(&fw, json_tape_root(&tape));
+        bench_sample_end(counters, &sample);
+        free((void *)fw.output);
+    }
+    json_tape_finish(&tape);
+    if (err) {
+        LOG_ERR("Could not find focused window.");
+        return -1;
+    }
+
+    printf("%-20s %8.3f ms\n", "find_focused_window", sample.ms / iterations);
+    bench_sample_print_counters("", counters, &sample, iterations);
+    return 0;
+}
+
+/*
+ * Usage: bench_json [COLUMNS ROWS [ITERATIONS [TREE]]]
+ *
+ * Parse a GET_TREE reply with jansson and with the tape parser, with and
+ * without SIMD, and report the time per parse and the throughput. TREE is a
+ * recorded GET_TREE reply, else a tree of COLUMNS x ROWS windows is
+ * generated.
+ *
+ * With BENCH_COUNTERS set, the performance counters of each parser are
+ * printed too.
+ */
+int main(int argc, char **argv) {
+    int         columns    = 16;
+    int         rows       = 8;
+    int         iterations = 200;
+    const char *tree_path  = NULL;
+
+    if (argc >= 3) {
+        columns = atoi(argv[1]);
+        rows    = atoi(argv[2]);
+    }
+    if (argc >= 4) {
+        iterations = atoi(argv[3]);
+    }
+    if (argc >= 5) {
+        tree_path = argv[4];
+    }
+
+    if (columns <= 0 || rows <= 0 || iterations <= 0) {
+        LOG_ERR("Usage: %s [COLUMNS ROWS [ITERATIONS [TREE]]]", argv[0]);
+        return 1;
+    }
+
+    char *tree = tree_path != NULL ? bench_read_file(tree_path)
+                                   : bench_tree(3840, 2160, columns, rows);
+    if (tree == NULL) {
+        return 1;
+    }
+    size_t len = strlen(tree);
+
+    struct bench_counters counters;
+    bench_counters_init(&counters);
+
+    printf("%zu bytes, %d iterations\n", len, iterations);
+    int err = 0;
+    for (int i = 0; i < NUM_PARSERS && err == 0; i++) {
+        err = _bench_parser(i, tree, len, iterations, &counters);
+    }
+    if (err == 0) {
+        err = _bench_find_focused_window(tree, len, iterations, &counters);
+    }
+
+    bench_counters_finish(&counters);
+    free(tree);
+
+    return err == 0 ? 0 : 1;
+}
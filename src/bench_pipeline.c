@@ -0,0 +1,185 @@
+#include "bench.h"
+#include "json_tape.h"
+#include "log.h"
+#include "render.h"
+#include "resize_params.h"
+#include "shm.h"
+#include "sway_win.h"
+
+#include <cairo/cairo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Synthetic tree: columns of windows stacked vertically.
+#define TREE_COLUMNS 4
+#define TREE_ROWS    3
+
+enum phase {
+    PHASE_PARSE,
+    PHASE_FOCUS,
+    PHASE_GUIDES,
+    PHASE_ALLOC,
+    PHASE_RENDER,
+    NUM_PHASES,
+};
+
+static const char *phase_names[NUM_PHASES] = {
+    [PHASE_PARSE]  = "parse",
+    [PHASE_FOCUS]  = "focus",
+    [PHASE_GUIDES] = "guides",
+    [PHASE_ALLOC]  = "alloc",
+    [PHASE_RENDER] = "render",
+};
+
+static int _bench_iteration(
+    struct state *state, const char *tree, uint32_t width, uint32_t height,
+    double scale, struct bench_counters *counters, struct bench_sample *samples
+) {
+    struct focused_window *fw = &state->focused_window;
+
+    struct json_tape tape;
+    bench_sample_begin(counters);
+    json_tape_init(&tape);
+    int err = json_tape_parse(&tape, tree, strlen(tree));
+    bench_sample_end(counters, &samples[PHASE_PARSE]);
+    if (err) {
+        LOG_ERR("Could not parse tree at offset %zu.", tape.error_offset);
+        json_tape_finish(&tape);
+        return -1;
+    }
+
+    bench_sample_begin(counters);
+    err = find_focused_window(fw, json_tape_root(&tape));
+    bench_sample_end(counters, &samples[PHASE_FOCUS]);
+    json_tape_finish(&tape);
+    free((void *)fw->output);
+    fw->output = NULL;
+    if (err != 0) {
+        LOG_ERR("Could not find focused window.");
+        return -1;
+    }
+
+    bench_sample_begin(counters);
+    resize_parameters_compute_guides(state->resize_params, fw);
+    bench_sample_end(counters, &samples[PHASE_GUIDES]);
+
+    // Same buffer as the first frame of a live run, without a compositor.
+    const int stride =
+        cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+    struct shm_mapping mapping;
+    bench_sample_begin(counters);
+    if (shm_mapping_init(&mapping, (size_t)height * stride, SHM_PREFAULT) !=
+        0) {
+        LOG_ERR("Could not map shared memory.");
+        return -1;
+    }
+    shm_mapping_wait(&mapping);
+    cairo_surface_t *surface = cairo_image_surface_create_for_data(
+        mapping.data, CAIRO_FORMAT_ARGB32, width, height, stride
+    );
+    cairo_t *cairo = cairo_create(surface);
+    bench_sample_end(counters, &samples[PHASE_ALLOC]);
+
+    bench_sample_begin(counters);
+    cairo_scale(cairo, scale, scale);
+    render(state, cairo);
+    cairo_surface_flush(surface);
+    bench_sample_end(counters, &samples[PHASE_RENDER]);
+
+    cairo_destroy(cairo);
+    cairo_surface_destroy(surface);
+    shm_mapping_finish(&mapping);
+    return 0;
+}
+
+/*
+ * Usage: bench_pipeline [WIDTH HEIGHT SCALE [ITERATIONS [TREE]]]
+ *
+ * Go through the steps from the GET_TREE reply to the first frame on a
+ * single thread, and report the time spent in each: parsing the reply,
+ * finding the focused window, computing the guides, allocating the buffer
+ * and rendering into it. TREE is a recorded GET_TREE reply, else a tree of
+ * TREE_COLUMNS x TREE_ROWS windows is generated for the output size.
+ *
+ * With BENCH_COUNTERS set, the performance counters of each phase are
+ * printed too.
+ */
+int main(int argc, char **argv) {
+    int32_t     width      = 3840;
+    int32_t     height     = 2160;
+    double      scale      = 2;
+    int         iterations = 20;
+    const char *tree_path  = NULL;
+
+    if (argc >= 4) {
+        width  = atoi(argv[1]);
+        height = atoi(argv[2]);
+        scale  = atof(argv[3]);
+    }
+    if (argc >= 5) {
+        iterations = atoi(argv[4]);
+    }
+    if (argc >= 6) {
+        tree_path = argv[5];
+    }
+
+    if (width <= 0 || height <= 0 || scale <= 0 || iterations <= 0) {
+        LOG_ERR(
+            "Usage: %s [WIDTH HEIGHT SCALE [ITERATIONS [TREE]]]", argv[0]
+        );
+        return 1;
+    }
+
+    char *tree = tree_path != NULL
+                     ? bench_read_file(tree_path)
+                     : bench_tree(width, height, TREE_COLUMNS, TREE_ROWS);
+    if (tree == NULL) {
+        return 1;
+    }
+
+    struct state state;
+    bench_state_init(&state, width, height);
+
+    struct bench_counters counters;
+    bench_counters_init(&counters);
+
+    uint32_t buffer_width  = width * scale;
+    uint32_t buffer_height = height * scale;
+    printf(
+        "%ux%u buffer (%dx%d @ %.2f), %d iterations\n", buffer_width,
+        buffer_height, width, height, scale, iterations
+    );
+
+    struct bench_sample samples[NUM_PHASES] = {0};
+    int                 err                 = 0;
+    for (int i = 0; i < iterations && err == 0; i++) {
+        err = _bench_iteration(
+            &state, tree, buffer_width, buffer_height, scale, &counters,
+            samples
+        );
+    }
+
+    if (err == 0) {
+        double total = 0;
+        for (int i = 0; i < NUM_PHASES; i++) {
+            total += samples[i].ms;
+        }
+        for (int i = 0; i < NUM_PHASES; i++) {
+            printf(
+                "%-20s %8.3f ms  %5.1f%%\n", phase_names[i],
+                samples[i].ms / iterations, 100 * samples[i].ms / total
+            );
+            bench_sample_print_counters(
+                "", &counters, &samples[i], iterations
+            );
+        }
+        printf("%-20s %8.3f ms\n", "total", total / iterations);
+    }
+
+    bench_counters_finish(&counters);
+    bench_state_finish(&state);
+    free(tree);
+
+    return err == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include "bench.h"
+#include "log.h"
+#include "render_pool.h"
+#include "surface_buffer.h"
+
+#include <cairo/cairo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static double _bench_threads(
+    struct state *state, struct surface_buffer *buffer, double scale,
+    size_t num_threads, int iterations
+) {
+    struct render_pool pool;
+    render_pool_init(&pool, num_threads);
+
+    // Warm up the font cache and the tiles.
+    render_pool_render(&pool, state, buffer, scale, NULL);
+
+    double start = bench_now_ms();
+    for (int i = 0; i < iterations; i++) {
+        render_pool_render(&pool, state, buffer, scale, NULL);
+    }
+    double elapsed = bench_now_ms() - start;
+
+    render_pool_destroy(&pool);
+    surface_buffer_split_tiles(buffer, 0);
+
+    return elapsed / iterations;
+}
+
+/*
+ * Usage: bench_render [WIDTH HEIGHT SCALE [ITERATIONS]]
+ *
+ * Render the overlay of a half-screen window with the README guides into a
+ * buffer of the output size times the scale, for an increasing number of
+ * threads.
+ */
+int main(int argc, char **argv) {
+    int32_t width      = 3840;
+    int32_t height     = 2160;
+    double  scale      = 2;
+    int     iterations = 20;
+
+    if (argc >= 4) {
+        width  = atoi(argv[1]);
+        height = atoi(argv[2]);
+        scale  = atof(argv[3]);
+    }
+    if (argc >= 5) {
+        iterations = atoi(argv[4]);
+    }
+
+    if (width <= 0 || height <= 0 || scale <= 0 || iterations <= 0) {
+        LOG_ERR("Usage: %s [WIDTH HEIGHT SCALE [ITERATIONS]]", argv[0]);
+        return 1;
+    }
+
+    struct state state;
+    bench_state_init(&state, width, height);
+
+    struct surface_buffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.width         = width * scale;
+    buffer.height        = height * scale;
+    buffer.cairo_surface = cairo_image_surface_create(
+        CAIRO_FORMAT_ARGB32, buffer.width, buffer.height
+    );
+    buffer.cairo = cairo_create(buffer.cairo_surface);
+    buffer.data  = cairo_image_surface_get_data(buffer.cairo_surface);
+    buffer.state = SURFACE_BUFFER_READY;
+
+    long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+    printf(
+        "%ux%u buffer (%dx%d @ %.2f), %d iterations\n", buffer.width,
+        buffer.height, width, height, scale, iterations
+    );
+
+    double baseline = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        double ms =
+            _bench_threads(&state, &buffer, scale, threads, iterations);
+        if (threads == 1) {
+            baseline = ms;
+        }
+
+        printf(
+            "threads=%-3zu %8.3f ms/frame  speedup x%.2f\n", threads, ms,
+            baseline / ms
+        );
+    }
+
+    cairo_destroy(buffer.cairo);
+    cairo_surface_destroy(buffer.cairo_surface);
+    bench_state_finish(&state);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "bench.h"
+#include "log.h"
+#include "render.h"
+#include "shm.h"
+#include "utils.h"
+
+#include <cairo/cairo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+struct bench_result {
+    struct bench_sample map;
+    struct bench_sample first_frame;
+    double              faults;
+};
+
+static long _minor_faults() {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_minflt;
+}
+
+static void _sleep_ms(int ms) {
+    struct timespec ts = {
+        .tv_sec  = ms / 1000,
+        .tv_nsec = (ms % 1000) * 1000000L,
+    };
+    while (nanosleep(&ts, &ts) != 0) {}
+}
+
+static int _bench_flags(
+    struct state *state, struct bench_counters *counters, uint32_t width,
+    uint32_t height, double scale, uint32_t flags, int iterations, int gap_ms,
+    struct bench_result *result
+) {
+    const int stride =
+        cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+
+    *result = (struct bench_result){0};
+    for (int i = 0; i < iterations; i++) {
+        struct shm_mapping mapping;
+
+        bench_sample_begin(counters);
+        if (shm_mapping_init(&mapping, (size_t)height * stride, flags) != 0) {
+            LOG_ERR("Could not map shared memory.");
+            return -1;
+        }
+        bench_sample_end(counters, &result->map);
+
+        // Stands for the time spent waiting for the surface to be configured.
+        _sleep_ms(gap_ms);
+
+        long faults = _minor_faults();
+        bench_sample_begin(counters);
+
+        shm_mapping_wait(&mapping);
+        cairo_surface_t *surface = cairo_image_surface_create_for_data(
+            mapping.data, CAIRO_FORMAT_ARGB32, width, height, stride
+        );
+        cairo_t *cairo = cairo_create(surface);
+        cairo_scale(cairo, scale, scale);
+        render(state, cairo);
+        cairo_destroy(cairo);
+        cairo_surface_destroy(surface);
+
+        bench_sample_end(counters, &result->first_frame);
+        result->faults += _minor_faults() - faults;
+
+        shm_mapping_finish(&mapping);
+    }
+
+    result->faults /= iterations;
+    return 0;
+}
+
+/*
+ * Usage: bench_shm [WIDTH HEIGHT SCALE [ITERATIONS [GAP_MS]]]
+ *
+ * Render the first frame of the overlay into freshly mapped shared memory,
+ * with and without prefaulting and huge pages. GAP_MS is the time between
+ * mapping the memory and rendering, during which a prefault thread runs.
+ *
+ * With BENCH_COUNTERS set, the performance counters of both phases are
+ * printed too.
+ */
+int main(int argc, char **argv) {
+    int32_t width      = 3840;
+    int32_t height     = 2160;
+    double  scale      = 2;
+    int     iterations = 10;
+    int     gap_ms     = 5;
+
+    if (argc >= 4) {
+        width  = atoi(argv[1]);
+        height = atoi(argv[2]);
+        scale  = atof(argv[3]);
+    }
+    if (argc >= 5) {
+        iterations = atoi(argv[4]);
+    }
+    if (argc >= 6) {
+        gap_ms = atoi(argv[5]);
+    }
+
+    if (width <= 0 || height <= 0 || scale <= 0 || iterations <= 0 ||
+        gap_ms < 0) {
+        LOG_ERR(
+            "Usage: %s [WIDTH HEIGHT SCALE [ITERATIONS [GAP_MS]]]", argv[0]
+        );
+        return 1;
+    }
+
+    struct state state;
+    bench_state_init(&state, width, height);
+
+    struct bench_counters counters;
+    bench_counters_init(&counters);
+
+    uint32_t buffer_width  = width * scale;
+    uint32_t buffer_height = height * scale;
+    printf(
+        "%ux%u buffer (%dx%d @ %.2f), %d iterations, %d ms gap\n",
+        buffer_width, buffer_height, width, height, scale, iterations, gap_ms
+    );
+
+    static const struct {
+        const char *name;
+        uint32_t    flags;
+    } configs[] = {
+        {"plain", 0},
+        {"prefault", SHM_PREFAULT},
+        {"prefault-thread", SHM_PREFAULT_THREAD},
+        {"huge-pages", SHM_HUGE_PAGES},
+        {"prefault-thread+huge", SHM_PREFAULT_THREAD | SHM_HUGE_PAGES},
+    };
+
+    for (size_t i = 0; i < ARRAY_LEN(configs); i++) {
+        struct bench_result result;
+        if (_bench_flags(
+                &state, &counters, buffer_width, buffer_height, scale,
+                configs[i].flags, iterations, gap_ms, &result
+            ) != 0) {
+            bench_counters_finish(&counters);
+            bench_state_finish(&state);
+            return 1;
+        }
+
+        printf(
+            "%-20s map %7.3f ms  first frame %8.3f ms  %8.0f faults\n",
+            configs[i].name, result.map.ms / iterations,
+            result.first_frame.ms / iterations, result.faults
+        );
+        bench_sample_print_counters(
+            "  map", &counters, &result.map, iterations
+        );
+        bench_sample_print_counters(
+            "  first frame", &counters, &result.first_frame, iterations
+        );
+    }
+
+    bench_counters_finish(&counters);
+    bench_state_finish(&state);
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "e2e.h"
+
+#include "log.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Upper bound of the time spent in a single dispatch, so that the client
+// exiting is noticed.
+#define E2E_POLL_MS 5
+
+static void _exec_client(
+    struct e2e *e2e, const char *exe, char *const *args
+) {
+    setenv("WAYLAND_DISPLAY", e2e->compositor.socket, 1);
+    setenv("SWAYSOCK", e2e->sway.path, 1);
+    unsetenv("WAYLAND_SOCKET");
+
+    char *argv[32] = {(char *)exe};
+    for (int i = 0; args[i] != NULL && i + 2 < 32; i++) {
+        argv[i + 1] = args[i];
+    }
+
+    execv(exe, argv);
+    LOG_ERR("Could not run '%s'.", exe);
+    _exit(127);
+}
+
+int e2e_start(
+    struct e2e *e2e, const char *exe, char *const *args, int32_t width,
+    int32_t height
+) {
+    memset(e2e, 0, sizeof(struct e2e));
+    e2e->pid = -1;
+
+    // Wayland sockets live there.
+    if (getenv("XDG_RUNTIME_DIR") == NULL) {
+        e2e->runtime_dir = strdup("/tmp/sway-resize-e2e-XXXXXX");
+        if (mkdtemp(e2e->runtime_dir) == NULL) {
+            LOG_ERR("Could not create a runtime directory.");
+            free(e2e->runtime_dir);
+            e2e->runtime_dir = NULL;
+            return -1;
+        }
+        setenv("XDG_RUNTIME_DIR", e2e->runtime_dir, 1);
+    }
+
+    if (mock_compositor_init(&e2e->compositor, width, height) != 0) {
+        return -1;
+    }
+    if (mock_sway_init(
+            &e2e->sway, e2e->compositor.event_loop, width, height
+        ) != 0) {
+        mock_compositor_finish(&e2e->compositor);
+        return -1;
+    }
+
+    e2e->start_ns = mock_now_ns();
+    e2e->pid      = fork();
+    if (e2e->pid < 0) {
+        LOG_ERR("Could not fork.");
+        e2e_finish(e2e, 0);
+        return -1;
+    }
+    if (e2e->pid == 0) {
+        _exec_client(e2e, exe, args);
+    }
+
+    return 0;
+}
+
+static bool _reap(struct e2e *e2e, int options) {
+    if (e2e->exited || e2e->pid < 0) {
+        return true;
+    }
+
+    int status;
+    if (waitpid(e2e->pid, &status, options) != e2e->pid) {
+        return false;
+    }
+
+    e2e->exited = true;
+    e2e->status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    return true;
+}
+
+int e2e_run_until(struct e2e *e2e, e2e_done_t done, int timeout_ms) {
+    uint64_t deadline = mock_now_ns() + (uint64_t)timeout_ms * 1000000;
+
+    while (!done(e2e)) {
+        if (_reap(e2e, WNOHANG)) {
+            LOG_ERR("sway-resize exited with status %d.", e2e->status);
+            return -1;
+        }
+        if (mock_now_ns() > deadline) {
+            LOG_ERR("Timed out waiting for sway-resize.");
+            return -1;
+        }
+
+        mock_compositor_dispatch(&e2e->compositor, E2E_POLL_MS);
+    }
+
+    return 0;
+}
+
+int e2e_wait_exit(struct e2e *e2e, int timeout_ms) {
+    uint64_t deadline = mock_now_ns() + (uint64_t)timeout_ms * 1000000;
+
+    // The client may still need the mocks to exit.
+    while (!_reap(e2e, WNOHANG) && mock_now_ns() < deadline) {
+        mock_compositor_dispatch(&e2e->compositor, E2E_POLL_MS);
+    }
+    if (!_reap(e2e, WNOHANG)) {
+        LOG_ERR("sway-resize did not exit, killing it.");
+        kill(e2e->pid, SIGKILL);
+        _reap(e2e, 0);
+        e2e->status = -1;
+    }
+
+    return e2e->status;
+}
+
+int e2e_finish(struct e2e *e2e, int timeout_ms) {
+    e2e_wait_exit(e2e, timeout_ms);
+
+    mock_sway_finish(&e2e->sway);
+    mock_compositor_finish(&e2e->compositor);
+
+    if (e2e->runtime_dir != NULL) {
+        rmdir(e2e->runtime_dir);
+        unsetenv("XDG_RUNTIME_DIR");
+        free(e2e->runtime_dir);
+    }
+
+    return e2e->status;
+}
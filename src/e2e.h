@@ -0,0 +1,46 @@
+#ifndef __E2E_H_INCLUDED__
+#define __E2E_H_INCLUDED__
+
+#include "mock_compositor.h"
+#include "mock_sway.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * A sway-resize process running against the mock compositor and the mock
+ * Sway socket, both dispatched from the calling thread.
+ */
+struct e2e {
+    struct mock_compositor compositor;
+    struct mock_sway       sway;
+    pid_t                  pid;
+    bool                   exited;
+    int                    status;
+    uint64_t               start_ns;
+    char                  *runtime_dir; // created if none was set
+};
+
+typedef bool (*e2e_done_t)(struct e2e *e2e);
+
+// Start the mocks on an output of the given size and run `exe` with `args`,
+// NULL terminated and without argv[0].
+int e2e_start(
+    struct e2e *e2e, const char *exe, char *const *args, int32_t width,
+    int32_t height
+);
+
+// Dispatch the mocks until `done` returns true. Return non-zero if the client
+// exited or `timeout_ms` elapsed before.
+int e2e_run_until(struct e2e *e2e, e2e_done_t done, int timeout_ms);
+
+// Wait for the client to exit, killing it after `timeout_ms`, and keep the
+// mocks for inspection. Return the exit status of the client, -1 if it was
+// killed.
+int e2e_wait_exit(struct e2e *e2e, int timeout_ms);
+
+// Wait for the client to exit like e2e_wait_exit and stop the mocks.
+int e2e_finish(struct e2e *e2e, int timeout_ms);
+
+#endif
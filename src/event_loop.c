@@ -0,0 +1,141 @@
+#include "event_loop.h"
+
+#include "log.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+
+void event_loop_init(struct event_loop *loop, struct wl_display *wl_display) {
+    loop->wl_display  = wl_display;
+    loop->num_sources = 0;
+}
+
+int event_loop_add_fd(
+    struct event_loop *loop, int fd, short events,
+    event_loop_handler_t handler, void *data
+) {
+    if (loop->num_sources == EVENT_LOOP_MAX_SOURCES) {
+        LOG_ERR("Too many event loop sources.");
+        return -1;
+    }
+
+    loop->sources[loop->num_sources++] = (struct event_loop_source){
+        .fd      = fd,
+        .events  = events,
+        .handler = handler,
+        .data    = data,
+    };
+
+    return 0;
+}
+
+void event_loop_remove_fd(struct event_loop *loop, int fd) {
+    for (size_t i = 0; i < loop->num_sources; i++) {
+        if (loop->sources[i].fd == fd) {
+            loop->sources[i] = loop->sources[--loop->num_sources];
+            return;
+        }
+    }
+}
+
+void event_loop_set_events(struct event_loop *loop, int fd, short events) {
+    for (size_t i = 0; i < loop->num_sources; i++) {
+        if (loop->sources[i].fd == fd) {
+            loop->sources[i].events = events;
+            return;
+        }
+    }
+}
+
+// Poll ignores the negative fd that stands for the missing display.
+static int _prepare_display(struct wl_display *display, struct pollfd *pfd) {
+    *pfd = (struct pollfd){.fd = -1};
+    if (display == NULL) {
+        return 0;
+    }
+
+    while (wl_display_prepare_read(display) != 0) {
+        if (wl_display_dispatch_pending(display) < 0) {
+            return -1;
+        }
+    }
+
+    pfd->fd     = wl_display_get_fd(display);
+    pfd->events = POLLIN;
+
+    // Requests that do not fit in the socket buffer are sent once it becomes
+    // writable again.
+    if (wl_display_flush(display) < 0) {
+        if (errno != EAGAIN) {
+            wl_display_cancel_read(display);
+            return -1;
+        }
+        pfd->events |= POLLOUT;
+    }
+
+    return 0;
+}
+
+static int _dispatch_display(struct wl_display *display, short revents) {
+    if (display == NULL) {
+        return 0;
+    }
+
+    if (revents & (POLLIN | POLLERR | POLLHUP)) {
+        if (wl_display_read_events(display) < 0) {
+            return -1;
+        }
+    } else {
+        wl_display_cancel_read(display);
+    }
+
+    return wl_display_dispatch_pending(display) < 0 ? -1 : 0;
+}
+
+int event_loop_dispatch(struct event_loop *loop, int timeout) {
+    struct wl_display *display = loop->wl_display;
+
+    struct pollfd fds[EVENT_LOOP_MAX_SOURCES + 1];
+    if (_prepare_display(display, &fds[0]) != 0) {
+        return -1;
+    }
+
+    // About to wait, write the logs out while there is nothing else to do.
+    log_flush();
+
+    // Handlers may add or remove sources, dispatch from a snapshot.
+    struct event_loop_source sources[EVENT_LOOP_MAX_SOURCES];
+    size_t                   num_sources = loop->num_sources;
+    for (size_t i = 0; i < num_sources; i++) {
+        sources[i]         = loop->sources[i];
+        fds[i + 1].fd      = sources[i].fd;
+        fds[i + 1].events  = sources[i].events;
+        fds[i + 1].revents = 0;
+    }
+
+    int ret;
+    while ((ret = poll(fds, num_sources + 1, timeout)) < 0 && errno == EINTR) {
+    }
+    if (ret < 0) {
+        LOG_ERR("Could not poll event sources.");
+        if (display != NULL) {
+            wl_display_cancel_read(display);
+        }
+        return -1;
+    }
+
+    if (_dispatch_display(display, fds[0].revents) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < num_sources; i++) {
+        if (fds[i + 1].revents != 0) {
+            sources[i].handler(
+                sources[i].data, fds[i + 1].fd, fds[i + 1].revents
+            );
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef __EVENT_LOOP_H_INCLUDED__
+#define __EVENT_LOOP_H_INCLUDED__
+
+#include <stddef.h>
+#include <wayland-client.h>
+
+#define EVENT_LOOP_MAX_SOURCES 8
+
+typedef void (*event_loop_handler_t)(void *data, int fd, short revents);
+
+struct event_loop_source {
+    int                  fd;
+    short                events;
+    event_loop_handler_t handler;
+    void                *data;
+};
+
+/*
+ * Poll loop dispatching the Wayland display together with other file
+ * descriptors (worker notifications, IPC socket, timers). The display may be
+ * NULL when running without Wayland.
+ */
+struct event_loop {
+    struct wl_display       *wl_display;
+    struct event_loop_source sources[EVENT_LOOP_MAX_SOURCES];
+    size_t                   num_sources;
+};
+
+void event_loop_init(struct event_loop *loop, struct wl_display *wl_display);
+
+int event_loop_add_fd(
+    struct event_loop *loop, int fd, short events,
+    event_loop_handler_t handler, void *data
+);
+void event_loop_remove_fd(struct event_loop *loop, int fd);
+void event_loop_set_events(struct event_loop *loop, int fd, short events);
+
+// Flush the display, wait for events for at most `timeout` ms (-1 to wait
+// forever) and dispatch them. Return < 0 if the display connection failed.
+int event_loop_dispatch(struct event_loop *loop, int timeout);
+
+#endif
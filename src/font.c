@@ -0,0 +1,375 @@
+#include "font.h"
+
+#include "utils.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Glyphs are defined in a box of `FONT_UNITS` per em, `FONT_ADVANCE` wide,
+// with y going up from the baseline. Caps are 700 high, the x-height is 500
+// and descenders go down to -200.
+#define FONT_UNITS        1000.
+#define FONT_ADVANCE      600
+#define FONT_STROKE_WIDTH 95
+#define FONT_FIRST_GLYPH  ' '
+#define FONT_LAST_GLYPH   '~'
+#define FONT_MAX_ARGS     6
+
+// Each glyph is a list of strokes separated by ';'. A stroke is made of:
+//   M x y                 move to
+//   L x y                 line to
+//   A cx cy rx ry a0 a1   counterclockwise elliptic arc, angles in degrees
+//   R cx cy rx ry a0 a1   clockwise elliptic arc
+//   E cx cy rx ry         ellipse
+// Dots are zero length strokes drawn with round caps.
+static const char *const glyphs[] = {
+    // ' ' to '/'
+    "",
+    "M 300 700 L 300 200; M 300 20 L 300 0",
+    "M 220 700 L 220 520; M 380 700 L 380 520",
+    "M 230 650 L 190 50; M 410 650 L 370 50; M 110 450 L 500 450;"
+    "M 100 250 L 490 250",
+    "A 300 480 170 130 20 270 R 300 220 180 130 90 -160; M 300 720 L 300 -20",
+    "E 180 570 80 110; E 420 130 80 110; M 480 700 L 120 0",
+    "M 490 0 L 200 440 R 290 580 100 120 200 -30 L 130 200 "
+    "A 260 170 130 170 180 330 L 500 250",
+    "M 300 700 L 300 520",
+    "A 470 350 230 420 135 225",
+    "R 130 350 230 420 45 -45",
+    "M 300 650 L 300 250; M 130 550 L 470 350; M 470 550 L 130 350",
+    "M 300 550 L 300 150; M 100 350 L 500 350",
+    "M 320 80 L 250 -120",
+    "M 150 300 L 450 300",
+    "M 300 20 L 300 0",
+    "M 480 720 L 120 -80",
+
+    // '0' to '9'
+    "E 300 350 180 350; M 210 170 L 390 530",
+    "M 180 560 L 300 700 L 300 0; M 180 0 L 420 0",
+    "R 300 500 190 200 160 -40 L 110 0 L 500 0",
+    "R 300 530 180 170 150 -90 R 300 180 200 180 90 -150",
+    "M 420 0 L 420 700 L 100 220 L 500 220",
+    "M 460 700 L 150 700 L 130 400 R 290 220 200 220 125 -140",
+    "E 300 210 190 210; A 310 350 200 350 45 180 L 110 210",
+    "M 100 700 L 500 700 L 220 0",
+    "E 300 530 170 170; E 300 185 200 185",
+    "E 300 490 190 210; M 490 490 L 490 350 R 290 350 200 350 0 -135",
+
+    // ':' to '@'
+    "M 300 480 L 300 460; M 300 20 L 300 0",
+    "M 300 480 L 300 460; M 320 80 L 250 -120",
+    "M 480 600 L 120 350 L 480 100",
+    "M 120 450 L 480 450; M 120 250 L 480 250",
+    "M 120 600 L 480 350 L 120 100",
+    "R 300 530 180 170 160 -60 L 300 300 L 300 200; M 300 20 L 300 0",
+    "E 300 340 100 140; M 400 480 L 400 260 A 460 260 60 70 180 360 "
+    "L 520 350 A 310 350 210 340 0 300",
+
+    // 'A' to 'Z'
+    "M 100 0 L 300 700 L 500 0; M 165 230 L 435 230",
+    "M 120 0 L 120 700 L 330 700 R 330 530 150 170 90 -90 L 120 360;"
+    "M 340 360 R 340 180 160 180 90 -90 L 120 0",
+    "A 310 350 200 350 45 315",
+    "M 120 0 L 120 700 L 250 700 R 250 350 240 350 90 -90 L 120 0",
+    "M 470 700 L 120 700 L 120 0 L 470 0; M 120 360 L 400 360",
+    "M 470 700 L 120 700 L 120 0; M 120 360 L 400 360",
+    "A 310 350 200 350 40 340 L 500 330 L 330 330",
+    "M 120 0 L 120 700; M 480 0 L 480 700; M 120 360 L 480 360",
+    "M 180 700 L 420 700; M 300 700 L 300 0; M 180 0 L 420 0",
+    "M 220 700 L 460 700; M 400 700 L 400 200 R 260 200 140 200 0 -180",
+    "M 120 0 L 120 700; M 480 700 L 120 280; M 250 430 L 490 0",
+    "M 120 700 L 120 0 L 470 0",
+    "M 100 0 L 100 700 L 300 300 L 500 700 L 500 0",
+    "M 120 0 L 120 700 L 480 0 L 480 700",
+    "E 300 350 200 350",
+    "M 120 0 L 120 700 L 320 700 R 320 520 170 180 90 -90 L 120 340",
+    "E 300 350 200 350; M 330 160 L 500 -60",
+    "M 120 0 L 120 700 L 320 700 R 320 520 170 180 90 -90 L 120 340;"
+    "M 300 340 L 490 0",
+    "A 300 530 180 170 20 270 R 300 180 190 180 90 -160",
+    "M 100 700 L 500 700; M 300 700 L 300 0",
+    "M 120 700 L 120 220 A 300 220 180 220 180 360 L 480 700",
+    "M 100 700 L 300 0 L 500 700",
+    "M 80 700 L 190 0 L 300 450 L 410 0 L 520 700",
+    "M 110 700 L 490 0; M 490 700 L 110 0",
+    "M 100 700 L 300 350 L 500 700; M 300 350 L 300 0",
+    "M 110 700 L 490 700 L 110 0 L 490 0",
+
+    // '[' to '`'
+    "M 400 740 L 200 740 L 200 -80 L 400 -80",
+    "M 120 720 L 480 -80",
+    "M 200 740 L 400 740 L 400 -80 L 200 -80",
+    "M 140 450 L 300 700 L 460 450",
+    "M 80 -120 L 520 -120",
+    "M 220 720 L 340 580",
+
+    // 'a' to 'z'
+    "E 280 250 180 250; M 460 500 L 460 0",
+    "M 120 720 L 120 0; E 300 250 180 250",
+    "A 300 250 190 250 40 320",
+    "M 480 720 L 480 0; E 300 250 180 250",
+    "M 110 250 L 490 250 A 300 250 190 250 0 320",
+    "M 300 0 L 300 580 R 410 580 110 130 180 60; M 160 480 L 440 480",
+    "E 300 270 180 230; M 480 500 L 480 -50 R 300 -50 180 150 0 -160",
+    "M 120 720 L 120 0; M 120 300 R 300 300 180 200 180 0 L 480 0",
+    "M 300 500 L 300 0; M 300 660 L 300 680",
+    "M 360 500 L 360 -50 R 220 -50 140 150 0 -160; M 360 660 L 360 680",
+    "M 130 720 L 130 0; M 450 500 L 130 200; M 250 310 L 470 0",
+    "M 180 720 L 300 720 L 300 80 A 380 80 80 80 180 270 L 460 0",
+    "M 100 0 L 100 500; M 100 350 R 200 350 100 150 180 0 L 300 0;"
+    "M 300 350 R 400 350 100 150 180 0 L 500 0",
+    "M 120 0 L 120 500; M 120 300 R 300 300 180 200 180 0 L 480 0",
+    "E 300 250 190 250",
+    "M 120 500 L 120 -200; E 300 250 180 250",
+    "M 480 500 L 480 -200; E 300 250 180 250",
+    "M 150 0 L 150 500; M 150 300 R 340 300 190 200 180 30",
+    "A 300 380 160 120 20 270 R 300 130 170 130 90 -160",
+    "M 280 680 L 280 100 A 380 100 100 100 180 270 L 460 0;"
+    "M 140 500 L 440 500",
+    "M 120 500 L 120 200 A 300 200 180 200 180 360; M 480 500 L 480 0",
+    "M 110 500 L 300 0 L 490 500",
+    "M 80 500 L 190 0 L 300 350 L 410 0 L 520 500",
+    "M 120 500 L 480 0; M 480 500 L 120 0",
+    "M 110 500 L 300 0; M 490 500 L 224 -200",
+    "M 120 500 L 480 500 L 120 0 L 480 0",
+
+    // '{' to '~'
+    "M 420 740 L 330 740 L 300 710 L 300 400 L 200 330 L 300 260 L 300 -50 "
+    "L 330 -80 L 420 -80",
+    "M 300 760 L 300 -120",
+    "M 180 740 L 270 740 L 300 710 L 300 400 L 400 330 L 300 260 L 300 -50 "
+    "L 270 -80 L 180 -80",
+    "R 200 330 90 70 180 0 A 380 330 90 70 180 360",
+};
+
+_Static_assert(
+    ARRAY_LEN(glyphs) == FONT_LAST_GLYPH - FONT_FIRST_GLYPH + 1,
+    "missing glyphs"
+);
+
+// Drawn in place of symbols missing from the font.
+static const char *const tofu_glyph =
+    "M 100 0 L 100 700 L 500 700 L 500 0 L 100 0";
+
+bool font_has_glyph(uint32_t rune) {
+    return rune >= FONT_FIRST_GLYPH && rune <= FONT_LAST_GLYPH;
+}
+
+static const char *_get_glyph(uint32_t rune) {
+    return font_has_glyph(rune) ? glyphs[rune - FONT_FIRST_GLYPH] : tofu_glyph;
+}
+
+// Parse the next command of a glyph.
+// Return the number of arguments read, or < 0 at the end of the glyph.
+static int _next_command(const char **p, char *cmd, long *args) {
+    while (**p == ' ') {
+        (*p)++;
+    }
+    if (**p == '\0') {
+        return -1;
+    }
+
+    *cmd = *(*p)++;
+    if (*cmd == ';') {
+        return 0;
+    }
+
+    int num_args = 0;
+    while (num_args < FONT_MAX_ARGS) {
+        char *end;
+        long  arg = strtol(*p, &end, 10);
+        if (end == *p) {
+            break;
+        }
+        args[num_args++] = arg;
+        *p               = end;
+    }
+
+    return num_args;
+}
+
+static void _glyph_bounds(const char *glyph, long *bottom, long *top) {
+    char cmd;
+    long args[FONT_MAX_ARGS];
+    int  num_args;
+
+    *bottom = 0;
+    *top    = 0;
+    while ((num_args = _next_command(&glyph, &cmd, args)) >= 0) {
+        long y_min, y_max;
+        if (num_args == 2) {
+            y_min = y_max = args[1];
+        } else if (num_args >= 4) {
+            y_min = args[1] - args[3];
+            y_max = args[1] + args[3];
+        } else {
+            continue;
+        }
+        *bottom = min(*bottom, y_min);
+        *top    = max(*top, y_max);
+    }
+}
+
+static void _arc(cairo_t *cairo, long *args, bool negative) {
+    if (args[2] == 0 || args[3] == 0) {
+        return;
+    }
+
+    cairo_matrix_t matrix;
+    cairo_get_matrix(cairo, &matrix);
+    cairo_translate(cairo, args[0], args[1]);
+    cairo_scale(cairo, args[2], args[3]);
+    if (negative) {
+        cairo_arc_negative(
+            cairo, 0, 0, 1, args[4] * M_PI / 180, args[5] * M_PI / 180
+        );
+    } else {
+        cairo_arc(cairo, 0, 0, 1, args[4] * M_PI / 180, args[5] * M_PI / 180);
+    }
+    cairo_set_matrix(cairo, &matrix);
+}
+
+static void _glyph_path(cairo_t *cairo, const char *glyph) {
+    char cmd;
+    long args[FONT_MAX_ARGS];
+    int  num_args;
+
+    cairo_new_sub_path(cairo);
+    while ((num_args = _next_command(&glyph, &cmd, args)) >= 0) {
+        switch (cmd) {
+        case ';':
+            cairo_new_sub_path(cairo);
+            break;
+        case 'M':
+            if (num_args == 2) {
+                cairo_move_to(cairo, args[0], args[1]);
+            }
+            break;
+        case 'L':
+            if (num_args == 2) {
+                cairo_line_to(cairo, args[0], args[1]);
+            }
+            break;
+        case 'A':
+        case 'R':
+            if (num_args == 6) {
+                _arc(cairo, args, cmd == 'R');
+            }
+            break;
+        case 'E':
+            if (num_args == 4) {
+                args[4] = 0;
+                args[5] = 360;
+                cairo_new_sub_path(cairo);
+                _arc(cairo, args, false);
+                cairo_close_path(cairo);
+            }
+            break;
+        }
+    }
+}
+
+static void _select_system_font(cairo_t *cairo, double size) {
+    cairo_select_font_face(
+        cairo, "monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL
+    );
+    cairo_set_font_size(cairo, size);
+}
+
+void font_text_extents(
+    cairo_t *cairo, char *text, double size, bool system_font,
+    cairo_text_extents_t *extents
+) {
+    double scale  = size / FONT_UNITS;
+    double bottom = 0;
+    double top    = 0;
+    double x      = 0;
+
+    uint32_t rune;
+    int      len;
+    for (char *p = text; *p != '\0'; p += len) {
+        len = str_to_rune(p, &rune);
+        if (len <= 0) {
+            break;
+        }
+
+        if (system_font && !font_has_glyph(rune)) {
+            char str[5] = {0};
+            memcpy(str, p, min(len, 4));
+
+            cairo_text_extents_t te;
+            cairo_save(cairo);
+            _select_system_font(cairo, size);
+            cairo_text_extents(cairo, str, &te);
+            cairo_restore(cairo);
+
+            bottom  = fmax(bottom, te.y_bearing + te.height);
+            top     = fmax(top, -te.y_bearing);
+            x      += te.x_advance;
+            continue;
+        }
+
+        long glyph_bottom, glyph_top;
+        _glyph_bounds(_get_glyph(rune), &glyph_bottom, &glyph_top);
+        bottom  = fmax(bottom, -glyph_bottom * scale);
+        top     = fmax(top, glyph_top * scale);
+        x      += FONT_ADVANCE * scale;
+    }
+
+    extents->x_bearing = 0;
+    extents->y_bearing = -top;
+    extents->width     = x;
+    extents->height    = top + bottom;
+    extents->x_advance = x;
+    extents->y_advance = 0;
+}
+
+void font_show_text(
+    cairo_t *cairo, double x, double y, char *text, double size,
+    bool system_font
+) {
+    double scale = size / FONT_UNITS;
+
+    cairo_save(cairo);
+    cairo_new_path(cairo);
+
+    uint32_t rune;
+    int      len;
+    for (char *p = text; *p != '\0'; p += len) {
+        len = str_to_rune(p, &rune);
+        if (len <= 0) {
+            break;
+        }
+
+        if (system_font && !font_has_glyph(rune)) {
+            char str[5] = {0};
+            memcpy(str, p, min(len, 4));
+
+            cairo_text_extents_t te;
+            cairo_save(cairo);
+            _select_system_font(cairo, size);
+            cairo_text_extents(cairo, str, &te);
+            cairo_move_to(cairo, x, y);
+            cairo_show_text(cairo, str);
+            cairo_restore(cairo);
+
+            x += te.x_advance;
+            continue;
+        }
+
+        cairo_save(cairo);
+        cairo_translate(cairo, x, y);
+        cairo_scale(cairo, scale, -scale);
+        _glyph_path(cairo, _get_glyph(rune));
+        cairo_restore(cairo);
+
+        x += FONT_ADVANCE * scale;
+    }
+
+    cairo_set_line_width(cairo, FONT_STROKE_WIDTH * scale);
+    cairo_set_line_cap(cairo, CAIRO_LINE_CAP_ROUND);
+    cairo_set_line_join(cairo, CAIRO_LINE_JOIN_ROUND);
+    cairo_stroke(cairo);
+    cairo_restore(cairo);
+}
@@ -0,0 +1,30 @@
+#ifndef __FONT_H_INCLUDED__
+#define __FONT_H_INCLUDED__
+
+#include <cairo/cairo.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Label font compiled into the binary.
+ *
+ * Glyphs are drawn as cairo strokes, which avoids initializing fontconfig
+ * and loading a font through freetype. Symbols missing from the embedded
+ * font are drawn as a box, or with the system monospace font when
+ * `system_font` is set.
+ */
+
+bool font_has_glyph(uint32_t rune);
+
+void font_text_extents(
+    cairo_t *cairo, char *text, double size, bool system_font,
+    cairo_text_extents_t *extents
+);
+
+// Draw `text` with its baseline origin at (x, y).
+void font_show_text(
+    cairo_t *cairo, double x, double y, char *text, double size,
+    bool system_font
+);
+
+#endif
@@ -0,0 +1,164 @@
+#include "frame.h"
+
+#include "live.h"
+#include "pointer.h"
+#include "preview.h"
+#include "render.h"
+#include "render_thread.h"
+#include "surface_buffer.h"
+#include "trace.h"
+#include "viewporter-client-protocol.h"
+
+#include <math.h>
+#include <wayland-client.h>
+
+// Record what changed since the previous frame in every buffer, each buffer
+// has to catch up with all the frames drawn into the other one.
+static void _add_damage(struct state *state) {
+    struct rect extent = render_extent(state);
+    struct rect damage = rect_union(state->drawn_extent, extent);
+    state->drawn_extent = extent;
+
+    for (size_t i = 0; i < 2; i++) {
+        struct surface_buffer *buffer = &state->surface_buffer_pool.buffers[i];
+        buffer->damage = rect_union(buffer->damage, damage);
+    }
+}
+
+// Convert a rectangle in surface coordinates to the buffer pixels it covers.
+static struct rect _to_buffer_rect(struct rect rect, double scale) {
+    int32_t x0 = floor(rect.x * scale);
+    int32_t y0 = floor(rect.y * scale);
+    int32_t x1 = ceil((rect.x + rect.w) * scale);
+    int32_t y1 = ceil((rect.y + rect.h) * scale);
+    return (struct rect){.x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0};
+}
+
+void send_frame(struct state *state) {
+    // The frame being rendered is committed first, this one is sent then.
+    if (render_thread_busy(&state->render_thread)) {
+        state->frame_pending = true;
+        return;
+    }
+    state->frame_pending = false;
+
+    int32_t scale_120 = state->scale_120;
+    if (scale_120 == 0) {
+        // Falling back to the output scale if fractional scale is not received.
+        scale_120 =
+            (state->current_output == NULL ? 1 : state->current_output->scale) *
+            120;
+    }
+
+    struct surface_buffer *surface_buffer = get_next_buffer(
+        state->wl_shm, &state->surface_buffer_pool,
+        state->surface_width * scale_120 / 120,
+        state->surface_height * scale_120 / 120
+    );
+    if (surface_buffer == NULL) {
+        return;
+    }
+    surface_buffer->state = SURFACE_BUFFER_BUSY;
+
+    _add_damage(state);
+
+    double      scale = scale_120 / 120.0;
+    bool        full  = surface_buffer->full_damage;
+    struct rect damage =
+        full ? (struct rect){0, 0, state->surface_width, state->surface_height}
+             : surface_buffer->damage;
+    struct rect clip = _to_buffer_rect(damage, scale);
+
+    struct rect window = _to_buffer_rect(state->focused_window.rect, scale);
+    preview_update(
+        &state->preview, state->focused_window.id, window.w, window.h
+    );
+
+    surface_buffer->damage      = (struct rect){0};
+    surface_buffer->full_damage = false;
+
+    if (render_thread_submit(
+            &state->render_thread, state, surface_buffer, scale,
+            full ? NULL : &clip, damage
+        ) != 0) {
+        surface_buffer->state       = SURFACE_BUFFER_READY;
+        surface_buffer->full_damage = true;
+    }
+}
+
+void commit_frame(struct state *state) {
+    struct rect            damage;
+    struct surface_buffer *surface_buffer =
+        render_thread_take(&state->render_thread, &damage);
+    if (surface_buffer == NULL) {
+        return;
+    }
+
+    // The overlay was unmapped while the frame was rendered.
+    if (!state->running) {
+        surface_buffer->state = SURFACE_BUFFER_READY;
+        return;
+    }
+
+    wl_surface_set_buffer_scale(state->wl_surface, 1);
+
+    wl_surface_attach(state->wl_surface, surface_buffer->wl_buffer, 0, 0);
+    wp_viewport_set_destination(
+        state->wp_viewport, state->surface_width, state->surface_height
+    );
+    wl_surface_damage(
+        state->wl_surface, damage.x, damage.y, damage.w, damage.h
+    );
+    latency_commit(&state->latency, state->wl_surface);
+    wl_surface_commit(state->wl_surface);
+    trace_instant("commit");
+
+    if (state->frame_pending) {
+        send_frame(state);
+    }
+}
+
+static void surface_callback_done(
+    void *data, struct wl_callback *callback, uint32_t callback_data
+) {
+    struct state *state = data;
+    pointer_update_drag(state);
+    live_send_pending(state);
+    send_frame(state);
+
+    wl_callback_destroy(state->wl_surface_callback);
+    state->wl_surface_callback = NULL;
+}
+
+static const struct wl_callback_listener surface_callback_listener = {
+    .done = surface_callback_done,
+};
+
+void request_frame(struct state *state) {
+    latency_frame_requested(&state->latency);
+    if (state->wl_surface_callback != NULL) {
+        return;
+    }
+
+    state->wl_surface_callback = wl_surface_frame(state->wl_surface);
+    wl_callback_add_listener(
+        state->wl_surface_callback, &surface_callback_listener, state
+    );
+    wl_surface_commit(state->wl_surface);
+}
+
+void unmap_surface(struct state *state) {
+    if (state->wl_surface == NULL) {
+        return;
+    }
+
+    if (state->wl_surface_callback != NULL) {
+        wl_callback_destroy(state->wl_surface_callback);
+        state->wl_surface_callback = NULL;
+    }
+
+    wl_surface_attach(state->wl_surface, NULL, 0, 0);
+    wl_surface_commit(state->wl_surface);
+    wl_display_flush(state->wl_display);
+    trace_instant("unmap");
+}
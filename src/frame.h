@@ -0,0 +1,20 @@
+#ifndef __FRAME_H_INCLUDED__
+#define __FRAME_H_INCLUDED__
+
+#include "state.h"
+
+// Hand the state over to the render thread with the next free buffer. If a
+// frame is being rendered, this one is sent once it is committed.
+void send_frame(struct state *state);
+
+// Commit the frame done by the render thread, when its eventfd is readable.
+void commit_frame(struct state *state);
+
+// Ask for a new frame to be rendered on the next frame callback.
+void request_frame(struct state *state);
+
+// Unmap the surface with a null buffer and flush, dropping any requested
+// frame.
+void unmap_surface(struct state *state);
+
+#endif
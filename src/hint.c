@@ -0,0 +1,111 @@
+#include "hint.h"
+
+#include "log.h"
+#include "resize_params.h"
+#include "state.h"
+
+#include <string.h>
+
+void hint_init(struct hint_mode *hint, bool enabled) {
+    memset(hint, 0, sizeof(struct hint_mode));
+    hint->enabled = enabled;
+    hint->prefix  = -1;
+}
+
+void hint_start(struct state *state) {
+    struct hint_mode *hint = &state->hint;
+    if (!hint->enabled || hint->visible.count < 2) {
+        return;
+    }
+
+    hint->picking   = true;
+    hint->label_len = hint->visible.count <= HINT_ALPHABET_LEN ? 1 : 2;
+    if (hint->visible.count > HINT_ALPHABET_LEN * HINT_ALPHABET_LEN) {
+        LOG_WARN(
+            "Only %d of %d windows are labeled.",
+            HINT_ALPHABET_LEN * HINT_ALPHABET_LEN, hint->visible.count
+        );
+    }
+}
+
+bool hint_label(struct hint_mode *hint, int i, char label[3]) {
+    if (hint->label_len == 1) {
+        label[0] = HINT_ALPHABET[i];
+        label[1] = '\0';
+        return true;
+    }
+
+    if (i >= HINT_ALPHABET_LEN * HINT_ALPHABET_LEN) {
+        return false;
+    }
+
+    label[0] = HINT_ALPHABET[i / HINT_ALPHABET_LEN];
+    label[1] = HINT_ALPHABET[i % HINT_ALPHABET_LEN];
+    label[2] = '\0';
+    return true;
+}
+
+bool hint_matches(struct hint_mode *hint, int i) {
+    return hint->prefix < 0 || i / HINT_ALPHABET_LEN == hint->prefix;
+}
+
+static void _pick(struct state *state, int i) {
+    struct hint_mode *hint   = &state->hint;
+    const char       *output = state->focused_window.output;
+
+    state->focused_window        = hint->visible.windows[i];
+    state->focused_window.output = output;
+    hint->picking                = false;
+
+    resize_parameters_compute_guides(
+        state->resize_params, &state->focused_window
+    );
+}
+
+bool hint_handle_rune(struct state *state, uint32_t rune) {
+    struct hint_mode *hint   = &state->hint;
+    const char       *letter = NULL;
+    if (rune != 0 && rune < 128) {
+        letter = strchr(HINT_ALPHABET, rune);
+    }
+    if (letter == NULL) {
+        return false;
+    }
+
+    int index = letter - HINT_ALPHABET;
+    if (hint->label_len == 2 && hint->prefix < 0) {
+        hint->prefix = index;
+        return true;
+    }
+
+    int i = hint->label_len == 2 ? hint->prefix * HINT_ALPHABET_LEN + index
+                                 : index;
+    if (i >= hint->visible.count) {
+        // Start over on a label that doesn't exist.
+        hint->prefix = -1;
+        return true;
+    }
+
+    _pick(state, i);
+    return true;
+}
+
+bool hint_pick_at(struct state *state, double x, double y) {
+    struct visible_windows *visible = &state->hint.visible;
+
+    // Floating windows come last and are drawn over the tiled ones.
+    for (int i = visible->count - 1; i >= 0; i--) {
+        struct rect *rect = &visible->windows[i].rect;
+        if (x >= rect->x && x < rect->x + rect->w && y >= rect->y &&
+            y < rect->y + rect->h) {
+            _pick(state, i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void hint_finish(struct hint_mode *hint) {
+    visible_windows_finish(&hint->visible);
+}
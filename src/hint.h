@@ -0,0 +1,55 @@
+#ifndef __HINT_H_INCLUDED__
+#define __HINT_H_INCLUDED__
+
+#include "sway_win.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct state;
+
+// Letters of the labels, home row first.
+#define HINT_ALPHABET     "asdfghjklqwertyuiopzxcvbnm"
+#define HINT_ALPHABET_LEN 26
+
+/*
+ * Hint mode labels every window shown on the workspace of the focused
+ * window, and the guides are drawn for the window picked with its label or
+ * the pointer instead of the focused one.
+ *
+ * The windows are collected in the same walk of the tree as the focused
+ * window. Labels are one letter, or two when there are more windows than
+ * letters. Guides are only computed once a window is picked.
+ */
+struct hint_mode {
+    bool                   enabled;
+    bool                   picking; // labels are shown, no window picked yet
+    struct visible_windows visible;
+    int                    label_len;
+    int                    prefix; // first letter typed, -1 if none
+};
+
+void hint_init(struct hint_mode *hint, bool enabled);
+
+// Show the labels if there is more than one window to pick from.
+void hint_start(struct state *state);
+
+// Write the label of the visible window `i` to `label`. Return false if the
+// window has no label.
+bool hint_label(struct hint_mode *hint, int i, char label[3]);
+
+// Whether the label of the visible window `i` starts with the letter typed
+// so far.
+bool hint_matches(struct hint_mode *hint, int i);
+
+// Handle a key typed while picking. Return whether the overlay needs to be
+// redrawn.
+bool hint_handle_rune(struct state *state, uint32_t rune);
+
+// Pick the window under the position, in surface coordinates. Return whether
+// a window was picked.
+bool hint_pick_at(struct state *state, double x, double y);
+
+void hint_finish(struct hint_mode *hint);
+
+#endif
@@ -0,0 +1,284 @@
+#include "image_scale.h"
+
+#include "log.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define WEIGHT_BITS 8
+#define WEIGHT_ONE  (1 << WEIGHT_BITS)
+#define WEIGHT_HALF (1 << (WEIGHT_BITS - 1))
+
+// Source position of a destination column or row.
+struct sample {
+    int32_t  i0;
+    int32_t  i1;
+    uint16_t weight; // of i1, in 1/WEIGHT_ONE
+};
+
+static uint8_t *_row(const struct image *image, int32_t y) {
+    return image->data + (ptrdiff_t)y * image->stride;
+}
+
+struct image image_flipped(const struct image *image) {
+    return (struct image){
+        .data   = _row(image, image->height - 1),
+        .width  = image->width,
+        .height = image->height,
+        .stride = -image->stride,
+    };
+}
+
+static void _halve_row_scalar(
+    const uint8_t *top, const uint8_t *bottom, uint8_t *dst, int32_t from,
+    int32_t width
+) {
+    for (int32_t x = from; x < width; x++) {
+        for (int c = 0; c < 4; c++) {
+            dst[4 * x + c] = (top[8 * x + c] + top[8 * x + 4 + c] +
+                              bottom[8 * x + c] + bottom[8 * x + 4 + c] + 2) >>
+                             2;
+        }
+    }
+}
+
+static void _lerp_row_scalar(
+    const uint8_t *top, const uint8_t *bottom, uint8_t *dst,
+    const struct sample *xs, int32_t from, int32_t width, uint16_t wy
+) {
+    for (int32_t x = from; x < width; x++) {
+        const uint8_t *t0 = top + 4 * xs[x].i0;
+        const uint8_t *t1 = top + 4 * xs[x].i1;
+        const uint8_t *b0 = bottom + 4 * xs[x].i0;
+        const uint8_t *b1 = bottom + 4 * xs[x].i1;
+        uint16_t       wx = xs[x].weight;
+
+        for (int c = 0; c < 4; c++) {
+            uint32_t t = (t0[c] * (WEIGHT_ONE - wx) + t1[c] * wx +
+                          WEIGHT_HALF) >>
+                         WEIGHT_BITS;
+            uint32_t b = (b0[c] * (WEIGHT_ONE - wx) + b1[c] * wx +
+                          WEIGHT_HALF) >>
+                         WEIGHT_BITS;
+            dst[4 * x + c] =
+                (t * (WEIGHT_ONE - wy) + b * wy + WEIGHT_HALF) >> WEIGHT_BITS;
+        }
+    }
+}
+
+#ifdef __SSE2__
+
+// Channels of two pixels, widened to 16 bit.
+static __m128i _load_pixels(const uint8_t *a, const uint8_t *b) {
+    uint32_t pa, pb;
+    memcpy(&pa, a, 4);
+    memcpy(&pb, b, 4);
+    return _mm_unpacklo_epi8(
+        _mm_set_epi32(0, 0, pb, pa), _mm_setzero_si128()
+    );
+}
+
+// (a * (1 - w) + b * w) per 16 bit channel. The sum can't overflow as the
+// weights add up to WEIGHT_ONE.
+static __m128i _lerp(__m128i a, __m128i b, __m128i w) {
+    __m128i w_inv = _mm_sub_epi16(_mm_set1_epi16(WEIGHT_ONE), w);
+    __m128i sum =
+        _mm_add_epi16(_mm_mullo_epi16(a, w_inv), _mm_mullo_epi16(b, w));
+    return _mm_srli_epi16(
+        _mm_add_epi16(sum, _mm_set1_epi16(WEIGHT_HALF)), WEIGHT_BITS
+    );
+}
+
+// Two destination pixels per iteration, from four source pixels per row.
+static int32_t _halve_row_sse2(
+    const uint8_t *top, const uint8_t *bottom, uint8_t *dst, int32_t width
+) {
+    const __m128i zero = _mm_setzero_si128();
+    int32_t       x    = 0;
+    for (; x + 2 <= width; x += 2) {
+        __m128i t = _mm_loadu_si128((const __m128i *)(top + 8 * x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(bottom + 8 * x));
+
+        // Vertical sums of the first two and last two source pixels.
+        __m128i lo = _mm_add_epi16(
+            _mm_unpacklo_epi8(t, zero), _mm_unpacklo_epi8(b, zero)
+        );
+        __m128i hi = _mm_add_epi16(
+            _mm_unpackhi_epi8(t, zero), _mm_unpackhi_epi8(b, zero)
+        );
+
+        // Add the horizontal neighbours, found in the other 64 bit half.
+        lo = _mm_add_epi16(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+        hi = _mm_add_epi16(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        __m128i sum = _mm_unpacklo_epi64(lo, hi);
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+        _mm_storel_epi64(
+            (__m128i *)(dst + 4 * x), _mm_packus_epi16(sum, zero)
+        );
+    }
+
+    return x;
+}
+
+static int32_t _lerp_row_sse2(
+    const uint8_t *top, const uint8_t *bottom, uint8_t *dst,
+    const struct sample *xs, int32_t width, uint16_t wy
+) {
+    const __m128i wy_v = _mm_set1_epi16(wy);
+    int32_t       x    = 0;
+    for (; x + 2 <= width; x += 2) {
+        const struct sample *a = &xs[x];
+        const struct sample *b = &xs[x + 1];
+
+        __m128i wx = _mm_set_epi16(
+            b->weight, b->weight, b->weight, b->weight, a->weight, a->weight,
+            a->weight, a->weight
+        );
+
+        __m128i t = _lerp(
+            _load_pixels(top + 4 * a->i0, top + 4 * b->i0),
+            _load_pixels(top + 4 * a->i1, top + 4 * b->i1), wx
+        );
+        __m128i bt = _lerp(
+            _load_pixels(bottom + 4 * a->i0, bottom + 4 * b->i0),
+            _load_pixels(bottom + 4 * a->i1, bottom + 4 * b->i1), wx
+        );
+
+        __m128i out = _lerp(t, bt, wy_v);
+        _mm_storel_epi64(
+            (__m128i *)(dst + 4 * x), _mm_packus_epi16(out, out)
+        );
+    }
+
+    return x;
+}
+
+#endif
+
+static void _halve(const struct image *src, struct image *dst, bool simd) {
+    for (int32_t y = 0; y < dst->height; y++) {
+        const uint8_t *top    = _row(src, 2 * y);
+        const uint8_t *bottom = _row(src, 2 * y + 1);
+        uint8_t       *out    = _row(dst, y);
+
+        int32_t done = 0;
+#ifdef __SSE2__
+        if (simd) {
+            done = _halve_row_sse2(top, bottom, out, dst->width);
+        }
+#endif
+        _halve_row_scalar(top, bottom, out, done, dst->width);
+    }
+}
+
+// Sample centers are aligned, so that the edges of both images match.
+static void _compute_samples(
+    struct sample *samples, int32_t src_len, int32_t dst_len
+) {
+    for (int32_t i = 0; i < dst_len; i++) {
+        int64_t pos = ((int64_t)(2 * i + 1) * src_len << WEIGHT_BITS) /
+                          (2 * dst_len) -
+                      WEIGHT_HALF;
+        if (pos < 0) {
+            pos = 0;
+        }
+
+        samples[i].i0     = pos >> WEIGHT_BITS;
+        samples[i].weight = pos & (WEIGHT_ONE - 1);
+        if (samples[i].i0 >= src_len - 1) {
+            samples[i].i0     = src_len - 1;
+            samples[i].weight = 0;
+        }
+        samples[i].i1 = samples[i].i0 + (samples[i].weight != 0);
+    }
+}
+
+static int _bilinear(const struct image *src, struct image *dst, bool simd) {
+    struct sample *samples =
+        malloc((dst->width + dst->height) * sizeof(struct sample));
+    if (samples == NULL) {
+        return -1;
+    }
+
+    struct sample *xs = samples;
+    struct sample *ys = samples + dst->width;
+    _compute_samples(xs, src->width, dst->width);
+    _compute_samples(ys, src->height, dst->height);
+
+    for (int32_t y = 0; y < dst->height; y++) {
+        const uint8_t *top    = _row(src, ys[y].i0);
+        const uint8_t *bottom = _row(src, ys[y].i1);
+        uint8_t       *out    = _row(dst, y);
+
+        int32_t done = 0;
+#ifdef __SSE2__
+        if (simd) {
+            done = _lerp_row_sse2(
+                top, bottom, out, xs, dst->width, ys[y].weight
+            );
+        }
+#endif
+        _lerp_row_scalar(
+            top, bottom, out, xs, done, dst->width, ys[y].weight
+        );
+    }
+
+    free(samples);
+    return 0;
+}
+
+static int _scale(const struct image *src, struct image *dst, bool simd) {
+    if (dst->width <= 0 || dst->height <= 0) {
+        return 0;
+    }
+    if (src->width <= 0 || src->height <= 0) {
+        return -1;
+    }
+
+    bool halve = src->width >= 2 * dst->width && src->height >= 2 * dst->height;
+    if (!halve) {
+        return _bilinear(src, dst, simd);
+    }
+
+    // Halving levels alternate between the two parts of the scratch buffer,
+    // each level is at most a quarter of the first one.
+    size_t first_size = (size_t)(src->width / 2) * (src->height / 2) * 4;
+    uint8_t *scratch  = malloc(first_size + first_size / 4 + 4);
+    if (scratch == NULL) {
+        LOG_ERR("Could not allocate image scaling buffer.");
+        return -1;
+    }
+
+    struct image current = *src;
+    int          level   = 0;
+    while (current.width >= 2 * dst->width &&
+           current.height >= 2 * dst->height) {
+        struct image half = {
+            .data   = level % 2 == 0 ? scratch : scratch + first_size,
+            .width  = current.width / 2,
+            .height = current.height / 2,
+            .stride = current.width / 2 * 4,
+        };
+        _halve(&current, &half, simd);
+        current = half;
+        level++;
+    }
+
+    int err = _bilinear(&current, dst, simd);
+    free(scratch);
+    return err;
+}
+
+int image_scale(const struct image *src, struct image *dst) {
+    return _scale(src, dst, true);
+}
+
+int image_scale_scalar(const struct image *src, struct image *dst) {
+    return _scale(src, dst, false);
+}
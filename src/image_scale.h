@@ -0,0 +1,32 @@
+#ifndef __IMAGE_SCALE_H_INCLUDED__
+#define __IMAGE_SCALE_H_INCLUDED__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 32 bit per pixel image, e.g. ARGB8888. The stride is in bytes and may be
+// negative to walk the rows bottom up.
+struct image {
+    uint8_t *data;
+    int32_t  width;
+    int32_t  height;
+    int32_t  stride;
+};
+
+// View of an image with its rows in reverse order.
+struct image image_flipped(const struct image *image);
+
+/*
+ * Resize `src` into `dst`, which must be allocated with its size set.
+ *
+ * The source is first halved with a 2x2 box filter while it is at least
+ * twice the destination size, then resampled with a bilinear filter. Each
+ * channel is filtered independently with 8 bit weights, using SSE2 when
+ * available. Return -1 if a temporary buffer could not be allocated.
+ */
+int image_scale(const struct image *src, struct image *dst);
+
+// Same as `image_scale` without SIMD, gives the exact same result.
+int image_scale_scalar(const struct image *src, struct image *dst);
+
+#endif
@@ -0,0 +1,638 @@
+#include "json_tape.h"
+
+#include "log.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define BLOCK_SIZE 64
+
+// Sway trees are a few dozen levels deep at most.
+#define MAX_DEPTH 256
+
+// Bytes of a block of input, bit i for byte i.
+struct block_masks {
+    uint64_t quotes;
+    uint64_t backslashes;
+    uint64_t structurals; // {}[]:,
+};
+
+struct parser {
+    struct json_tape *tape;
+    char             *input;
+    size_t            len;
+    size_t            next; // in the index
+    size_t            pos;  // first byte not parsed yet
+};
+
+static int _reserve(
+    void **array, size_t elem_size, size_t len, size_t extra, size_t *cap
+) {
+    if (len + extra <= *cap) {
+        return 0;
+    }
+
+    size_t new_cap = *cap == 0 ? 256 : *cap;
+    while (new_cap < len + extra) {
+        new_cap *= 2;
+    }
+
+    void *new_array = realloc(*array, new_cap * elem_size);
+    if (new_array == NULL) {
+        LOG_ERR("Could not allocate JSON tape.");
+        return -1;
+    }
+
+    *array = new_array;
+    *cap   = new_cap;
+    return 0;
+}
+
+static void _classify_scalar(const char *block, struct block_masks *masks) {
+    *masks = (struct block_masks){0};
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        switch (block[i]) {
+        case '"':
+            masks->quotes |= bit;
+            break;
+        case '\\':
+            masks->backslashes |= bit;
+            break;
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+            masks->structurals |= bit;
+            break;
+        }
+    }
+}
+
+#ifdef __SSE2__
+
+static uint64_t _mask_sse2(__m128i eq, int shift) {
+    return (uint64_t)(uint16_t)_mm_movemask_epi8(eq) << shift;
+}
+
+static void _classify_sse2(const char *block, struct block_masks *masks) {
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i open      = _mm_set1_epi8('{');
+    const __m128i close     = _mm_set1_epi8('}');
+    const __m128i colon     = _mm_set1_epi8(':');
+    const __m128i comma     = _mm_set1_epi8(',');
+    const __m128i bit5      = _mm_set1_epi8(0x20);
+
+    *masks = (struct block_masks){0};
+    for (int i = 0; i < BLOCK_SIZE; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(block + i));
+
+        // '[' and ']' are '{' and '}' without bit 5, no other byte is.
+        __m128i braces      = _mm_or_si128(chunk, bit5);
+        __m128i structurals = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(braces, open), _mm_cmpeq_epi8(braces, close)
+            ),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)
+            )
+        );
+
+        masks->quotes      |= _mask_sse2(_mm_cmpeq_epi8(chunk, quote), i);
+        masks->backslashes |= _mask_sse2(_mm_cmpeq_epi8(chunk, backslash), i);
+        masks->structurals |= _mask_sse2(structurals, i);
+    }
+}
+
+#endif
+
+// Bytes preceded by a backslash that is not itself escaped. `carry` is set
+// if the last byte of the block escapes the first one of the next.
+static uint64_t _escaped(uint64_t backslashes, uint64_t *carry) {
+    uint64_t escaped = *carry;
+    *carry           = 0;
+
+    // Backslashes are rare enough in window titles to go one by one.
+    while (backslashes != 0) {
+        uint64_t bit  = backslashes & -backslashes;
+        backslashes  ^= bit;
+        if (escaped & bit) {
+            continue;
+        }
+
+        if (bit >> (BLOCK_SIZE - 1)) {
+            *carry = 1;
+        } else {
+            escaped |= bit << 1;
+        }
+    }
+
+    return escaped;
+}
+
+// Bit i is set if an odd number of bits are set up to i, included.
+static uint64_t _prefix_xor(uint64_t bits) {
+    for (int shift = 1; shift < BLOCK_SIZE; shift *= 2) {
+        bits ^= bits << shift;
+    }
+    return bits;
+}
+
+// Record the positions of the quotes and of the structural characters out of
+// strings. The bytes of a string, up to its closing quote, are those after
+// an odd number of quotes.
+static int _index(struct json_tape *tape, size_t len, bool simd) {
+    void (*classify)(const char *, struct block_masks *) = _classify_scalar;
+#ifdef __SSE2__
+    if (simd) {
+        classify = _classify_sse2;
+    }
+#endif
+
+    uint64_t escape_carry = 0;
+    uint64_t in_string    = 0; // all ones if the previous block ended in one
+    tape->index_len       = 0;
+    for (size_t offset = 0; offset < len; offset += BLOCK_SIZE) {
+        struct block_masks masks;
+        classify(tape->input + offset, &masks);
+
+        uint64_t quotes =
+            masks.quotes & ~_escaped(masks.backslashes, &escape_carry);
+        uint64_t strings = _prefix_xor(quotes) ^ in_string;
+        in_string        = 0 - (strings >> (BLOCK_SIZE - 1));
+
+        if (_reserve(
+                (void **)&tape->index, sizeof(uint32_t), tape->index_len,
+                BLOCK_SIZE, &tape->index_cap
+            ) != 0) {
+            return -1;
+        }
+
+        uint64_t bits = (masks.structurals & ~strings) | quotes;
+        while (bits != 0) {
+            tape->index[tape->index_len++] = offset + __builtin_ctzll(bits);
+            bits                          &= bits - 1;
+        }
+    }
+
+    return 0;
+}
+
+static bool _is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static size_t _skip_space(struct parser *p, size_t pos) {
+    while (pos < p->len && _is_space(p->input[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// Consume `c` if it is the next structural character, after spaces only.
+static bool _consume(struct parser *p, char c) {
+    struct json_tape *tape = p->tape;
+    size_t            pos  = _skip_space(p, p->pos);
+    if (p->next >= tape->index_len || tape->index[p->next] != pos ||
+        p->input[pos] != c) {
+        return false;
+    }
+
+    p->next++;
+    p->pos = pos + 1;
+    return true;
+}
+
+// The returned node is valid until the next push.
+static struct json_node *_push(struct parser *p, enum json_node_type type) {
+    struct json_tape *tape = p->tape;
+    if (_reserve(
+            (void **)&tape->nodes, sizeof(struct json_node), tape->nodes_len,
+            1, &tape->nodes_cap
+        ) != 0) {
+        return NULL;
+    }
+
+    struct json_node *node = &tape->nodes[tape->nodes_len++];
+    *node                  = (struct json_node){.type = type, .skip = 1};
+    return node;
+}
+
+static void _close(struct parser *p, size_t container, uint32_t size) {
+    struct json_node *node = &p->tape->nodes[container];
+    node->size             = size;
+    node->skip             = p->tape->nodes_len - container;
+}
+
+static int _hex4(const char *s, uint32_t *value) {
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        int  digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+            digit = (c | 0x20) - 'a' + 10;
+        } else {
+            return -1;
+        }
+        *value = *value << 4 | digit;
+    }
+    return 0;
+}
+
+static size_t _encode_utf8(uint32_t rune, char *s) {
+    if (rune < 0x80) {
+        s[0] = rune;
+        return 1;
+    }
+    if (rune < 0x800) {
+        s[0] = 0xc0 | rune >> 6;
+        s[1] = 0x80 | (rune & 0x3f);
+        return 2;
+    }
+    if (rune < 0x10000) {
+        s[0] = 0xe0 | rune >> 12;
+        s[1] = 0x80 | (rune >> 6 & 0x3f);
+        s[2] = 0x80 | (rune & 0x3f);
+        return 3;
+    }
+    s[0] = 0xf0 | rune >> 18;
+    s[1] = 0x80 | (rune >> 12 & 0x3f);
+    s[2] = 0x80 | (rune >> 6 & 0x3f);
+    s[3] = 0x80 | (rune & 0x3f);
+    return 4;
+}
+
+// Decode the escapes of a string in place, escapes are never shorter than
+// what they stand for. Return the new length, or -1 if an escape is invalid.
+static ptrdiff_t _unescape(char *s, size_t len) {
+    char *src = memchr(s, '\\', len);
+    if (src == NULL) {
+        return len;
+    }
+
+    char *end = s + len;
+    char *dst = src;
+    while (src < end) {
+        if (*src != '\\') {
+            *dst++ = *src++;
+            continue;
+        }
+        if (end - src < 2) {
+            return -1;
+        }
+
+        char c  = src[1];
+        src    += 2;
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            *dst++ = c;
+            break;
+        case 'b':
+            *dst++ = '\b';
+            break;
+        case 'f':
+            *dst++ = '\f';
+            break;
+        case 'n':
+            *dst++ = '\n';
+            break;
+        case 'r':
+            *dst++ = '\r';
+            break;
+        case 't':
+            *dst++ = '\t';
+            break;
+        case 'u': {
+            uint32_t rune, low;
+            if (end - src < 4 || _hex4(src, &rune) != 0) {
+                return -1;
+            }
+            src += 4;
+
+            // Characters out of the BMP are escaped as surrogate pairs.
+            if (rune >= 0xd800 && rune < 0xdc00 && end - src >= 6 &&
+                src[0] == '\\' && src[1] == 'u' && _hex4(src + 2, &low) == 0 &&
+                low >= 0xdc00 && low < 0xe000) {
+                rune = 0x10000 + ((rune - 0xd800) << 10) + (low - 0xdc00);
+                src += 6;
+            }
+            dst += _encode_utf8(rune, dst);
+            break;
+        }
+        default:
+            return -1;
+        }
+    }
+
+    return dst - s;
+}
+
+// The opening quote is consumed, the next structural character is the
+// closing one.
+static int _parse_string(struct parser *p) {
+    struct json_tape *tape = p->tape;
+    if (p->next >= tape->index_len || p->input[tape->index[p->next]] != '"') {
+        return -1;
+    }
+
+    size_t    end = tape->index[p->next++];
+    char     *s   = p->input + p->pos;
+    ptrdiff_t len = _unescape(s, end - p->pos);
+    if (len < 0) {
+        return -1;
+    }
+    s[len] = '\0';
+
+    struct json_node *node = _push(p, JSON_NODE_STRING);
+    if (node == NULL) {
+        return -1;
+    }
+    node->size   = len;
+    node->string = s;
+
+    p->pos = end + 1;
+    return 0;
+}
+
+static int _parse_number(const char *s, size_t len, struct json_node *node) {
+    bool real = false;
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        if (c == '.' || c == 'e' || c == 'E') {
+            real = true;
+        } else if ((c < '0' || c > '9') && c != '-' && c != '+') {
+            return -1;
+        }
+    }
+
+    char *end;
+    if (!real) {
+        errno             = 0;
+        long long integer = strtoll(s, &end, 10);
+        if (errno == 0 && end == s + len && len > 0) {
+            node->type    = JSON_NODE_INTEGER;
+            node->integer = integer;
+            return 0;
+        }
+    }
+
+    // Integers out of range are kept as reals rather than rejected.
+    double value = strtod(s, &end);
+    if (end != s + len || len == 0) {
+        return -1;
+    }
+    node->type = JSON_NODE_REAL;
+    node->real = value;
+    return 0;
+}
+
+// Literals and numbers end at the next structural character or space.
+static int _parse_scalar(struct parser *p) {
+    struct json_tape *tape  = p->tape;
+    size_t            start = _skip_space(p, p->pos);
+    size_t            end   = p->next < tape->index_len ? tape->index[p->next]
+                                                        : p->len;
+    while (end > start && _is_space(p->input[end - 1])) {
+        end--;
+    }
+
+    const char       *s    = p->input + start;
+    size_t            len  = end - start;
+    struct json_node *node = _push(p, JSON_NODE_NULL);
+    if (node == NULL) {
+        return -1;
+    }
+
+    p->pos = end;
+    if (len == 4 && memcmp(s, "null", 4) == 0) {
+        return 0;
+    }
+    if (len == 4 && memcmp(s, "true", 4) == 0) {
+        node->type = JSON_NODE_TRUE;
+        return 0;
+    }
+    if (len == 5 && memcmp(s, "false", 5) == 0) {
+        node->type = JSON_NODE_FALSE;
+        return 0;
+    }
+    return _parse_number(s, len, node);
+}
+
+static int _parse_value(struct parser *p, int depth);
+
+static int _parse_object(struct parser *p, int depth) {
+    size_t   self = p->tape->nodes_len;
+    uint32_t size = 0;
+    if (_push(p, JSON_NODE_OBJECT) == NULL) {
+        return -1;
+    }
+
+    if (!_consume(p, '}')) {
+        do {
+            if (!_consume(p, '"') || _parse_string(p) != 0 ||
+                !_consume(p, ':') || _parse_value(p, depth) != 0) {
+                return -1;
+            }
+            size++;
+        } while (_consume(p, ','));
+
+        if (!_consume(p, '}')) {
+            return -1;
+        }
+    }
+
+    _close(p, self, size);
+    return 0;
+}
+
+static int _parse_array(struct parser *p, int depth) {
+    size_t   self = p->tape->nodes_len;
+    uint32_t size = 0;
+    if (_push(p, JSON_NODE_ARRAY) == NULL) {
+        return -1;
+    }
+
+    if (!_consume(p, ']')) {
+        do {
+            if (_parse_value(p, depth) != 0) {
+                return -1;
+            }
+            size++;
+        } while (_consume(p, ','));
+
+        if (!_consume(p, ']')) {
+            return -1;
+        }
+    }
+
+    _close(p, self, size);
+    return 0;
+}
+
+static int _parse_value(struct parser *p, int depth) {
+    if (depth > MAX_DEPTH) {
+        return -1;
+    }
+
+    if (_consume(p, '"')) {
+        return _parse_string(p);
+    }
+    if (_consume(p, '{')) {
+        return _parse_object(p, depth + 1);
+    }
+    if (_consume(p, '[')) {
+        return _parse_array(p, depth + 1);
+    }
+    return _parse_scalar(p);
+}
+
+static int
+_parse(struct json_tape *tape, const char *json, size_t len, bool simd) {
+    tape->nodes_len    = 0;
+    tape->error_offset = 0;
+    if (len >= UINT32_MAX - BLOCK_SIZE) {
+        LOG_ERR("JSON of %zu bytes is too large.", len);
+        return -1;
+    }
+
+    // The copy ends with a NUL then spaces up to a whole block, for the
+    // strings and numbers at the end and for the last block to be read
+    // whole.
+    size_t padded = (len + BLOCK_SIZE) / BLOCK_SIZE * BLOCK_SIZE;
+    if (_reserve(
+            (void **)&tape->input, sizeof(char), 0, padded, &tape->input_cap
+        ) != 0) {
+        return -1;
+    }
+    memcpy(tape->input, json, len);
+    memset(tape->input + len, ' ', padded - len);
+    tape->input[len] = '\0';
+
+    if (_index(tape, len, simd) != 0) {
+        return -1;
+    }
+
+    struct parser p = {
+        .tape  = tape,
+        .input = tape->input,
+        .len   = len,
+        .next  = 0,
+        .pos   = 0,
+    };
+    if (_parse_value(&p, 0) != 0 || _skip_space(&p, p.pos) != len ||
+        p.next != tape->index_len) {
+        tape->error_offset = p.next < tape->index_len ? tape->index[p.next]
+                                                      : p.pos;
+        tape->nodes_len    = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+void json_tape_init(struct json_tape *tape) {
+    memset(tape, 0, sizeof(struct json_tape));
+}
+
+void json_tape_finish(struct json_tape *tape) {
+    free(tape->input);
+    free(tape->index);
+    free(tape->nodes);
+    json_tape_init(tape);
+}
+
+int json_tape_parse(struct json_tape *tape, const char *json, size_t len) {
+    return _parse(tape, json, len, true);
+}
+
+int json_tape_parse_scalar(
+    struct json_tape *tape, const char *json, size_t len
+) {
+    return _parse(tape, json, len, false);
+}
+
+int json_tape_load_file(struct json_tape *tape, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        LOG_ERR("Could not open '%s'.", path);
+        return -1;
+    }
+
+    char  *data = NULL;
+    size_t size = 0;
+    FILE  *out  = open_memstream(&data, &size);
+    char   chunk[4096];
+    size_t n;
+    while (out != NULL && (n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        fwrite(chunk, 1, n, out);
+    }
+    fclose(f);
+    if (out == NULL || fclose(out) != 0) {
+        LOG_ERR("Could not read '%s'.", path);
+        free(data);
+        return -1;
+    }
+
+    int err = json_tape_parse(tape, data, size);
+    free(data);
+    return err;
+}
+
+const struct json_node *json_tape_root(const struct json_tape *tape) {
+    return tape->nodes_len > 0 ? tape->nodes : NULL;
+}
+
+bool json_node_is(const struct json_node *node, enum json_node_type type) {
+    return node != NULL && node->type == type;
+}
+
+const struct json_node *
+json_node_get(const struct json_node *object, const char *key) {
+    if (!json_node_is(object, JSON_NODE_OBJECT)) {
+        return NULL;
+    }
+
+    const struct json_node *member = object + 1;
+    for (uint32_t i = 0; i < object->size; i++) {
+        const struct json_node *value = member + 1;
+        if (strcmp(member->string, key) == 0) {
+            return value;
+        }
+        member = value + value->skip;
+    }
+
+    return NULL;
+}
+
+const struct json_node *json_node_at(const struct json_node *array, size_t i) {
+    if (!json_node_is(array, JSON_NODE_ARRAY) || i >= array->size) {
+        return NULL;
+    }
+
+    const struct json_node *value = array + 1;
+    while (i-- > 0) {
+        value += value->skip;
+    }
+    return value;
+}
+
+size_t json_node_array_size(const struct json_node *array) {
+    return json_node_is(array, JSON_NODE_ARRAY) ? array->size : 0;
+}
+
+const char *json_node_string(const struct json_node *node) {
+    return json_node_is(node, JSON_NODE_STRING) ? node->string : NULL;
+}
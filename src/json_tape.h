@@ -0,0 +1,88 @@
+#ifndef __JSON_TAPE_H_INCLUDED__
+#define __JSON_TAPE_H_INCLUDED__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum json_node_type {
+    JSON_NODE_NULL,
+    JSON_NODE_FALSE,
+    JSON_NODE_TRUE,
+    JSON_NODE_INTEGER,
+    JSON_NODE_REAL,
+    JSON_NODE_STRING,
+    JSON_NODE_ARRAY,
+    JSON_NODE_OBJECT,
+};
+
+/*
+ * A value on the tape. The values of an array, and the key and value of
+ * each member of an object, follow their container in order. `skip` goes
+ * from a value to its next sibling.
+ */
+struct json_node {
+    enum json_node_type type;
+    uint32_t            size; // array values, object members or string bytes
+    uint32_t            skip; // nodes in this value, itself included
+    union {
+        int64_t     integer;
+        double      real;
+        const char *string; // unescaped and NUL terminated
+    };
+};
+
+/*
+ * Parser for the replies of Sway, made for large GET_TREE payloads.
+ *
+ * The first stage finds the quotes and the structural characters out of
+ * strings, 64 bytes at a time, using SSE2 when available. The second stage
+ * walks them to lay out the values on a tape, with strings unescaped in a
+ * copy of the input. Buffers are kept from one parse to the next.
+ */
+struct json_tape {
+    char             *input; // copy, padded to a whole block
+    size_t            input_cap;
+    uint32_t         *index; // positions of the structural characters
+    size_t            index_len;
+    size_t            index_cap;
+    struct json_node *nodes;
+    size_t            nodes_len;
+    size_t            nodes_cap;
+    size_t            error_offset; // in the input, if parsing failed
+};
+
+void json_tape_init(struct json_tape *tape);
+void json_tape_finish(struct json_tape *tape);
+
+// Parse `len` bytes of JSON, the root is the first node. Return non-zero if
+// it is invalid or too deep.
+int json_tape_parse(struct json_tape *tape, const char *json, size_t len);
+
+// Same as `json_tape_parse` without SIMD, gives the exact same tape.
+int json_tape_parse_scalar(
+    struct json_tape *tape, const char *json, size_t len
+);
+
+int json_tape_load_file(struct json_tape *tape, const char *path);
+
+const struct json_node *json_tape_root(const struct json_tape *tape);
+
+// Whether the node exists and has the given type.
+bool json_node_is(const struct json_node *node, enum json_node_type type);
+
+// Value of a member of an object, NULL if there is none or the node is not
+// an object.
+const struct json_node *
+json_node_get(const struct json_node *object, const char *key);
+
+// Value `i` of an array, NULL if out of range or the node is not an array.
+const struct json_node *json_node_at(const struct json_node *array, size_t i);
+
+// Number of values of an array, 0 for other nodes.
+size_t json_node_array_size(const struct json_node *array);
+
+// NULL if the node is not a string.
+const char *json_node_string(const struct json_node *node);
+
+#endif
@@ -0,0 +1,284 @@
+#include "latency.h"
+
+#include "log.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define HISTOGRAM_BAR_WIDTH 40
+
+static uint64_t _now_ns(clockid_t clock_id) {
+    struct timespec ts;
+    clock_gettime(clock_id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void _histogram_add(struct latency_histogram *histogram, double ms) {
+    size_t bucket = 0;
+    while (bucket < LATENCY_NUM_BUCKETS - 1 && ms >= (1 << bucket)) {
+        bucket++;
+    }
+
+    if (histogram->num_samples == 0 || ms < histogram->min_ms) {
+        histogram->min_ms = ms;
+    }
+    if (histogram->num_samples == 0 || ms > histogram->max_ms) {
+        histogram->max_ms = ms;
+    }
+    histogram->counts[bucket]++;
+    histogram->num_samples++;
+    histogram->sum_ms += ms;
+}
+
+static void
+_histogram_print(struct latency_histogram *histogram, const char *name) {
+    if (histogram->num_samples == 0) {
+        fprintf(stderr, "%s: no samples\n", name);
+        return;
+    }
+
+    fprintf(
+        stderr, "%s: %u samples, min %.2f ms, mean %.2f ms, max %.2f ms\n",
+        name, histogram->num_samples, histogram->min_ms,
+        histogram->sum_ms / histogram->num_samples, histogram->max_ms
+    );
+
+    uint32_t max_count = 0;
+    for (size_t i = 0; i < LATENCY_NUM_BUCKETS; i++) {
+        if (histogram->counts[i] > max_count) {
+            max_count = histogram->counts[i];
+        }
+    }
+
+    for (size_t i = 0; i < LATENCY_NUM_BUCKETS; i++) {
+        if (histogram->counts[i] == 0) {
+            continue;
+        }
+
+        char bar[HISTOGRAM_BAR_WIDTH + 1];
+        int  len = histogram->counts[i] * HISTOGRAM_BAR_WIDTH / max_count;
+        memset(bar, '#', len);
+        bar[len] = '\0';
+
+        if (i == LATENCY_NUM_BUCKETS - 1) {
+            fprintf(
+                stderr, "  >= %4d ms %6u %s\n", 1 << (i - 1),
+                histogram->counts[i], bar
+            );
+        } else {
+            fprintf(
+                stderr, "   < %4d ms %6u %s\n", 1 << i, histogram->counts[i],
+                bar
+            );
+        }
+    }
+}
+
+static void handle_clock_id(
+    void *data, struct wp_presentation *wp_presentation, uint32_t clock_id
+) {
+    struct latency *latency = data;
+    if (clock_id == latency->clock_id) {
+        return;
+    }
+
+    // Move the start time to the presentation clock.
+    latency->start_ns += _now_ns(clock_id) - _now_ns(latency->clock_id);
+    latency->clock_id  = clock_id;
+}
+
+static const struct wp_presentation_listener wp_presentation_listener = {
+    .clock_id = handle_clock_id,
+};
+
+static void _feedback_release(struct latency_feedback *feedback) {
+    wp_presentation_feedback_destroy(feedback->feedback);
+    feedback->feedback = NULL;
+}
+
+static void handle_feedback_presented(
+    void *data, struct wp_presentation_feedback *wp_feedback,
+    uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+    uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags
+) {
+    struct latency_feedback *feedback = data;
+    struct latency          *latency  = feedback->latency;
+
+    uint64_t present_ns =
+        (((uint64_t)tv_sec_hi << 32) | tv_sec_lo) * 1000000000 + tv_nsec;
+
+    if (latency->first_present_ns == 0) {
+        latency->first_present_ns = present_ns;
+        trace_instant("first_present");
+    }
+
+    if (present_ns > feedback->commit_ns) {
+        _histogram_add(
+            &latency->commit_to_present,
+            (present_ns - feedback->commit_ns) / 1e6
+        );
+    }
+
+    if (feedback->has_input) {
+        // Input times are 32 bit milliseconds that wrap around.
+        uint32_t present_ms = present_ns / 1000000;
+        uint32_t elapsed_ms = present_ms - feedback->input_time;
+        _histogram_add(
+            &latency->input_to_present,
+            elapsed_ms + (present_ns % 1000000) / 1e6
+        );
+    }
+
+    _feedback_release(feedback);
+}
+
+static void handle_feedback_discarded(
+    void *data, struct wp_presentation_feedback *wp_feedback
+) {
+    struct latency_feedback *feedback = data;
+    feedback->latency->num_discarded++;
+    _feedback_release(feedback);
+}
+
+static void handle_feedback_sync_output(
+    void *data, struct wp_presentation_feedback *wp_feedback,
+    struct wl_output *output
+) {}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    .sync_output = handle_feedback_sync_output,
+    .presented   = handle_feedback_presented,
+    .discarded   = handle_feedback_discarded,
+};
+
+void latency_init(struct latency *latency, bool enabled) {
+    memset(latency, 0, sizeof(struct latency));
+    latency->enabled  = enabled;
+    latency->clock_id = CLOCK_MONOTONIC;
+    latency->start_ns = _now_ns(CLOCK_MONOTONIC);
+}
+
+void latency_bind(
+    struct latency *latency, struct wl_registry *registry, uint32_t name
+) {
+    if (!latency->enabled) {
+        return;
+    }
+
+    latency->wp_presentation =
+        wl_registry_bind(registry, name, &wp_presentation_interface, 1);
+    wp_presentation_add_listener(
+        latency->wp_presentation, &wp_presentation_listener, latency
+    );
+}
+
+void latency_input(struct latency *latency, uint32_t time) {
+    if (!latency->enabled) {
+        return;
+    }
+
+    latency->input_time     = time;
+    latency->handling_input = true;
+}
+
+void latency_input_now(struct latency *latency) {
+    latency_input(latency, (uint32_t)(_now_ns(latency->clock_id) / 1000000));
+}
+
+void latency_input_done(struct latency *latency) {
+    latency->handling_input = false;
+}
+
+void latency_frame_requested(struct latency *latency) {
+    if (!latency->handling_input) {
+        return;
+    }
+
+    // Keep the earliest input not shown yet, the one that waited the most.
+    if (!latency->has_pending_input) {
+        latency->pending_input_time = latency->input_time;
+        latency->has_pending_input  = true;
+    }
+}
+
+void latency_commit(struct latency *latency, struct wl_surface *surface) {
+    if (latency->wp_presentation == NULL) {
+        return;
+    }
+
+    struct latency_feedback *feedback = NULL;
+    for (size_t i = 0; i < LATENCY_MAX_FEEDBACKS; i++) {
+        if (latency->feedbacks[i].feedback == NULL) {
+            feedback = &latency->feedbacks[i];
+            break;
+        }
+    }
+
+    if (feedback == NULL) {
+        LOG_DEBUG("Too many frames waiting for presentation, not measured.");
+        return;
+    }
+
+    feedback->latency    = latency;
+    feedback->commit_ns  = _now_ns(latency->clock_id);
+    feedback->input_time = latency->pending_input_time;
+    feedback->has_input  = latency->has_pending_input;
+    feedback->feedback =
+        wp_presentation_feedback(latency->wp_presentation, surface);
+    wp_presentation_feedback_add_listener(
+        feedback->feedback, &feedback_listener, feedback
+    );
+
+    latency->has_pending_input = false;
+}
+
+void latency_report(struct latency *latency) {
+    if (!latency->enabled) {
+        return;
+    }
+
+    if (latency->wp_presentation == NULL) {
+        LOG_WARN("The compositor does not support wp_presentation.");
+        return;
+    }
+
+    log_flush();
+
+    if (latency->first_present_ns == 0) {
+        fprintf(stderr, "first presented frame: never presented\n");
+    } else {
+        fprintf(
+            stderr, "first presented frame: %.2f ms after start\n",
+            (latency->first_present_ns - latency->start_ns) / 1e6
+        );
+    }
+
+    // A guide picked without --live ends with the unmap, which shows no
+    // frame of the overlay to time.
+    _histogram_print(&latency->input_to_present, "input to present");
+    fprintf(
+        stderr, "  (frames drawn for live resizes, held keys, drags, hovers"
+                " and hints; picking a guide without --live is not"
+                " measured)\n"
+    );
+    _histogram_print(&latency->commit_to_present, "commit to present");
+
+    if (latency->num_discarded > 0) {
+        fprintf(stderr, "%u frames discarded\n", latency->num_discarded);
+    }
+}
+
+void latency_finish(struct latency *latency) {
+    for (size_t i = 0; i < LATENCY_MAX_FEEDBACKS; i++) {
+        if (latency->feedbacks[i].feedback != NULL) {
+            _feedback_release(&latency->feedbacks[i]);
+        }
+    }
+
+    if (latency->wp_presentation != NULL) {
+        wp_presentation_destroy(latency->wp_presentation);
+        latency->wp_presentation = NULL;
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef __LATENCY_H_INCLUDED__
+#define __LATENCY_H_INCLUDED__
+
+#include "presentation-time-client-protocol.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-client.h>
+
+// Bucket `i` counts latencies below 2^i ms, the last one everything above.
+#define LATENCY_NUM_BUCKETS 12
+
+// Commits waiting for their presentation feedback. Two buffers are in flight
+// at most, more only happen when the compositor holds frames back.
+#define LATENCY_MAX_FEEDBACKS 8
+
+struct latency_histogram {
+    uint32_t counts[LATENCY_NUM_BUCKETS];
+    uint32_t num_samples;
+    double   sum_ms;
+    double   min_ms;
+    double   max_ms;
+};
+
+struct latency_feedback {
+    struct latency                  *latency;
+    struct wp_presentation_feedback *feedback;
+    uint64_t                         commit_ns;
+    uint32_t                         input_time;
+    bool                             has_input;
+};
+
+/*
+ * Presentation timing of the overlay, measured with wp_presentation.
+ *
+ * Each commit asks for presentation feedback. The input event time of the
+ * key or pointer event that caused the commit is carried along, so that the
+ * time until the frame was shown can be computed once it is presented.
+ * Input event times and presentation timestamps are both taken from the
+ * compositor clock, which is CLOCK_MONOTONIC on Sway. Only inputs requesting
+ * a frame are measured, those ending with the unmap of the overlay have no
+ * frame to be timed by.
+ */
+struct latency {
+    bool                    enabled;
+    struct wp_presentation *wp_presentation;
+    uint32_t                clock_id;
+    uint64_t                start_ns;
+    uint64_t                first_present_ns;
+    uint32_t                input_time; // of the input being handled
+    bool                    handling_input;
+    uint32_t                pending_input_time;
+    bool                    has_pending_input;
+    uint32_t                num_discarded;
+
+    struct latency_histogram input_to_present;
+    struct latency_histogram commit_to_present;
+    struct latency_feedback  feedbacks[LATENCY_MAX_FEEDBACKS];
+};
+
+void latency_init(struct latency *latency, bool enabled);
+
+// Called on the `wp_presentation` global, which is bound only if enabled.
+void latency_bind(
+    struct latency *latency, struct wl_registry *registry, uint32_t name
+);
+
+// Start handling an input event. If handling it requests a frame, the next
+// commit is attributed to it.
+void latency_input(struct latency *latency, uint32_t time);
+
+// Same for an input without a timestamp, like a key repeat, happening now.
+void latency_input_now(struct latency *latency);
+
+// The input event is handled, frames requested from now on are not caused by
+// it.
+void latency_input_done(struct latency *latency);
+
+// Called when a frame is requested.
+void latency_frame_requested(struct latency *latency);
+
+// Request presentation feedback for the commit about to be done.
+void latency_commit(struct latency *latency, struct wl_surface *surface);
+
+// Print the time to first presented frame and the latency histograms.
+void latency_report(struct latency *latency);
+
+void latency_finish(struct latency *latency);
+
+#endif
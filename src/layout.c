@@ -0,0 +1,215 @@
+#include "layout.h"
+
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GOLDEN_RATIO_PERMILLE 618
+
+static int _parse_values(struct layout_preset *preset, const char *s) {
+    const char *p = s;
+    while (*p != '\0') {
+        if (preset->num_values == SWAY_WIN_MAX_SIBLINGS) {
+            return 1;
+        }
+
+        char *end;
+        long  value = strtol(p, &end, 10);
+        if (end == p || value <= 0 || value > INT32_MAX) {
+            return 2;
+        }
+
+        bool percentage = *end == '%';
+        if (percentage) {
+            end++;
+        }
+        if (*end != ',' && *end != '\0') {
+            return 3;
+        }
+
+        preset->values[preset->num_values]      = value;
+        preset->percentages[preset->num_values] = percentage;
+        preset->num_values++;
+
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    return preset->num_values == 0;
+}
+
+int layout_preset_parse(struct layout_preset *preset, const char *s) {
+    memset(preset, 0, sizeof(struct layout_preset));
+
+    if (strcmp(s, "equal") == 0) {
+        preset->type = LAYOUT_EQUAL;
+        return 0;
+    }
+
+    if (strcmp(s, "golden") == 0) {
+        preset->type = LAYOUT_GOLDEN;
+        return 0;
+    }
+
+    if (strncmp(s, "fixed:", 6) == 0) {
+        preset->type = LAYOUT_FIXED;
+        return _parse_values(preset, s + 6);
+    }
+
+    return 1;
+}
+
+static int32_t _sibling_size(const struct siblings *siblings, int i) {
+    const struct rect *rect = &siblings->nodes[i].rect;
+    return siblings->horizontal ? rect->w : rect->h;
+}
+
+// Split `space` over the `num_shared` siblings whose size is still 0.
+static void _share(int32_t *sizes, int count, int32_t space, int num_shared) {
+    int32_t share = space / num_shared;
+    int32_t extra = space % num_shared;
+    for (int i = 0; i < count; i++) {
+        if (sizes[i] == 0) {
+            sizes[i] = share + (extra-- > 0);
+        }
+    }
+}
+
+int layout_preset_compute(
+    const struct layout_preset *preset, const struct siblings *siblings,
+    int32_t *sizes
+) {
+    int count = siblings->count;
+    if (count < 2) {
+        LOG_ERR("The focused window has no sibling in a split container.");
+        return -1;
+    }
+
+    // Gaps and borders around the siblings stay as they are.
+    int32_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += _sibling_size(siblings, i);
+        sizes[i] = 0;
+    }
+
+    int32_t space      = total;
+    int     num_shared = count;
+    switch (preset->type) {
+    case LAYOUT_EQUAL:
+        break;
+
+    case LAYOUT_GOLDEN:
+        sizes[siblings->focused] = total * GOLDEN_RATIO_PERMILLE / 1000;
+        space                   -= sizes[siblings->focused];
+        num_shared--;
+        break;
+
+    case LAYOUT_FIXED:
+        // The last sibling always gets what is left.
+        if (preset->num_values >= count) {
+            LOG_ERR(
+                "The layout sets %d sizes, at most %d of the %d windows can be "
+                "set.",
+                preset->num_values, count - 1, count
+            );
+            return -1;
+        }
+        for (int i = 0; i < preset->num_values; i++) {
+            sizes[i] = preset->percentages[i]
+                           ? (int64_t)total * preset->values[i] / 100
+                           : preset->values[i];
+            if (sizes[i] < LAYOUT_MIN_SIZE) {
+                LOG_ERR("Layout size %dpx is too small.", sizes[i]);
+                return -1;
+            }
+            space -= sizes[i];
+            num_shared--;
+        }
+        break;
+    }
+
+    if (space < (int64_t)num_shared * LAYOUT_MIN_SIZE) {
+        LOG_ERR("The layout does not fit in %dpx.", total);
+        return -1;
+    }
+    _share(sizes, count, space, num_shared);
+
+    for (int i = 0; i < count; i++) {
+        if (sizes[i] < LAYOUT_MIN_SIZE) {
+            LOG_ERR(
+                "The layout makes windows smaller than %dpx.", LAYOUT_MIN_SIZE
+            );
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Sway splits the resize of a middle child between both of its neighbours,
+// so the sizes are set by moving the edge between two siblings instead. The
+// pixels moved across edge `i` are the sum of what the first `i + 1` siblings
+// gain.
+static void _edge_amounts(
+    const struct siblings *siblings, const int32_t *sizes, int32_t *amounts
+) {
+    int32_t amount = 0;
+    for (int i = 0; i < siblings->count - 1; i++) {
+        amount     += sizes[i] - _sibling_size(siblings, i);
+        amounts[i]  = amount;
+    }
+}
+
+// Edge `i` is moved once the other edge of the sibling giving space moved, if
+// it brings that sibling more, so that nobody shrinks below its final size in
+// between. Sway refuses resizes below its minimum size.
+static bool _edge_ready(
+    const int32_t *amounts, const bool *moved, int num_edges, int i
+) {
+    if (amounts[i] > 0) {
+        return i + 1 == num_edges || amounts[i + 1] <= 0 || moved[i + 1];
+    }
+    return i == 0 || amounts[i - 1] >= 0 || moved[i - 1];
+}
+
+char *layout_command(const struct siblings *siblings, const int32_t *sizes) {
+    // Longest: `;[con_id=-2147483648] resize shrink right 2147483647px`.
+    static const size_t max_cmd_len = 58;
+
+    int     num_edges = siblings->count - 1;
+    int32_t amounts[SWAY_WIN_MAX_SIBLINGS];
+    bool    moved[SWAY_WIN_MAX_SIBLINGS] = {0};
+    _edge_amounts(siblings, sizes, amounts);
+
+    size_t cap = siblings->count * max_cmd_len + 1;
+    char  *cmd = malloc(cap);
+    if (cmd == NULL) {
+        LOG_ERR("Could not allocate layout command.");
+        return NULL;
+    }
+
+    size_t len = 0;
+    cmd[0]     = '\0';
+    for (int remaining = num_edges; remaining > 0;) {
+        for (int i = 0; i < num_edges; i++) {
+            if (moved[i] || !_edge_ready(amounts, moved, num_edges, i)) {
+                continue;
+            }
+            moved[i] = true;
+            remaining--;
+
+            if (amounts[i] == 0) {
+                continue;
+            }
+            len += snprintf(
+                cmd + len, cap - len, "%s[con_id=%d] resize %s %s %dpx",
+                len > 0 ? ";" : "", siblings->nodes[i].id,
+                amounts[i] > 0 ? "grow" : "shrink",
+                siblings->horizontal ? "right" : "down", abs(amounts[i])
+            );
+        }
+    }
+
+    return cmd;
+}
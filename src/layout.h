@@ -0,0 +1,48 @@
+#ifndef __LAYOUT_H_INCLUDED__
+#define __LAYOUT_H_INCLUDED__
+
+#include "sway_win.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LAYOUT_MIN_SIZE 15
+
+enum layout_preset_type {
+    LAYOUT_EQUAL  = 0,
+    LAYOUT_GOLDEN = 1,
+    LAYOUT_FIXED  = 2,
+};
+
+/*
+ * Sizes given to all the siblings of the focused window along the axis of
+ * their container.
+ *
+ *  - equal: same size for all of them.
+ *  - golden: the focused one gets 61.8%, the others share the rest.
+ *  - fixed:640,30%: sizes of the first siblings in pixels or percent, the
+ *    others share the rest. The last sibling cannot be given a size.
+ */
+struct layout_preset {
+    enum layout_preset_type type;
+    int32_t                 values[SWAY_WIN_MAX_SIBLINGS];
+    bool                    percentages[SWAY_WIN_MAX_SIBLINGS];
+    int                     num_values;
+};
+
+// Return non-zero if `s` is not a preset.
+int layout_preset_parse(struct layout_preset *preset, const char *s);
+
+// Fill `sizes` with the target size of each sibling. Return non-zero if the
+// preset does not fit in the container.
+int layout_preset_compute(
+    const struct layout_preset *preset, const struct siblings *siblings,
+    int32_t *sizes
+);
+
+// `;`-joined resize commands with `con_id` criteria, to be freed by the
+// caller. Each one moves the edge between two siblings, empty if none moves.
+char *layout_command(const struct siblings *siblings, const int32_t *sizes);
+
+#endif
@@ -0,0 +1,227 @@
+#include "live.h"
+
+#include "frame.h"
+#include "json_tape.h"
+#include "log.h"
+#include "state.h"
+#include "sway_ipc.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xkbcommon/xkbcommon-keysyms.h>
+
+void live_init(struct live_resize *live, bool enabled) {
+    live->enabled             = enabled;
+    live->command_outstanding = false;
+    live->pending_width       = -1;
+    live->pending_height      = -1;
+    live->commands_sent       = 0;
+    live->commands_replied    = 0;
+    json_tape_init(&live->reply_tape);
+}
+
+bool live_handle_keysym(struct state *state, xkb_keysym_t key_sym) {
+    struct resize_parameter param = {
+        .relative   = true,
+        .percentage = false,
+    };
+    enum resize_direction direction;
+
+    switch (key_sym) {
+    case XKB_KEY_Return:
+    case XKB_KEY_KP_Enter:
+        state->running = false;
+        return true;
+
+    case XKB_KEY_Left:
+        direction   = RESIZE_HORIZONTAL;
+        param.value = -LIVE_STEP;
+        break;
+
+    case XKB_KEY_Right:
+        direction   = RESIZE_HORIZONTAL;
+        param.value = LIVE_STEP;
+        break;
+
+    case XKB_KEY_Up:
+        direction   = RESIZE_VERTICAL;
+        param.value = -LIVE_STEP;
+        break;
+
+    case XKB_KEY_Down:
+        direction   = RESIZE_VERTICAL;
+        param.value = LIVE_STEP;
+        break;
+
+    default:
+        return false;
+    }
+
+    if (resize_parameter_compute_guides(
+            &param, &state->focused_window, direction
+        )) {
+        live_apply(state, &param, direction);
+    }
+
+    return true;
+}
+
+void live_apply(
+    struct state *state, struct resize_parameter *param,
+    enum resize_direction direction
+) {
+    if (!param->applicable) {
+        return;
+    }
+
+    if (direction == RESIZE_HORIZONTAL) {
+        state->live.pending_width = param->size;
+    } else {
+        state->live.pending_height = param->size;
+    }
+
+    // The parameter may be one of the guides, which are recomputed from the
+    // new geometry.
+    resize_parameter_apply(param, direction, &state->focused_window);
+    resize_parameters_compute_guides(
+        state->resize_params, &state->focused_window
+    );
+
+    request_frame(state);
+}
+
+bool live_select(
+    struct state *state, struct resize_parameter *param,
+    enum resize_direction direction
+) {
+    if (state->live.enabled) {
+        live_apply(state, param, direction);
+        return true;
+    }
+
+    // Sway gets the command in the same flush as the surface is unmapped, so
+    // the window is resized on the next frame of the compositor rather than
+    // after the teardown.
+    state->selected_resize  = param;
+    state->resize_direction = direction;
+    state->running          = false;
+    live_send_resize(state, direction, param->size);
+    unmap_surface(state);
+    return false;
+}
+
+// The window picked in hint mode may not be the focused one.
+static int _write_criteria(struct state *state, char *cmd, size_t size) {
+    if (!state->hint.enabled) {
+        return 0;
+    }
+    return snprintf(cmd, size, "[con_id=%d] ", state->focused_window.id);
+}
+
+static void _print_command_reply(void *data, struct sway_ipc_msg *msg) {
+    struct state *state = data;
+    trace_async_end("resize_command", state->live.commands_replied++);
+
+    if (msg == NULL) {
+        LOG_ERR("Could not receive command reply.");
+        return;
+    }
+
+    puts(msg->payload);
+}
+
+int live_send_resize(
+    struct state *state, enum resize_direction direction, uint32_t size
+) {
+    char cmd[256];
+    int  len = _write_criteria(state, cmd, sizeof(cmd));
+
+    len += snprintf(
+        cmd + len, sizeof(cmd) - len, "resize set %s %dpx",
+        direction == RESIZE_VERTICAL ? "height" : "width", size
+    );
+
+    trace_async_begin("resize_command", state->live.commands_sent++);
+    return sway_ipc_client_send(
+        &state->sway_ipc, SWAY_MSG_RUN_COMMAND, cmd, len,
+        _print_command_reply, state
+    );
+}
+
+static void _check_reply(struct json_tape *tape, struct sway_ipc_msg *msg) {
+    if (json_tape_parse(tape, msg->payload, msg->length) != 0) {
+        LOG_WARN("Could not parse command reply.");
+        return;
+    }
+
+    const struct json_node *result = json_node_at(json_tape_root(tape), 0);
+    if (!json_node_is(json_node_get(result, "success"), JSON_NODE_TRUE)) {
+        const char *err = json_node_string(json_node_get(result, "error"));
+        LOG_WARN("Resize failed: %s", err != NULL ? err : msg->payload);
+    }
+}
+
+static void _handle_command_reply(void *data, struct sway_ipc_msg *msg) {
+    struct state *state = data;
+    trace_async_end("resize_command", state->live.commands_replied++);
+    state->live.command_outstanding = false;
+
+    if (msg == NULL) {
+        LOG_ERR("Lost connection to Sway.");
+        state->running = false;
+        return;
+    }
+
+    _check_reply(&state->live.reply_tape, msg);
+
+    // Sizes coalesced while the command was in flight get their own frame.
+    if (state->running &&
+        (state->live.pending_width >= 0 || state->live.pending_height >= 0)) {
+        request_frame(state);
+    }
+}
+
+void live_send_pending(struct state *state) {
+    struct live_resize *live = &state->live;
+    if (live->command_outstanding ||
+        (live->pending_width < 0 && live->pending_height < 0)) {
+        return;
+    }
+
+    char cmd[256];
+    int  len = _write_criteria(state, cmd, sizeof(cmd));
+
+    len += snprintf(cmd + len, sizeof(cmd) - len, "resize set");
+    if (live->pending_width >= 0) {
+        len += snprintf(
+            cmd + len, sizeof(cmd) - len, " width %dpx", live->pending_width
+        );
+    }
+    if (live->pending_height >= 0) {
+        len += snprintf(
+            cmd + len, sizeof(cmd) - len, " height %dpx", live->pending_height
+        );
+    }
+
+    live->command_outstanding = true;
+    live->pending_width       = -1;
+    live->pending_height      = -1;
+
+    trace_async_begin("resize_command", live->commands_sent++);
+    if (sway_ipc_client_send(
+            &state->sway_ipc, SWAY_MSG_RUN_COMMAND, cmd, len,
+            _handle_command_reply, state
+        ) != 0) {
+        state->running = false;
+    }
+}
+
+void live_finish(struct state *state) {
+    sway_ipc_client_wait(&state->sway_ipc);
+
+    live_send_pending(state);
+    sway_ipc_client_wait(&state->sway_ipc);
+    json_tape_finish(&state->live.reply_tape);
+}
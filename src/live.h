@@ -0,0 +1,68 @@
+#ifndef __LIVE_H_INCLUDED__
+#define __LIVE_H_INCLUDED__
+
+#include "json_tape.h"
+#include "resize_params.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xkbcommon/xkbcommon.h>
+
+struct state;
+
+// Size change applied by the arrow keys in live mode.
+#define LIVE_STEP 16
+
+/*
+ * Live mode keeps the overlay up and resizes the window as keys are pressed.
+ *
+ * Resizes are applied to the local window model right away and the
+ * resulting size is sent to Sway from the next frame callback. At most one
+ * command is in flight: sizes requested while waiting for its reply are
+ * coalesced into the next one.
+ */
+struct live_resize {
+    bool             enabled;
+    bool             command_outstanding;
+    int32_t          pending_width;
+    int32_t          pending_height;
+    struct json_tape reply_tape;
+
+    // Trace ids of the commands, which are replied in order.
+    uint64_t commands_sent;
+    uint64_t commands_replied;
+};
+
+void live_init(struct live_resize *live, bool enabled);
+
+// Handle the keys specific to live mode. Return whether the key was used.
+bool live_handle_keysym(struct state *state, xkb_keysym_t key_sym);
+
+// Resize the window model with an applicable parameter and schedule the
+// command.
+void live_apply(
+    struct state *state, struct resize_parameter *param,
+    enum resize_direction direction
+);
+
+// Use a parameter picked with a key or the pointer. It is applied right away
+// in live mode, otherwise its command is sent and the overlay unmapped before
+// anything is torn down. Return whether the overlay stays up.
+bool live_select(
+    struct state *state, struct resize_parameter *param,
+    enum resize_direction direction
+);
+
+// Send a resize to a single size without waiting for the reply, which is
+// printed once received.
+int live_send_resize(
+    struct state *state, enum resize_direction direction, uint32_t size
+);
+
+// Send the coalesced resize if no other command is in flight.
+void live_send_pending(struct state *state);
+
+// Send what is still pending and wait for the replies.
+void live_finish(struct state *state);
+
+#endif
@@ -0,0 +1,130 @@
+#include "log.h"
+
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define LOG_RING_SIZE   256
+#define LOG_MSG_SIZE    256
+#define LOG_FLUSH_BATCH 32
+
+struct log_msg {
+    // Ring position + 1 once the message is written.
+    atomic_size_t  seq;
+    enum log_level level;
+    char           text[LOG_MSG_SIZE];
+};
+
+// Multiple producers, a single consumer at a time. Producers reserve a slot
+// by moving `head`, the flushing thread frees slots by moving `tail` once
+// they are written out.
+static struct {
+    atomic_size_t  head;
+    atomic_size_t  tail;
+    atomic_flag    flushing;
+    struct log_msg msgs[LOG_RING_SIZE];
+} ring = {
+    .flushing = ATOMIC_FLAG_INIT,
+};
+
+enum log_level log_verbosity = LOG_LEVEL_WARN;
+
+static const char *const prefixes[] = {
+    [LOG_LEVEL_ERR]   = "\x1b[31merr:\x1b[0m ",
+    [LOG_LEVEL_WARN]  = "\x1b[33mwarn:\x1b[0m ",
+    [LOG_LEVEL_INFO]  = "\x1b[34minfo:\x1b[0m ",
+    [LOG_LEVEL_DEBUG] = "\x1b[90mdebug:\x1b[0m ",
+};
+
+void log_set_verbosity(enum log_level level) {
+    log_verbosity = level;
+}
+
+static bool _reserve(size_t *pos) {
+    *pos = atomic_load(&ring.head);
+    do {
+        if (*pos - atomic_load(&ring.tail) >= LOG_RING_SIZE) {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak(&ring.head, pos, *pos + 1));
+
+    return true;
+}
+
+void log_write(enum log_level level, const char *fmt, ...) {
+    size_t pos;
+    while (!_reserve(&pos)) {
+        // Nobody flushed in a while, e.g. a burst during startup. Flush here
+        // or let the thread already flushing make room.
+        log_flush();
+        sched_yield();
+    }
+
+    struct log_msg *msg = &ring.msgs[pos % LOG_RING_SIZE];
+    msg->level          = level;
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(msg->text, sizeof(msg->text), fmt, args);
+    va_end(args);
+
+    atomic_store_explicit(&msg->seq, pos + 1, memory_order_release);
+
+    if (level == LOG_LEVEL_ERR) {
+        log_flush();
+    }
+}
+
+void log_flush() {
+    if (atomic_flag_test_and_set(&ring.flushing)) {
+        return;
+    }
+
+    size_t tail = atomic_load(&ring.tail);
+    while (true) {
+        struct iovec iov[LOG_FLUSH_BATCH * 3];
+        size_t       num_msgs = 0;
+
+        while (num_msgs < LOG_FLUSH_BATCH) {
+            struct log_msg *msg = &ring.msgs[tail % LOG_RING_SIZE];
+            if (atomic_load_explicit(&msg->seq, memory_order_acquire) !=
+                tail + 1) {
+                break;
+            }
+
+            iov[num_msgs * 3] = (struct iovec){
+                .iov_base = (void *)prefixes[msg->level],
+                .iov_len  = strlen(prefixes[msg->level]),
+            };
+            iov[num_msgs * 3 + 1] = (struct iovec){
+                .iov_base = msg->text,
+                .iov_len  = strlen(msg->text),
+            };
+            iov[num_msgs * 3 + 2] = (struct iovec){
+                .iov_base = "\n",
+                .iov_len  = 1,
+            };
+
+            num_msgs++;
+            tail++;
+        }
+
+        if (num_msgs == 0) {
+            break;
+        }
+
+        // Best effort, there is nowhere to report a failure to.
+        writev(STDERR_FILENO, iov, num_msgs * 3);
+        atomic_store(&ring.tail, tail);
+    }
+
+    atomic_flag_clear(&ring.flushing);
+}
+
+__attribute__((destructor)) static void _flush_at_exit() {
+    log_flush();
+}
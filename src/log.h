@@ -1,15 +1,49 @@
 #ifndef __LOG_H_INCLUDED__
 #define __LOG_H_INCLUDED__
 
-#include <stdio.h>
+#include <stdbool.h>
 
-#define LOG_ERR(msg, ...) \
-    fprintf(stderr, "\x1b[31merr:\x1b[0m " msg "\n", ##__VA_ARGS__)
+enum log_level {
+    LOG_LEVEL_ERR   = 0,
+    LOG_LEVEL_WARN  = 1,
+    LOG_LEVEL_INFO  = 2,
+    LOG_LEVEL_DEBUG = 3,
+};
 
-#define LOG_WARN(msg, ...) \
-    fprintf(stderr, "\x1b[33mwarn:\x1b[0m " msg "\n", ##__VA_ARGS__)
+// Most verbose level compiled in, set with the `log_level` meson option.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/*
+ * Messages are formatted into an in-memory ring buffer and written to stderr
+ * by `log_flush`, which the event loop calls before waiting for events and
+ * which also runs at exit. Errors flush the buffer right away.
+ *
+ * Messages more verbose than the runtime verbosity are not formatted, and
+ * those more verbose than LOG_LEVEL are compiled out.
+ */
+
+extern enum log_level log_verbosity;
+
+void log_set_verbosity(enum log_level level);
+void log_flush();
+
+void log_write(enum log_level level, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#define LOG_ENABLED(level) ((level) <= LOG_LEVEL && (level) <= log_verbosity)
+
+#define LOG_AT(level, msg, ...)                                                \
+    do {                                                                       \
+        if (LOG_ENABLED(level)) {                                              \
+            log_write(level, msg, ##__VA_ARGS__);                              \
+        }                                                                      \
+    } while (0)
 
-#define LOG_INFO(msg, ...) \
-    fprintf(stderr, "\x1b[34minfo:\x1b[0m " msg "\n", ##__VA_ARGS__)
+#define LOG_ERR(msg, ...)   LOG_AT(LOG_LEVEL_ERR, msg, ##__VA_ARGS__)
+#define LOG_WARN(msg, ...)  LOG_AT(LOG_LEVEL_WARN, msg, ##__VA_ARGS__)
+#define LOG_INFO(msg, ...)  LOG_AT(LOG_LEVEL_INFO, msg, ##__VA_ARGS__)
+#define LOG_DEBUG(msg, ...) LOG_AT(LOG_LEVEL_DEBUG, msg, ##__VA_ARGS__)
 
 #endif
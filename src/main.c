@@ -1,237 +1,60 @@
+#include "event_loop.h"
 #include "fractional-scale-v1-client-protocol.h"
+#include "frame.h"
+#include "hint.h"
+#include "json_tape.h"
+#include "layout.h"
+#include "live.h"
 #include "log.h"
-#include "render.h"
+#include "render_thread.h"
+#include "replay.h"
 #include "resize_params.h"
+#include "seat.h"
 #include "state.h"
+#include "stats.h"
+#include "stream.h"
 #include "surface_buffer.h"
 #include "sway_ipc.h"
 #include "sway_win.h"
+#include "trace.h"
 #include "viewporter-client-protocol.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 #include "xdg-output-unstable-v1-client-protocol.h"
 
 #include <cairo/cairo.h>
 #include <getopt.h>
-#include <jansson.h>
+#include <poll.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 #include <wayland-client-protocol.h>
 #include <wayland-client.h>
 #include <wayland-util.h>
-#include <xkbcommon/xkbcommon-keysyms.h>
-#include <xkbcommon/xkbcommon.h>
-
-static void send_frame(struct state *state) {
-    int32_t scale_120 = state->scale_120;
-    if (scale_120 == 0) {
-        // Falling back to the output scale if fractional scale is not received.
-        scale_120 =
-            (state->current_output == NULL ? 1 : state->current_output->scale) *
-            120;
-    }
-
-    struct surface_buffer *surface_buffer = get_next_buffer(
-        state->wl_shm, &state->surface_buffer_pool,
-        state->surface_width * scale_120 / 120,
-        state->surface_height * scale_120 / 120
-    );
-    if (surface_buffer == NULL) {
-        return;
-    }
-    surface_buffer->state = SURFACE_BUFFER_BUSY;
-
-    cairo_t *cairo = surface_buffer->cairo;
-    cairo_identity_matrix(cairo);
-    cairo_scale(cairo, scale_120 / 120.0, scale_120 / 120.0);
-
-    render(state, cairo);
-
-    wl_surface_set_buffer_scale(state->wl_surface, 1);
-
-    wl_surface_attach(state->wl_surface, surface_buffer->wl_buffer, 0, 0);
-    wp_viewport_set_destination(
-        state->wp_viewport, state->surface_width, state->surface_height
-    );
-    wl_surface_damage(
-        state->wl_surface, 0, 0, state->surface_width, state->surface_height
-    );
-    wl_surface_commit(state->wl_surface);
-}
-
-static void surface_callback_done(
-    void *data, struct wl_callback *callback, uint32_t callback_data
-) {
-    struct state *state = data;
-    send_frame(state);
-
-    wl_callback_destroy(state->wl_surface_callback);
-    state->wl_surface_callback = NULL;
-}
-
-const struct wl_callback_listener surface_callback_listener = {
-    .done = surface_callback_done,
-};
-
-static void request_frame(struct state *state) {
-    if (state->wl_surface_callback != NULL) {
-        return;
-    }
-
-    state->wl_surface_callback = wl_surface_frame(state->wl_surface);
-    wl_callback_add_listener(
-        state->wl_surface_callback, &surface_callback_listener, state
-    );
-    wl_surface_commit(state->wl_surface);
-}
 
 static void noop() {}
 
-static void handle_keyboard_keymap(
-    void *data, struct wl_keyboard *keyboard, uint32_t format, int fd,
-    uint32_t size
-) {
-    struct seat *seat = data;
-    if (seat->xkb_state != NULL) {
-        xkb_state_unref(seat->xkb_state);
-        seat->xkb_state = NULL;
-    }
-    if (seat->xkb_keymap != NULL) {
-        xkb_keymap_unref(seat->xkb_keymap);
-        seat->xkb_keymap = NULL;
-    }
-
-    switch (format) {
-    case WL_KEYBOARD_KEYMAP_FORMAT_NO_KEYMAP:
-        seat->xkb_keymap = xkb_keymap_new_from_names(
-            seat->xkb_context, NULL, XKB_KEYMAP_COMPILE_NO_FLAGS
-        );
-        break;
-
-    case WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1:;
-        void *buffer = mmap(NULL, size - 1, PROT_READ, MAP_PRIVATE, fd, 0);
-        if (buffer == MAP_FAILED) {
-            LOG_ERR("Could not mmap keymap data.");
-            return;
-        }
-
-        seat->xkb_keymap = xkb_keymap_new_from_buffer(
-            seat->xkb_context, buffer, size - 1, XKB_KEYMAP_FORMAT_TEXT_V1,
-            XKB_KEYMAP_COMPILE_NO_FLAGS
-        );
-
-        munmap(buffer, size - 1);
-        close(fd);
-        break;
-    }
-
-    seat->xkb_state = xkb_state_new(seat->xkb_keymap);
-}
-
-static void handle_keyboard_key(
-    void *data, struct wl_keyboard *keyboard, uint32_t serial, uint32_t time,
-    uint32_t key, uint32_t key_state
-) {
-    struct seat  *seat  = data;
-    struct state *state = seat->state;
-    char          text[64];
-
-    const xkb_keycode_t key_code = key + 8;
-    const xkb_keysym_t  key_sym =
-        xkb_state_key_get_one_sym(seat->xkb_state, key_code);
-    xkb_keysym_to_utf8(key_sym, text, sizeof(text));
-
-    if (key_state == WL_KEYBOARD_KEY_STATE_PRESSED) {
-        if (key_sym == XKB_KEY_Escape) {
-            state->running = false;
-        }
-
-        if (text[0] == '\0') {
-            return;
-        }
-
-        uint32_t rune;
-        str_to_rune(text, &rune);
-
-        struct resize_parameter *resize_param = find_resize_param_by_symbol(
-            state->resize_params, rune, &state->resize_direction
-        );
-        if (resize_param != NULL && resize_param->applicable) {
-            state->selected_resize = resize_param;
-            state->running         = false;
-        }
-    }
-}
-
-static void handle_keyboard_modifiers(
-    void *data, struct wl_keyboard *keyboard, uint32_t serial,
-    uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked,
-    uint32_t group
-) {
-    struct seat *seat = data;
-    xkb_state_update_mask(
-        seat->xkb_state, mods_depressed, mods_latched, mods_locked, 0, 0, group
-    );
-}
-
-static const struct wl_keyboard_listener wl_keyboard_listener = {
-    .keymap      = handle_keyboard_keymap,
-    .enter       = noop,
-    .leave       = noop,
-    .key         = handle_keyboard_key,
-    .modifiers   = handle_keyboard_modifiers,
-    .repeat_info = noop,
-};
-
-static void handle_seat_capabilities(
-    void *data, struct wl_seat *wl_seat, uint32_t capabilities
-) {
-    struct seat *seat = data;
-    if (capabilities & WL_SEAT_CAPABILITY_KEYBOARD) {
-        seat->wl_keyboard = wl_seat_get_keyboard(seat->wl_seat);
-        wl_keyboard_add_listener(
-            seat->wl_keyboard, &wl_keyboard_listener, data
-        );
+static void destroy_output(struct output *output) {
+    if (output->xdg_output != NULL) {
+        zxdg_output_v1_destroy(output->xdg_output);
     }
-}
-
-const struct wl_seat_listener wl_seat_listener = {
-    .name         = noop,
-    .capabilities = handle_seat_capabilities,
-};
-
-static void free_seats(struct wl_list *seats) {
-    struct seat *seat;
-    struct seat *tmp;
-    wl_list_for_each_safe (seat, tmp, seats, link) {
-        if (seat->wl_keyboard != NULL) {
-            wl_keyboard_destroy(seat->wl_keyboard);
-        }
-
-        if (seat->xkb_state != NULL) {
-            xkb_state_unref(seat->xkb_state);
-        }
-        if (seat->xkb_keymap != NULL) {
-            xkb_keymap_unref(seat->xkb_keymap);
-        }
-        xkb_context_unref(seat->xkb_context);
-
-        wl_seat_destroy(seat->wl_seat);
-        wl_list_remove(&seat->link);
-        free(seat);
+    if (wl_output_get_version(output->wl_output) >= 3) {
+        wl_output_release(output->wl_output);
+    } else {
+        wl_output_destroy(output->wl_output);
     }
+    wl_list_remove(&output->link);
+    free(output->name);
+    free(output);
 }
 
 static void free_outputs(struct wl_list *outputs) {
     struct output *output;
     struct output *tmp;
     wl_list_for_each_safe (output, tmp, outputs, link) {
-        wl_output_destroy(output->wl_output);
-        zxdg_output_v1_destroy(output->xdg_output);
-        wl_list_remove(&output->link);
-        free(output->name);
-        free(output);
+        destroy_output(output);
     }
 }
 
@@ -263,13 +86,40 @@ static void handle_output_geometry(
     output->transform     = transform;
 }
 
+static void handle_output_mode(
+    void *data, struct wl_output *wl_output, uint32_t flags, int32_t width,
+    int32_t height, int32_t refresh
+) {
+    struct output *output = data;
+    if (flags & WL_OUTPUT_MODE_CURRENT) {
+        output->mode_width  = width;
+        output->mode_height = height;
+    }
+}
+
+static void
+handle_output_name(void *data, struct wl_output *wl_output, const char *name) {
+    struct output *output = data;
+    free(output->name);
+    output->name = strdup(name);
+}
+
+static void handle_output_ready(struct output *output);
+
+static void handle_output_done(void *data, struct wl_output *wl_output) {
+    struct output *output = data;
+    if (output->name != NULL) {
+        handle_output_ready(output);
+    }
+}
+
 const static struct wl_output_listener output_listener = {
-    .name        = noop,
+    .name        = handle_output_name,
     .geometry    = handle_output_geometry,
-    .mode        = noop,
+    .mode        = handle_output_mode,
     .scale       = handle_output_scale,
     .description = noop,
-    .done        = noop,
+    .done        = handle_output_done,
 };
 
 static void handle_xdg_output_logical_position(
@@ -292,20 +142,40 @@ static void handle_xdg_output_name(
     void *data, struct zxdg_output_v1 *xdg_output, const char *name
 ) {
     struct output *output = data;
-    output->name          = strdup(name);
+    free(output->name);
+    output->name = strdup(name);
+}
+
+static void
+handle_xdg_output_done(void *data, struct zxdg_output_v1 *xdg_output) {
+    struct output *output = data;
+    if (output->name != NULL) {
+        handle_output_ready(output);
+    }
 }
 
 const static struct zxdg_output_v1_listener xdg_output_listener = {
     .logical_position = handle_xdg_output_logical_position,
     .logical_size     = handle_xdg_output_logical_size,
-    .done             = noop,
+    .done             = handle_xdg_output_done,
     .name             = handle_xdg_output_name,
     .description      = noop,
 };
 
-static void load_xdg_outputs(struct state *state) {
+// wl_output only sends its name from version 4, older compositors need an
+// xdg_output for each output to find the one to use.
+static int load_xdg_outputs(struct state *state) {
     struct output *output;
     wl_list_for_each (output, &state->outputs, link) {
+        if (wl_output_get_version(output->wl_output) >= 4) {
+            continue;
+        }
+
+        if (state->xdg_output_manager == NULL) {
+            LOG_ERR("Failed to get xdg_output_manager object.");
+            return -1;
+        }
+
         output->xdg_output = zxdg_output_manager_v1_get_xdg_output(
             state->xdg_output_manager, output->wl_output
         );
@@ -314,7 +184,31 @@ static void load_xdg_outputs(struct state *state) {
         );
     }
 
-    wl_display_roundtrip(state->wl_display);
+    return 0;
+}
+
+// The first buffer covers the output. Map it before the surface is configured
+// so it can be prefaulted in the meantime. The current mode is the buffer
+// size with fractional scaling, one more pixel absorbs rounding.
+static void reserve_first_buffer(struct state *state) {
+    struct output *output = state->current_output;
+    int32_t        width  = output->mode_width;
+    int32_t        height = output->mode_height;
+    if (output->transform & WL_OUTPUT_TRANSFORM_90) { // 90 or 270 degrees
+        width  = output->mode_height;
+        height = output->mode_width;
+    }
+    if (width <= 0 || height <= 0) {
+        width  = output->width * output->scale;
+        height = output->height * output->scale;
+    }
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    surface_buffer_pool_reserve(
+        &state->surface_buffer_pool, width + 1, height + 1
+    );
 }
 
 static void handle_surface_enter(
@@ -323,7 +217,9 @@ static void handle_surface_enter(
     struct state  *state = data;
     struct output *output =
         find_output_from_wl_output(&state->outputs, wl_output);
-    state->current_output = output;
+    if (output != NULL) {
+        state->current_output = output;
+    }
 }
 
 static const struct wl_surface_listener surface_listener = {
@@ -351,26 +247,25 @@ static void handle_registry_global(
             wl_registry_bind(registry, name, &zwlr_layer_shell_v1_interface, 2);
 
     } else if (strcmp(interface, wl_seat_interface.name) == 0) {
-        struct seat *seat = calloc(1, sizeof(struct seat));
-        seat->wl_seat = wl_registry_bind(registry, name, &wl_seat_interface, 7);
-        seat->wl_keyboard = NULL;
-        seat->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-        seat->xkb_state   = NULL;
-        seat->xkb_keymap  = NULL;
-        seat->state       = state;
-
-        wl_seat_add_listener(seat->wl_seat, &wl_seat_listener, seat);
-        wl_list_insert(&state->seats, &seat->link);
+        struct seat *seat = seat_create(
+            state, wl_registry_bind(registry, name, &wl_seat_interface, 7)
+        );
+        if (seat != NULL) {
+            wl_list_insert(&state->seats, &seat->link);
+        }
 
     } else if (strcmp(interface, wl_output_interface.name) == 0) {
-        struct wl_output *wl_output =
-            wl_registry_bind(registry, name, &wl_output_interface, 3);
+        struct wl_output *wl_output = wl_registry_bind(
+            registry, name, &wl_output_interface, min(version, 4)
+        );
         struct output *output = calloc(1, sizeof(struct output));
+        output->state         = state;
         output->wl_output     = wl_output;
         output->scale         = 1;
 
         wl_output_add_listener(output->wl_output, &output_listener, output);
         wl_list_insert(&state->outputs, &output->link);
+        state->pending_outputs++;
 
     } else if (strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
         state->xdg_output_manager = wl_registry_bind(
@@ -386,6 +281,12 @@ static void handle_registry_global(
         state->fractional_scale_mgr = wl_registry_bind(
             registry, name, &wp_fractional_scale_manager_v1_interface, 1
         );
+    } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        latency_bind(&state->latency, registry, name);
+    } else if (strcmp(
+                   interface, zwlr_screencopy_manager_v1_interface.name
+               ) == 0) {
+        preview_bind(&state->preview, registry, name, version);
     }
 }
 
@@ -404,7 +305,10 @@ static void handle_layer_surface_configure(
     zwlr_layer_surface_v1_ack_configure(layer_surface, serial);
 
     if (!state->surface_configured) {
-        send_frame(state);
+        trace_async_end("first_configure", 0);
+        if (!preview_capturing(&state->preview)) {
+            send_frame(state);
+        }
     }
     state->surface_configured = true;
 }
@@ -437,23 +341,321 @@ const struct wp_fractional_scale_v1_listener fractional_scale_listener = {
     .preferred_scale = fractional_scale_preferred,
 };
 
-static struct output *
-find_output_by_name(struct state *state, const char *name) {
+static void create_surface(struct state *state) {
+    if (state->surface_buffer_pool.flags != 0) {
+        reserve_first_buffer(state);
+    }
+
+    state->wl_surface = wl_compositor_create_surface(state->wl_compositor);
+    wl_surface_add_listener(state->wl_surface, &surface_listener, state);
+    state->wl_layer_surface = zwlr_layer_shell_v1_get_layer_surface(
+        state->wl_layer_shell, state->wl_surface,
+        state->current_output->wl_output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY,
+        "selection"
+    );
+    zwlr_layer_surface_v1_add_listener(
+        state->wl_layer_surface, &wl_layer_surface_listener, state
+    );
+    zwlr_layer_surface_v1_set_exclusive_zone(state->wl_layer_surface, -1);
+    zwlr_layer_surface_v1_set_anchor(
+        state->wl_layer_surface, ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+                                     ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT |
+                                     ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
+                                     ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM
+    );
+    zwlr_layer_surface_v1_set_keyboard_interactivity(
+        state->wl_layer_surface, true
+    );
+
+    if (state->fractional_scale_mgr) {
+        state->fractional_scale =
+            wp_fractional_scale_manager_v1_get_fractional_scale(
+                state->fractional_scale_mgr, state->wl_surface
+            );
+        wp_fractional_scale_v1_add_listener(
+            state->fractional_scale, &fractional_scale_listener, state
+        );
+    }
+
+    state->wp_viewport =
+        wp_viewporter_get_viewport(state->wp_viewporter, state->wl_surface);
+
+    wl_surface_commit(state->wl_surface);
+    trace_async_begin("first_configure", 0);
+}
+
+// Called when an output is named and when the focused output is known. The
+// surface is created as soon as the output of the focused workspace shows
+// up, other outputs are released.
+static void select_output(struct state *state) {
+    if (state->output_name == NULL) {
+        return;
+    }
+
     struct output *output;
-    wl_list_for_each (output, &state->outputs, link) {
-        if (strcmp(output->name, name) == 0) {
-            return output;
+    struct output *tmp;
+    wl_list_for_each_safe (output, tmp, &state->outputs, link) {
+        if (!output->ready || output == state->current_output) {
+            continue;
+        }
+
+        if (state->current_output == NULL &&
+            strcmp(output->name, state->output_name) == 0) {
+            trace_async_end("output_wait", 0);
+            state->current_output = output;
+        } else {
+            destroy_output(output);
         }
     }
 
-    return NULL;
+    if (state->current_output == NULL) {
+        if (state->pending_outputs == 0) {
+            LOG_ERR("Could not find output '%s'.", state->output_name);
+            state->running = false;
+        }
+        return;
+    }
+
+    // The preview is captured before the overlay is mapped, from the window
+    // found in the tree.
+    if (state->wl_surface == NULL &&
+        (!state->preview.enabled || state->focused_window_ready)) {
+        preview_capture(state);
+        create_surface(state);
+    }
+}
+
+static void handle_output_ready(struct output *output) {
+    struct state *state = output->state;
+    if (output->ready) {
+        return;
+    }
+    output->ready = true;
+    state->pending_outputs--;
+
+    select_output(state);
+}
+
+// The workspaces are much smaller than the tree and requested first, they
+// tell the output to show the first frame on while the tree is received.
+static void handle_workspaces_reply(void *data, struct sway_ipc_msg *msg) {
+    struct state *state = data;
+    trace_async_end("workspaces_receive", 0);
+
+    if (msg == NULL) {
+        LOG_ERR("Could not receive workspaces message.");
+        return;
+    }
+
+    struct json_tape tape;
+    json_tape_init(&tape);
+    const char *output = NULL;
+    if (json_tape_parse(&tape, msg->payload, msg->length) == 0) {
+        output = find_focused_output(json_tape_root(&tape));
+    }
+    if (output != NULL) {
+        state->output_name = strdup(output);
+    }
+    json_tape_finish(&tape);
+
+    if (state->output_name == NULL) {
+        LOG_WARN("Could not find focused output, waiting for the tree.");
+        return;
+    }
+
+    select_output(state);
+}
+
+static void handle_tree_reply(void *data, struct sway_ipc_msg *msg) {
+    struct state *state = data;
+    trace_async_end("tree_receive", 0);
+
+    if (msg == NULL) {
+        LOG_ERR("Could not receive tree message.");
+        return;
+    }
+
+    trace_begin("json_parse");
+    struct json_tape tape;
+    json_tape_init(&tape);
+    int err = json_tape_parse(&tape, msg->payload, msg->length);
+    trace_end("json_parse");
+    if (err) {
+        LOG_ERR("Could not parse tree at offset %zu.", tape.error_offset);
+        json_tape_finish(&tape);
+        return;
+    }
+
+    trace_begin("find_focused_window");
+    err = find_visible_windows(
+        &state->focused_window,
+        state->hint.enabled ? &state->hint.visible : NULL,
+        json_tape_root(&tape)
+    );
+    trace_end("find_focused_window");
+    json_tape_finish(&tape);
+
+    if (err) {
+        LOG_ERR("Could not find focused window.");
+        return;
+    }
+
+    state->focused_window_ready = true;
+}
+
+// The window and its guides are drawn in the frame following the first one.
+static void handle_overlay_tree_reply(void *data, struct sway_ipc_msg *msg) {
+    struct state *state = data;
+    handle_tree_reply(state, msg);
+    if (!state->focused_window_ready) {
+        state->running = false;
+        return;
+    }
+
+    const char *output = state->focused_window.output;
+    if (output == NULL) {
+        LOG_ERR("Could not find output of the focused window.");
+        state->running = false;
+        return;
+    }
+    if (state->output_name == NULL) {
+        state->output_name = strdup(output);
+    } else if (strcmp(output, state->output_name) != 0) {
+        LOG_ERR("Focus moved to output '%s'.", output);
+        state->running = false;
+        return;
+    }
+
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
+        log_focused_window(&state->focused_window);
+    }
+
+    // The guides are computed once a window is picked.
+    hint_start(state);
+    if (!state->hint.picking) {
+        trace_begin("compute_guides");
+        resize_parameters_compute_guides(
+            state->resize_params, &state->focused_window
+        );
+        trace_end("compute_guides");
+        if (LOG_ENABLED(LOG_LEVEL_DEBUG)) {
+            log_resize_params(state->resize_params);
+        }
+    }
+
+    select_output(state);
+    if (state->surface_configured) {
+        request_frame(state);
+    }
+    seats_replay_events(state);
+}
+
+static void handle_command_reply(void *data, struct sway_ipc_msg *msg) {
+    trace_end("resize_command");
+
+    if (msg == NULL) {
+        LOG_ERR("Could not receive command reply.");
+        return;
+    }
+
+    puts(msg->payload);
+}
+
+// Resize to the guide with the given symbol without connecting to Wayland.
+static int apply_guide(struct state *state, uint32_t symbol) {
+    enum resize_direction    direction;
+    struct resize_parameter *param =
+        find_resize_param_by_symbol(state->resize_params, symbol, &direction);
+    if (param == NULL) {
+        LOG_ERR("No guide matches the symbol to apply.");
+        return 1;
+    }
+
+    trace_begin("compute_guides");
+    bool applicable = resize_parameter_compute_guides(
+        param, &state->focused_window, direction
+    );
+    trace_end("compute_guides");
+    if (!applicable) {
+        LOG_ERR("The guide to apply does not fit the focused window.");
+        return 1;
+    }
+
+    if (live_send_resize(state, direction, param->size) != 0) {
+        return 1;
+    }
+    return sway_ipc_client_wait(&state->sway_ipc) != 0;
+}
+
+// Resize all the siblings of the focused window with a single command.
+static int apply_layout(struct state *state, struct layout_preset *preset) {
+    struct siblings *siblings = &state->focused_window.siblings;
+    int32_t          sizes[SWAY_WIN_MAX_SIBLINGS];
+    if (layout_preset_compute(preset, siblings, sizes) != 0) {
+        return 1;
+    }
+
+    char *cmd = layout_command(siblings, sizes);
+    if (cmd == NULL) {
+        return 1;
+    }
+    if (cmd[0] == '\0') {
+        LOG_INFO("The windows already have the sizes of the layout.");
+        free(cmd);
+        return 0;
+    }
+
+    trace_begin("resize_command");
+    sway_ipc_client_send(
+        &state->sway_ipc, SWAY_MSG_RUN_COMMAND, cmd, strlen(cmd),
+        handle_command_reply, NULL
+    );
+    free(cmd);
+
+    return sway_ipc_client_wait(&state->sway_ipc) != 0;
+}
+
+static void handle_keymap_event(void *data, int fd, short revents) {
+    seats_handle_compiled_keymaps(data);
+}
+
+static void handle_key_repeat(void *data, int fd, short revents) {
+    seats_handle_key_repeat(data);
+}
+
+static void handle_render_event(void *data, int fd, short revents) {
+    commit_frame(data);
 }
 
 static void print_usage() {
     puts("sway-resize [OPTION...]\n");
 
-    puts(" -h, --help          show this help");
-    puts(" -v, --version       print version and exit");
+    puts(" -h, --help                show this help");
+    puts(" -v, --version             print version and exit");
+    puts(" -V, --verbose             log more, repeat for debug logs");
+    puts(" -g, --guides GUIDES       guiding lines to show");
+    puts(" -l, --live                keep the overlay up, resize on key press");
+    puts("                           arrow keys resize step by step");
+    puts(" -j, --render-threads N    render tiles on N threads (0: all CPUs)");
+    puts(" -a, --apply GUIDE         resize to a guide without the overlay");
+    puts("                           GUIDE is a symbol from -g or e.g. h:50%");
+    puts("     --stdin               apply each guide read from stdin");
+    puts("     --layout PRESET       resize the window and all its siblings");
+    puts("                           PRESET: equal, golden or fixed:640,30%");
+    puts("     --hint                pick the window to resize by its label");
+    puts("     --tree FILE           render the overlay for a saved tree,");
+    puts("                           without connecting to Sway or Wayland");
+    puts("     --output-size WxH     size of the output for --tree");
+    puts("     --scale S             scale of the output for --tree");
+    puts("     --render-to FILE      write the --tree rendering as PNG");
+    puts("     --trace FILE          write a Chrome trace of the run to FILE");
+    puts("     --stats               print a summary of the work done on exit");
+    puts("     --system-font         draw symbols missing from the embedded");
+    puts("                           font with the system monospace font");
+    puts("     --prefault            fault buffers in before the first frame");
+    puts("     --huge-pages          back buffers with huge pages if possible");
+    puts("     --latency             report when frames reached the screen");
+    puts("     --preview             show the window content at the new size");
 }
 
 static void print_version() {
@@ -471,26 +673,62 @@ int main(int argc, char **argv) {
         .wl_surface_callback  = NULL,
         .wl_layer_surface     = NULL,
         .surface_configured   = false,
+        .system_font          = false,
         .wp_viewporter        = NULL,
         .fractional_scale_mgr = NULL,
         .running              = true,
         .scale_120            = 0,
         .selected_resize      = NULL,
+        .key_repeat_fd        = -1,
+        .repeat_seat          = NULL,
     };
 
     static struct option long_options[] = {
         {"help", no_argument, 0, 'h'},
         {"help-config", no_argument, 0, 'H'},
         {"version", no_argument, 0, 'v'},
+        {"verbose", no_argument, 0, 'V'},
         {"guides", required_argument, 0, 'g'},
+        {"apply", required_argument, 0, 'a'},
+        {"stdin", no_argument, 0, 'S'},
+        {"layout", required_argument, 0, 'O'},
+        {"hint", no_argument, 0, 'I'},
+        {"live", no_argument, 0, 'l'},
+        {"render-threads", required_argument, 0, 'j'},
+        {"tree", required_argument, 0, 'E'},
+        {"output-size", required_argument, 0, 'Z'},
+        {"scale", required_argument, 0, 'K'},
+        {"render-to", required_argument, 0, 'W'},
+        {"trace", required_argument, 0, 'T'},
+        {"stats", no_argument, 0, 'M'},
+        {"system-font", no_argument, 0, 'F'},
+        {"prefault", no_argument, 0, 'P'},
+        {"huge-pages", no_argument, 0, 'U'},
+        {"latency", no_argument, 0, 'L'},
+        {"preview", no_argument, 0, 'C'},
+        {0, 0, 0, 0},
     };
 
-    char *guides_string = NULL;
-    int   option_char   = 0;
-    int   option_index  = 0;
-    while ((option_char =
-                getopt_long(argc, argv, "hvg:", long_options, &option_index)) !=
-           EOF) {
+    struct layout_preset  layout_preset;
+    struct replay_options replay = {
+        .scale = 1,
+    };
+
+    char *guides_string  = NULL;
+    long  render_threads = 1;
+    bool  live           = false;
+    int   shm_flags      = 0;
+    bool  latency        = false;
+    bool  preview        = false;
+    char *apply_spec     = NULL;
+    bool  stream         = false;
+    bool  layout         = false;
+    bool  hint           = false;
+    int   option_char    = 0;
+    int   option_index   = 0;
+    while ((option_char = getopt_long(
+                argc, argv, "hvVg:a:lj:", long_options, &option_index
+            )) != EOF) {
         switch (option_char) {
         case 'h':
             print_usage();
@@ -500,10 +738,119 @@ int main(int argc, char **argv) {
             print_version();
             return 0;
 
+        case 'V':
+            if (log_verbosity < LOG_LEVEL_DEBUG) {
+                log_set_verbosity(log_verbosity + 1);
+            }
+            break;
+
         case 'g':
             guides_string = strdup(optarg);
             break;
 
+        case 'a':
+            apply_spec = optarg;
+            break;
+
+        case 'l':
+            live = true;
+            break;
+
+        case 'S':
+            stream = true;
+            break;
+
+        case 'O':
+            if (layout_preset_parse(&layout_preset, optarg) != 0) {
+                LOG_ERR("Invalid layout preset.");
+                return 1;
+            }
+            layout = true;
+            break;
+
+        case 'I':
+            hint = true;
+            break;
+
+        case 'E':
+            replay.tree_path = optarg;
+            break;
+
+        case 'Z':
+            if (sscanf(optarg, "%dx%d", &replay.width, &replay.height) != 2 ||
+                replay.width <= 0 || replay.height <= 0) {
+                LOG_ERR("Invalid output size.");
+                return 1;
+            }
+            break;
+
+        case 'K':
+            replay.scale = strtod(optarg, NULL);
+            if (replay.scale <= 0) {
+                LOG_ERR("Invalid scale.");
+                return 1;
+            }
+            break;
+
+        case 'W':
+            replay.png_path = optarg;
+            break;
+
+        case 'T':
+            if (trace_init(optarg) != 0) {
+                return 1;
+            }
+            break;
+
+        case 'M':
+            if (stats_init() != 0) {
+                return 1;
+            }
+            break;
+
+        case 'F':
+            state.system_font = true;
+            break;
+
+        case 'P':
+            shm_flags |= SHM_PREFAULT;
+            break;
+
+        case 'U':
+            shm_flags |= SHM_HUGE_PAGES;
+            break;
+
+        case 'L':
+            latency = true;
+            break;
+
+        case 'C':
+            preview = true;
+            break;
+
+        case 'j': {
+            char *end;
+            render_threads = strtol(optarg, &end, 10);
+            if (end == optarg || *end != '\0' || render_threads < 0 ||
+                render_threads > RENDER_POOL_MAX_THREADS) {
+                LOG_ERR(
+                    "Invalid number of render threads, expected 0 to %d.",
+                    RENDER_POOL_MAX_THREADS
+                );
+                return 1;
+            }
+            if (render_threads == 0) {
+                render_threads = sysconf(_SC_NPROCESSORS_ONLN);
+                if (render_threads < 1) {
+                    render_threads = 1;
+                }
+                if (render_threads > RENDER_POOL_MAX_THREADS) {
+                    render_threads = RENDER_POOL_MAX_THREADS;
+                }
+            }
+            break;
+        }
+
         default:
             LOG_ERR("Unknown argument.");
             return 1;
@@ -513,49 +860,143 @@ int main(int argc, char **argv) {
     wl_list_init(&state.outputs);
     wl_list_init(&state.seats);
 
-    if (guides_string == NULL) {
+    live_init(&state.live, live);
+    hint_init(&state.hint, hint);
+    latency_init(&state.latency, latency);
+    preview_init(&state.preview, preview);
+
+    // A guide given inline, with or without symbol, replaces the guides.
+    uint32_t apply_symbol = 0;
+    if (apply_spec != NULL && strchr(apply_spec, ':') != NULL) {
+        free(guides_string);
+        if (strchr(strchr(apply_spec, ':') + 1, ':') != NULL) {
+            guides_string = strdup(apply_spec);
+        } else {
+            guides_string = malloc(strlen(apply_spec) + 3);
+            sprintf(guides_string, "=:%s", apply_spec);
+        }
+        apply_spec = guides_string;
+    }
+    if (apply_spec != NULL && str_to_rune(apply_spec, &apply_symbol) <= 0) {
+        LOG_ERR("Invalid guide to apply.");
+        return 1;
+    }
+
+    // Guides read from stdin can be given in full, layouts don't use them.
+    if (guides_string == NULL && !stream && !layout) {
         LOG_ERR("Guides need to be set with -g.");
         return 1;
     }
 
-    state.resize_params = load_resize_parameters(guides_string);
-    free(guides_string);
+    if (guides_string != NULL) {
+        state.resize_params = load_resize_parameters(guides_string);
+        free(guides_string);
 
-    if (state.resize_params == NULL) {
-        LOG_ERR("Failed to load resize guides");
-        return 1;
+        if (state.resize_params == NULL) {
+            LOG_ERR("Failed to load resize guides");
+            return 1;
+        }
     }
 
-    int sway_ipc_socket = sway_ipc_open_socket();
-    if (sway_ipc_socket < 0) {
+    if (replay.tree_path != NULL) {
+        replay.num_threads = render_threads;
+        int err            = replay_render(&state, &replay);
+        hint_finish(&state.hint);
+        free_resize_params(state.resize_params);
+        return err != 0;
+    }
+
+    trace_begin("ipc_connect");
+    int sway_ipc_fd = sway_ipc_open_socket();
+    trace_end("ipc_connect");
+    if (sway_ipc_fd < 0) {
         LOG_ERR("Could not open Sway socket.");
         return 1;
     }
 
-    sway_ipc_send(sway_ipc_socket, SWAY_MSG_GET_TREE, "", 0);
-    struct sway_ipc_msg *sway_tree_msg = sway_ipc_recv(sway_ipc_socket);
-    if (sway_tree_msg == NULL) {
-        LOG_ERR("Could not receive tree message.");
+    if (sway_ipc_client_init(&state.sway_ipc, sway_ipc_fd) != 0) {
         return 1;
     }
 
-    json_error_t error;
-    json_t      *sway_tree = json_loads(sway_tree_msg->payload, 0, &error);
-    if (sway_tree == NULL) {
-        LOG_ERR("Could not parse tree.");
-        return 1;
+    // The overlay is shown before the tree is received, on the output of the
+    // focused workspace. The other modes need the tree first.
+    bool overlay = apply_symbol == 0 && !layout && !stream;
+    if (overlay) {
+        trace_async_begin("workspaces_receive", 0);
+        sway_ipc_client_send(
+            &state.sway_ipc, SWAY_MSG_GET_WORKSPACES, "", 0,
+            handle_workspaces_reply, &state
+        );
+        trace_async_begin("tree_receive", 0);
+        sway_ipc_client_send(
+            &state.sway_ipc, SWAY_MSG_GET_TREE, "", 0,
+            handle_overlay_tree_reply, &state
+        );
+    } else {
+        trace_async_begin("tree_receive", 0);
+        sway_ipc_client_send(
+            &state.sway_ipc, SWAY_MSG_GET_TREE, "", 0, handle_tree_reply,
+            &state
+        );
+        sway_ipc_client_wait(&state.sway_ipc);
+        if (!state.focused_window_ready) {
+            return 1;
+        }
     }
 
-    free(sway_tree_msg);
+    if (apply_symbol != 0) {
+        int err = apply_guide(&state, apply_symbol);
+        sway_ipc_client_finish(&state.sway_ipc);
+        free((void *)state.focused_window.output);
+        free_resize_params(state.resize_params);
+        return err;
+    }
 
-    int err = find_focused_window(&state.focused_window, sway_tree);
-    if (err) {
-        LOG_ERR("Could not find focused window.");
+    if (layout) {
+        int err = apply_layout(&state, &layout_preset);
+        sway_ipc_client_finish(&state.sway_ipc);
+        free((void *)state.focused_window.output);
+        if (state.resize_params != NULL) {
+            free_resize_params(state.resize_params);
+        }
+        return err;
+    }
+
+    if (stream) {
+        struct stream stdin_stream;
+        int           err = stream_init(
+            &stdin_stream, STDIN_FILENO, &state.sway_ipc, state.resize_params,
+            &state.focused_window
+        );
+        if (err == 0) {
+            err = stream_run(&stdin_stream);
+        }
+        stream_finish(&stdin_stream);
+        sway_ipc_client_finish(&state.sway_ipc);
+        free((void *)state.focused_window.output);
+        if (state.resize_params != NULL) {
+            free_resize_params(state.resize_params);
+        }
+        return err != 0;
+    }
+
+    state.keymap_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (state.keymap_event_fd < 0) {
+        LOG_ERR("Could not create keymap eventfd.");
         return 1;
     }
-    json_decref(sway_tree);
 
+    if (live) {
+        state.key_repeat_fd =
+            timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        if (state.key_repeat_fd < 0) {
+            LOG_WARN("Could not create key repeat timer, keys won't repeat.");
+        }
+    }
+
+    trace_begin("wl_connect");
     state.wl_display = wl_display_connect(NULL);
+    trace_end("wl_connect");
     if (state.wl_display == NULL) {
         LOG_ERR("Failed to connect to Wayland compositor.");
         return 1;
@@ -568,7 +1009,9 @@ int main(int argc, char **argv) {
     }
 
     wl_registry_add_listener(state.wl_registry, &wl_registry_listener, &state);
+    trace_begin("registry_roundtrip");
     wl_display_roundtrip(state.wl_display);
+    trace_end("registry_roundtrip");
 
     if (state.wl_compositor == NULL) {
         LOG_ERR("Failed to get wl_compositor object.");
@@ -585,87 +1028,79 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    if (state.xdg_output_manager == NULL) {
-        LOG_ERR("Failed to get xdg_output_manager object.");
-        return 1;
-    }
-
     if (state.wp_viewporter == NULL) {
         LOG_ERR("Failed to get wp_viewporter object.");
         return 1;
     }
 
-    load_xdg_outputs(&state);
-
-    // This round trip should load the keymap which is needed to determine the
-    // home row keys.
-    wl_display_roundtrip(state.wl_display);
-
-    state.current_output =
-        find_output_by_name(&state, state.focused_window.output);
-
-    if (!state.current_output) {
-        LOG_ERR("Could not find output '%s'.", state.focused_window.output);
+    if (state.pending_outputs == 0) {
+        LOG_ERR("No output found.");
         return 1;
     }
 
-    log_focused_window(&state.focused_window);
-
-    resize_parameters_compute_guides(
-        state.resize_params, &state.focused_window
-    );
-    log_resize_params(state.resize_params);
+    if (load_xdg_outputs(&state) != 0) {
+        return 1;
+    }
 
-    surface_buffer_pool_init(&state.surface_buffer_pool);
+    surface_buffer_pool_init(&state.surface_buffer_pool, shm_flags);
+    if (render_thread_init(&state.render_thread, render_threads) != 0) {
+        return 1;
+    }
 
-    state.wl_surface = wl_compositor_create_surface(state.wl_compositor);
-    wl_surface_add_listener(state.wl_surface, &surface_listener, &state);
-    state.wl_layer_surface = zwlr_layer_shell_v1_get_layer_surface(
-        state.wl_layer_shell, state.wl_surface,
-        state.current_output == NULL ? NULL : state.current_output->wl_output,
-        ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, "selection"
+    struct event_loop event_loop;
+    event_loop_init(&event_loop, state.wl_display);
+    event_loop_add_fd(
+        &event_loop, state.keymap_event_fd, POLLIN, handle_keymap_event, &state
     );
-    zwlr_layer_surface_v1_add_listener(
-        state.wl_layer_surface, &wl_layer_surface_listener, &state
-    );
-    zwlr_layer_surface_v1_set_exclusive_zone(state.wl_layer_surface, -1);
-    zwlr_layer_surface_v1_set_anchor(
-        state.wl_layer_surface, ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
-                                    ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT |
-                                    ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
-                                    ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM
-    );
-    zwlr_layer_surface_v1_set_keyboard_interactivity(
-        state.wl_layer_surface, true
-    );
-
-    struct wp_fractional_scale_v1 *fractional_scale = NULL;
-    if (state.fractional_scale_mgr) {
-        fractional_scale = wp_fractional_scale_manager_v1_get_fractional_scale(
-            state.fractional_scale_mgr, state.wl_surface
-        );
-        wp_fractional_scale_v1_add_listener(
-            fractional_scale, &fractional_scale_listener, &state
+    if (state.key_repeat_fd >= 0) {
+        event_loop_add_fd(
+            &event_loop, state.key_repeat_fd, POLLIN, handle_key_repeat, &state
         );
     }
+    event_loop_add_fd(
+        &event_loop, state.render_thread.event_fd, POLLIN, handle_render_event,
+        &state
+    );
+    sway_ipc_client_attach(&state.sway_ipc, &event_loop);
 
-    state.wp_viewport =
-        wp_viewporter_get_viewport(state.wp_viewporter, state.wl_surface);
+    // The output names, the workspaces, the tree and the keymap arrive while
+    // dispatching. The surface is created as soon as the output of the
+    // focused workspace is named, and the keymap is compiled on a worker
+    // thread in the meantime.
+    trace_async_begin("output_wait", 0);
+    while (state.running && event_loop_dispatch(&event_loop, -1) >= 0) {}
 
-    wl_surface_commit(state.wl_surface);
-    while (state.running && wl_display_dispatch(state.wl_display)) {}
+    // The command of a selected guide is already sent and the overlay
+    // unmapped, only its reply is left to print.
+    if (state.selected_resize != NULL) {
+        sway_ipc_client_wait(&state.sway_ipc);
+    }
 
-    zwlr_layer_surface_v1_destroy(state.wl_layer_surface);
-    wl_surface_destroy(state.wl_surface);
+    trace_begin("teardown");
+    stats_set_phase(STATS_PHASE_TEARDOWN);
+    if (state.wl_layer_surface != NULL) {
+        zwlr_layer_surface_v1_destroy(state.wl_layer_surface);
+    }
+    if (state.wl_surface != NULL) {
+        wl_surface_destroy(state.wl_surface);
+    }
 
+    render_thread_finish(&state.render_thread);
     surface_buffer_pool_destroy(&state.surface_buffer_pool);
     wl_display_roundtrip(state.wl_display);
 
-    free_seats(&state.seats);
+    latency_report(&state.latency);
+    latency_finish(&state.latency);
+    preview_finish(&state.preview);
+    hint_finish(&state.hint);
+
+    seats_destroy(&state.seats);
     free_outputs(&state.outputs);
 
+    if (state.fractional_scale != NULL) {
+        wp_fractional_scale_v1_destroy(state.fractional_scale);
+    }
     if (state.fractional_scale_mgr) {
-        wp_fractional_scale_v1_destroy(fractional_scale);
         wp_fractional_scale_manager_v1_destroy(state.fractional_scale_mgr);
     }
 
@@ -676,27 +1111,23 @@ int main(int argc, char **argv) {
     zwlr_layer_shell_v1_destroy(state.wl_layer_shell);
 
     wl_display_disconnect(state.wl_display);
+    trace_end("teardown");
 
     if (state.focused_window.output != NULL) {
         free((void *)state.focused_window.output);
     }
+    free(state.output_name);
 
-    if (state.selected_resize != NULL) {
-        char cmd[256];
-        snprintf(
-            cmd, sizeof(cmd) - 1, "resize set %s %dpx",
-            state.resize_direction == RESIZE_VERTICAL ? "height" : "width",
-            state.selected_resize->size
-        );
-        cmd[sizeof(cmd) - 1] = '\0';
-
-        sway_ipc_send(sway_ipc_socket, SWAY_MSG_RUN_COMMAND, cmd, strlen(cmd));
-        struct sway_ipc_msg *res = sway_ipc_recv(sway_ipc_socket);
-        puts(res->payload);
-        free(res);
+    if (state.live.enabled) {
+        live_finish(&state);
     }
 
-    close(sway_ipc_socket);
+    sway_ipc_client_finish(&state.sway_ipc);
+    close(state.keymap_event_fd);
+    if (state.key_repeat_fd >= 0) {
+        close(state.key_repeat_fd);
+    }
 
-    return 0;
+    // Closed before the tree could be received.
+    return state.focused_window_ready ? 0 : 1;
 }
@@ -0,0 +1,638 @@
+#include "mock_compositor.h"
+
+#include "fractional-scale-v1-server-protocol.h"
+#include "log.h"
+#include "viewporter-server-protocol.h"
+#include "wlr-layer-shell-unstable-v1-server-protocol.h"
+#include "xdg-output-unstable-v1-server-protocol.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void noop() {}
+
+uint64_t mock_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t _now_ms() {
+    return mock_now_ns() / 1000000;
+}
+
+static void _destroy_resource(
+    struct wl_client *client, struct wl_resource *resource
+) {
+    wl_resource_destroy(resource);
+}
+
+static struct wl_resource *_create_resource(
+    struct wl_client *client, const struct wl_interface *interface,
+    int version, uint32_t id, const void *implementation, void *data,
+    wl_resource_destroy_func_t destroy
+) {
+    struct wl_resource *resource =
+        wl_resource_create(client, interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return NULL;
+    }
+
+    wl_resource_set_implementation(resource, implementation, data, destroy);
+    return resource;
+}
+
+// Buffers belong to the client, which can destroy them at any time.
+static void _set_buffer(
+    struct wl_resource **slot, struct wl_listener *listener,
+    struct wl_resource *buffer
+) {
+    if (*slot != NULL) {
+        wl_list_remove(&listener->link);
+    }
+
+    *slot = buffer;
+    if (buffer != NULL) {
+        wl_resource_add_destroy_listener(buffer, listener);
+    }
+}
+
+static void handle_pending_buffer_destroy(
+    struct wl_listener *listener, void *data
+) {
+    struct mock_compositor *mock =
+        wl_container_of(listener, mock, pending_buffer_destroy);
+    _set_buffer(&mock->pending_buffer, listener, NULL);
+}
+
+static void handle_current_buffer_destroy(
+    struct wl_listener *listener, void *data
+) {
+    struct mock_compositor *mock =
+        wl_container_of(listener, mock, current_buffer_destroy);
+    _set_buffer(&mock->current_buffer, listener, NULL);
+}
+
+static void _count_attach(
+    struct mock_compositor *mock, struct wl_resource *buffer
+) {
+    struct mock_compositor_stats *stats = &mock->stats;
+    struct wl_shm_buffer         *shm   = wl_shm_buffer_get(buffer);
+
+    stats->attaches++;
+    if (stats->first_attach_ns == 0) {
+        stats->first_attach_ns = mock_now_ns();
+    }
+
+    if (shm != NULL) {
+        stats->buffer_width   = wl_shm_buffer_get_width(shm);
+        stats->buffer_height  = wl_shm_buffer_get_height(shm);
+        stats->buffer_bytes  += (uint64_t)wl_shm_buffer_get_stride(shm) *
+                               wl_shm_buffer_get_height(shm);
+    }
+}
+
+static void handle_surface_attach(
+    struct wl_client *client, struct wl_resource *resource,
+    struct wl_resource *buffer, int32_t x, int32_t y
+) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    _set_buffer(&mock->pending_buffer, &mock->pending_buffer_destroy, buffer);
+    mock->buffer_attached = true;
+}
+
+static void handle_surface_damage(
+    struct wl_client *client, struct wl_resource *resource, int32_t x,
+    int32_t y, int32_t width, int32_t height
+) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    if (width > 0 && height > 0) {
+        mock->stats.damage_area += (uint64_t)width * height;
+    }
+}
+
+static void handle_callback_destroy(struct wl_resource *resource) {
+    wl_list_remove(wl_resource_get_link(resource));
+}
+
+static void handle_surface_frame(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id
+) {
+    struct mock_compositor *mock     = wl_resource_get_user_data(resource);
+    struct wl_resource     *callback = _create_resource(
+        client, &wl_callback_interface, 1, id, NULL, NULL,
+        handle_callback_destroy
+    );
+    if (callback != NULL) {
+        wl_list_insert(
+            mock->frame_callbacks.prev, wl_resource_get_link(callback)
+        );
+    }
+}
+
+static void handle_surface_commit(
+    struct wl_client *client, struct wl_resource *resource
+) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    mock->stats.commits++;
+
+    if (mock->buffer_attached) {
+        struct wl_resource *buffer = mock->pending_buffer;
+        if (buffer != NULL) {
+            _count_attach(mock, buffer);
+        } else if (mock->current_buffer != NULL) {
+            mock->stats.unmaps++;
+        }
+
+        // The previous buffer is not read anymore.
+        if (mock->current_buffer != NULL && mock->current_buffer != buffer) {
+            wl_buffer_send_release(mock->current_buffer);
+        }
+
+        _set_buffer(
+            &mock->current_buffer, &mock->current_buffer_destroy, buffer
+        );
+        _set_buffer(&mock->pending_buffer, &mock->pending_buffer_destroy, NULL);
+        mock->buffer_attached = false;
+    }
+
+    if (resource == mock->surface && mock->layer_surface != NULL &&
+        !mock->configured) {
+        mock->configured = true;
+        mock_compositor_configure(
+            mock, mock->output_width, mock->output_height
+        );
+    }
+
+    // Frames are shown right away.
+    struct wl_resource *callback;
+    struct wl_resource *tmp;
+    uint32_t            time = _now_ms();
+    wl_resource_for_each_safe (callback, tmp, &mock->frame_callbacks) {
+        wl_callback_send_done(callback, time);
+        wl_resource_destroy(callback);
+    }
+}
+
+static const struct wl_surface_interface surface_impl = {
+    .destroy              = _destroy_resource,
+    .attach               = handle_surface_attach,
+    .damage               = handle_surface_damage,
+    .frame                = handle_surface_frame,
+    .set_opaque_region    = noop,
+    .set_input_region     = noop,
+    .commit               = handle_surface_commit,
+    .set_buffer_transform = noop,
+    .set_buffer_scale     = noop,
+    .damage_buffer        = handle_surface_damage,
+    .offset               = noop,
+};
+
+static void handle_surface_destroy(struct wl_resource *resource) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    if (resource != mock->surface) {
+        return;
+    }
+
+    mock->surface          = NULL;
+    mock->keyboard_entered = false;
+    _set_buffer(&mock->pending_buffer, &mock->pending_buffer_destroy, NULL);
+    _set_buffer(&mock->current_buffer, &mock->current_buffer_destroy, NULL);
+}
+
+static const struct wl_region_interface region_impl = {
+    .destroy  = _destroy_resource,
+    .add      = noop,
+    .subtract = noop,
+};
+
+static void handle_compositor_create_surface(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id
+) {
+    _create_resource(
+        client, &wl_surface_interface, wl_resource_get_version(resource), id,
+        &surface_impl, wl_resource_get_user_data(resource),
+        handle_surface_destroy
+    );
+}
+
+static void handle_compositor_create_region(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id
+) {
+    _create_resource(
+        client, &wl_region_interface, 1, id, &region_impl, NULL, NULL
+    );
+}
+
+static const struct wl_compositor_interface compositor_impl = {
+    .create_surface = handle_compositor_create_surface,
+    .create_region  = handle_compositor_create_region,
+};
+
+static void bind_compositor(
+    struct wl_client *client, void *data, uint32_t version, uint32_t id
+) {
+    _create_resource(
+        client, &wl_compositor_interface, version, id, &compositor_impl, data,
+        NULL
+    );
+}
+
+static const struct wl_output_interface output_impl = {
+    .release = _destroy_resource,
+};
+
+static void bind_output(
+    struct wl_client *client, void *data, uint32_t version, uint32_t id
+) {
+    struct mock_compositor *mock     = data;
+    struct wl_resource     *resource = _create_resource(
+        client, &wl_output_interface, version, id, &output_impl, mock, NULL
+    );
+    if (resource == NULL) {
+        return;
+    }
+
+    wl_output_send_geometry(
+        resource, 0, 0, 0, 0, WL_OUTPUT_SUBPIXEL_UNKNOWN, "mock", "mock",
+        WL_OUTPUT_TRANSFORM_NORMAL
+    );
+    wl_output_send_mode(
+        resource, WL_OUTPUT_MODE_CURRENT | WL_OUTPUT_MODE_PREFERRED,
+        mock->output_width, mock->output_height, 60000
+    );
+    wl_output_send_scale(resource, 1);
+    if (version >= WL_OUTPUT_NAME_SINCE_VERSION) {
+        wl_output_send_name(resource, MOCK_OUTPUT_NAME);
+        wl_output_send_description(resource, "Mock output");
+    }
+    wl_output_send_done(resource);
+}
+
+static void handle_keyboard_destroy(struct wl_resource *resource) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    if (resource == mock->keyboard) {
+        mock->keyboard         = NULL;
+        mock->keyboard_entered = false;
+    }
+}
+
+static const struct wl_keyboard_interface keyboard_impl = {
+    .release = _destroy_resource,
+};
+
+static void handle_seat_get_keyboard(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id
+) {
+    struct mock_compositor *mock     = wl_resource_get_user_data(resource);
+    struct wl_resource     *keyboard = _create_resource(
+        client, &wl_keyboard_interface, wl_resource_get_version(resource), id,
+        &keyboard_impl, mock, handle_keyboard_destroy
+    );
+    if (keyboard == NULL) {
+        return;
+    }
+
+    // The client falls back to its default keymap.
+    int fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    wl_keyboard_send_keymap(
+        keyboard, WL_KEYBOARD_KEYMAP_FORMAT_NO_KEYMAP, fd, 0
+    );
+    close(fd);
+
+    if (wl_resource_get_version(keyboard) >=
+        WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) {
+        wl_keyboard_send_repeat_info(keyboard, 0, 0);
+    }
+
+    mock->keyboard         = keyboard;
+    mock->keyboard_entered = false;
+}
+
+static const struct wl_seat_interface seat_impl = {
+    .get_pointer  = noop,
+    .get_keyboard = handle_seat_get_keyboard,
+    .get_touch    = noop,
+    .release      = _destroy_resource,
+};
+
+static void bind_seat(
+    struct wl_client *client, void *data, uint32_t version, uint32_t id
+) {
+    struct wl_resource *resource = _create_resource(
+        client, &wl_seat_interface, version, id, &seat_impl, data, NULL
+    );
+    if (resource == NULL) {
+        return;
+    }
+
+    wl_seat_send_capabilities(resource, WL_SEAT_CAPABILITY_KEYBOARD);
+    if (version >= WL_SEAT_NAME_SINCE_VERSION) {
+        wl_seat_send_name(resource, "seat0");
+    }
+}
+
+static void handle_layer_surface_destroy(struct wl_resource *resource) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    if (resource == mock->layer_surface) {
+        mock->layer_surface = NULL;
+        mock->configured    = false;
+    }
+}
+
+static const struct zwlr_layer_surface_v1_interface layer_surface_impl = {
+    .set_size                   = noop,
+    .set_anchor                 = noop,
+    .set_exclusive_zone         = noop,
+    .set_margin                 = noop,
+    .set_keyboard_interactivity = noop,
+    .get_popup                  = noop,
+    .ack_configure              = noop,
+    .destroy                    = _destroy_resource,
+    .set_layer                  = noop,
+};
+
+static void handle_layer_shell_get_layer_surface(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id,
+    struct wl_resource *surface, struct wl_resource *output, uint32_t layer,
+    const char *namespace
+) {
+    struct mock_compositor *mock          = wl_resource_get_user_data(resource);
+    struct wl_resource     *layer_surface = _create_resource(
+        client, &zwlr_layer_surface_v1_interface,
+        wl_resource_get_version(resource), id, &layer_surface_impl, mock,
+        handle_layer_surface_destroy
+    );
+    if (layer_surface == NULL) {
+        return;
+    }
+
+    mock->layer_surface = layer_surface;
+    mock->surface       = surface;
+    mock->configured    = false;
+}
+
+static const struct zwlr_layer_shell_v1_interface layer_shell_impl = {
+    .get_layer_surface = handle_layer_shell_get_layer_surface,
+    .destroy           = _destroy_resource,
+};
+
+static void bind_layer_shell(
+    struct wl_client *client, void *data, uint32_t version, uint32_t id
+) {
+    _create_resource(
+        client, &zwlr_layer_shell_v1_interface, version, id, &layer_shell_impl,
+        data, NULL
+    );
+}
+
+static const struct wp_viewport_interface viewport_impl = {
+    .destroy         = _destroy_resource,
+    .set_source      = noop,
+    .set_destination = noop,
+};
+
+static void handle_viewporter_get_viewport(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id,
+    struct wl_resource *surface
+) {
+    _create_resource(
+        client, &wp_viewport_interface, 1, id, &viewport_impl, NULL, NULL
+    );
+}
+
+static const struct wp_viewporter_interface viewporter_impl = {
+    .destroy      = _destroy_resource,
+    .get_viewport = handle_viewporter_get_viewport,
+};
+
+static void bind_viewporter(
+    struct wl_client *client, void *data, uint32_t version, uint32_t id
+) {
+    _create_resource(
+        client, &wp_viewporter_interface, version, id, &viewporter_impl, data,
+        NULL
+    );
+}
+
+static void handle_fractional_scale_destroy(struct wl_resource *resource) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    if (resource == mock->fractional_scale) {
+        mock->fractional_scale = NULL;
+    }
+}
+
+static const struct wp_fractional_scale_v1_interface fractional_scale_impl = {
+    .destroy = _destroy_resource,
+};
+
+static void handle_fractional_scale_manager_get_fractional_scale(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id,
+    struct wl_resource *surface
+) {
+    struct mock_compositor *mock = wl_resource_get_user_data(resource);
+    struct wl_resource     *fractional_scale = _create_resource(
+        client, &wp_fractional_scale_v1_interface, 1, id,
+        &fractional_scale_impl, mock, handle_fractional_scale_destroy
+    );
+    if (fractional_scale == NULL) {
+        return;
+    }
+
+    mock->fractional_scale = fractional_scale;
+    wp_fractional_scale_v1_send_preferred_scale(
+        fractional_scale, mock->scale_120
+    );
+}
+
+static const struct wp_fractional_scale_manager_v1_interface
+    fractional_scale_manager_impl = {
+        .destroy = _destroy_resource,
+        .get_fractional_scale =
+            handle_fractional_scale_manager_get_fractional_scale,
+};
+
+static void bind_fractional_scale_manager(
+    struct wl_client *client, void *data, uint32_t version, uint32_t id
+) {
+    _create_resource(
+        client, &wp_fractional_scale_manager_v1_interface, version, id,
+        &fractional_scale_manager_impl, data, NULL
+    );
+}
+
+static const struct zxdg_output_v1_interface xdg_output_impl = {
+    .destroy = _destroy_resource,
+};
+
+static void handle_xdg_output_manager_get_xdg_output(
+    struct wl_client *client, struct wl_resource *resource, uint32_t id,
+    struct wl_resource *output
+) {
+    struct mock_compositor *mock       = wl_resource_get_user_data(resource);
+    struct wl_resource     *xdg_output = _create_resource(
+        client, &zxdg_output_v1_interface, wl_resource_get_version(resource),
+        id, &xdg_output_impl, mock, NULL
+    );
+    if (xdg_output == NULL) {
+        return;
+    }
+
+    zxdg_output_v1_send_logical_position(xdg_output, 0, 0);
+    zxdg_output_v1_send_logical_size(
+        xdg_output, mock->output_width, mock->output_height
+    );
+    if (wl_resource_get_version(xdg_output) >=
+        ZXDG_OUTPUT_V1_NAME_SINCE_VERSION) {
+        zxdg_output_v1_send_name(xdg_output, MOCK_OUTPUT_NAME);
+    }
+
+    // Replaced by wl_output.done from version 3.
+    if (wl_resource_get_version(xdg_output) < 3) {
+        zxdg_output_v1_send_done(xdg_output);
+    } else {
+        wl_output_send_done(output);
+    }
+}
+
+static const struct zxdg_output_manager_v1_interface xdg_output_manager_impl = {
+    .destroy        = _destroy_resource,
+    .get_xdg_output = handle_xdg_output_manager_get_xdg_output,
+};
+
+static void bind_xdg_output_manager(
+    struct wl_client *client, void *data, uint32_t version, uint32_t id
+) {
+    _create_resource(
+        client, &zxdg_output_manager_v1_interface, version, id,
+        &xdg_output_manager_impl, data, NULL
+    );
+}
+
+int mock_compositor_init(
+    struct mock_compositor *mock, int32_t output_width, int32_t output_height
+) {
+    memset(mock, 0, sizeof(struct mock_compositor));
+    mock->output_width                  = output_width;
+    mock->output_height                 = output_height;
+    mock->scale_120                     = 120;
+    mock->pending_buffer_destroy.notify = handle_pending_buffer_destroy;
+    mock->current_buffer_destroy.notify = handle_current_buffer_destroy;
+    wl_list_init(&mock->frame_callbacks);
+
+    mock->display = wl_display_create();
+    if (mock->display == NULL) {
+        LOG_ERR("Could not create mock display.");
+        return -1;
+    }
+    mock->event_loop = wl_display_get_event_loop(mock->display);
+
+    mock->socket = wl_display_add_socket_auto(mock->display);
+    if (mock->socket == NULL || wl_display_init_shm(mock->display) != 0) {
+        LOG_ERR("Could not set up mock display.");
+        wl_display_destroy(mock->display);
+        return -1;
+    }
+
+    // Versions sway-resize binds.
+    if (wl_global_create(
+            mock->display, &wl_compositor_interface, 4, mock, bind_compositor
+        ) == NULL ||
+        wl_global_create(
+            mock->display, &wl_output_interface, 4, mock, bind_output
+        ) == NULL ||
+        wl_global_create(
+            mock->display, &wl_seat_interface, 7, mock, bind_seat
+        ) == NULL ||
+        wl_global_create(
+            mock->display, &zwlr_layer_shell_v1_interface, 2, mock,
+            bind_layer_shell
+        ) == NULL ||
+        wl_global_create(
+            mock->display, &wp_viewporter_interface, 1, mock, bind_viewporter
+        ) == NULL ||
+        wl_global_create(
+            mock->display, &wp_fractional_scale_manager_v1_interface, 1, mock,
+            bind_fractional_scale_manager
+        ) == NULL ||
+        wl_global_create(
+            mock->display, &zxdg_output_manager_v1_interface, 2, mock,
+            bind_xdg_output_manager
+        ) == NULL) {
+        LOG_ERR("Could not create mock globals.");
+        wl_display_destroy(mock->display);
+        return -1;
+    }
+
+    return 0;
+}
+
+void mock_compositor_finish(struct mock_compositor *mock) {
+    wl_display_destroy_clients(mock->display);
+    wl_display_destroy(mock->display);
+    memset(mock, 0, sizeof(struct mock_compositor));
+}
+
+int mock_compositor_dispatch(struct mock_compositor *mock, int timeout) {
+    wl_display_flush_clients(mock->display);
+    int ret = wl_event_loop_dispatch(mock->event_loop, timeout);
+    wl_display_flush_clients(mock->display);
+    return ret;
+}
+
+void mock_compositor_configure(
+    struct mock_compositor *mock, int32_t width, int32_t height
+) {
+    if (mock->layer_surface == NULL) {
+        return;
+    }
+
+    zwlr_layer_surface_v1_send_configure(
+        mock->layer_surface, wl_display_next_serial(mock->display), width,
+        height
+    );
+}
+
+void mock_compositor_set_scale(struct mock_compositor *mock, uint32_t scale) {
+    mock->scale_120 = scale;
+    if (mock->fractional_scale != NULL) {
+        wp_fractional_scale_v1_send_preferred_scale(
+            mock->fractional_scale, scale
+        );
+    }
+}
+
+int mock_compositor_press_key(struct mock_compositor *mock, uint32_t key) {
+    if (mock->keyboard == NULL || mock->surface == NULL) {
+        return -1;
+    }
+
+    if (!mock->keyboard_entered) {
+        struct wl_array keys;
+        wl_array_init(&keys);
+        wl_keyboard_send_enter(
+            mock->keyboard, wl_display_next_serial(mock->display),
+            mock->surface, &keys
+        );
+        wl_keyboard_send_modifiers(
+            mock->keyboard, wl_display_next_serial(mock->display), 0, 0, 0, 0
+        );
+        wl_array_release(&keys);
+        mock->keyboard_entered = true;
+    }
+
+    uint32_t time = _now_ms();
+    wl_keyboard_send_key(
+        mock->keyboard, wl_display_next_serial(mock->display), time, key,
+        WL_KEYBOARD_KEY_STATE_PRESSED
+    );
+    wl_keyboard_send_key(
+        mock->keyboard, wl_display_next_serial(mock->display), time, key,
+        WL_KEYBOARD_KEY_STATE_RELEASED
+    );
+
+    return 0;
+}
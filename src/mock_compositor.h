@@ -0,0 +1,78 @@
+#ifndef __MOCK_COMPOSITOR_H_INCLUDED__
+#define __MOCK_COMPOSITOR_H_INCLUDED__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-server.h>
+
+#define MOCK_OUTPUT_NAME "MOCK-1"
+
+// Counted over all the commits of the client.
+struct mock_compositor_stats {
+    uint32_t commits;
+    uint32_t attaches;
+    uint32_t unmaps; // commits detaching the buffer shown
+    uint64_t damage_area;  // damage and damage_buffer rectangles, in pixels
+    uint64_t buffer_bytes; // attached shm buffers
+    uint64_t first_attach_ns;
+    int32_t  buffer_width; // of the last attached buffer
+    int32_t  buffer_height;
+};
+
+/*
+ * Stand-in compositor used to run sway-resize end to end in tests and
+ * benchmarks.
+ *
+ * It offers a single output and a seat with a keyboard, and the globals
+ * sway-resize needs. One layer surface is handled: it is configured to the
+ * output size on its first commit, its buffers are released as soon as they
+ * are replaced and frame callbacks are done on commit. Configures, scale
+ * changes and key presses are injected by the caller.
+ */
+struct mock_compositor {
+    struct wl_display           *display;
+    struct wl_event_loop        *event_loop;
+    const char                  *socket;
+    int32_t                      output_width;
+    int32_t                      output_height;
+    uint32_t                     scale_120;
+    struct mock_compositor_stats stats;
+
+    struct wl_resource *surface;
+    struct wl_resource *layer_surface;
+    struct wl_resource *fractional_scale;
+    struct wl_resource *keyboard;
+    struct wl_resource *pending_buffer;
+    struct wl_resource *current_buffer;
+    struct wl_listener  pending_buffer_destroy;
+    struct wl_listener  current_buffer_destroy;
+    struct wl_list      frame_callbacks; // type: wl_resource link
+    bool                buffer_attached;
+    bool                configured;
+    bool                keyboard_entered;
+};
+
+// Listen on a new socket, its name is in `socket`.
+int mock_compositor_init(
+    struct mock_compositor *mock, int32_t output_width, int32_t output_height
+);
+void mock_compositor_finish(struct mock_compositor *mock);
+
+// Dispatch client requests for at most `timeout` ms and flush the events.
+int mock_compositor_dispatch(struct mock_compositor *mock, int timeout);
+
+// Configure the layer surface to a new size.
+void mock_compositor_configure(
+    struct mock_compositor *mock, int32_t width, int32_t height
+);
+
+// Send a new preferred fractional scale, in 1/120.
+void mock_compositor_set_scale(struct mock_compositor *mock, uint32_t scale);
+
+// Focus the layer surface, then press and release an evdev key. Return
+// non-zero if the client has no keyboard or surface yet.
+int mock_compositor_press_key(struct mock_compositor *mock, uint32_t key);
+
+uint64_t mock_now_ns();
+
+#endif
@@ -0,0 +1,238 @@
+#include "mock_sway.h"
+
+#include "log.h"
+#include "mock_compositor.h"
+#include "sway_ipc.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MOCK_SWAY_TREE_FORMAT                                                  \
+    "{\"id\":1,\"type\":\"root\",\"focus\":[2],\"floating_nodes\":[],"         \
+    "\"rect\":{\"x\":0,\"y\":0,\"width\":%d,\"height\":%d},\"nodes\":["        \
+    "{\"id\":2,\"type\":\"output\",\"name\":\"" MOCK_OUTPUT_NAME "\","         \
+    "\"focus\":[3],\"floating_nodes\":[],"                                     \
+    "\"rect\":{\"x\":0,\"y\":0,\"width\":%d,\"height\":%d},\"nodes\":["        \
+    "{\"id\":3,\"type\":\"workspace\",\"orientation\":\"horizontal\","         \
+    "\"focus\":[4],\"floating_nodes\":[],"                                     \
+    "\"rect\":{\"x\":0,\"y\":0,\"width\":%d,\"height\":%d},\"nodes\":["        \
+    "{\"id\":4,\"type\":\"con\",\"focused\":true,\"nodes\":[],"                \
+    "\"rect\":{\"x\":0,\"y\":0,\"width\":%d,\"height\":%d},"                   \
+    "\"deco_rect\":{\"x\":0,\"y\":0,\"width\":0,\"height\":0}},"               \
+    "{\"id\":5,\"type\":\"con\",\"focused\":false,\"nodes\":[],"               \
+    "\"rect\":{\"x\":%d,\"y\":0,\"width\":%d,\"height\":%d},"                  \
+    "\"deco_rect\":{\"x\":0,\"y\":0,\"width\":0,\"height\":0}}]}]}]}"
+
+#define MOCK_SWAY_WORKSPACES                                                   \
+    "[{\"id\":3,\"num\":1,\"name\":\"1\",\"focused\":true,\"visible\":true,"   \
+    "\"output\":\"" MOCK_OUTPUT_NAME "\"}]"
+
+static int _send_reply(
+    struct mock_sway *sway, uint32_t type, const char *payload
+) {
+    struct sway_ipc_msg_header header = {
+        .magic  = {'i', '3', '-', 'i', 'p', 'c'},
+        .length = strlen(payload),
+        .type   = type,
+    };
+
+    // Replies are small, the socket buffer takes them at once.
+    if (send(sway->client_fd, &header, sizeof(header), MSG_NOSIGNAL) !=
+            sizeof(header) ||
+        send(sway->client_fd, payload, header.length, MSG_NOSIGNAL) !=
+            header.length) {
+        LOG_ERR("Could not send mock Sway reply.");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _handle_request(
+    struct mock_sway *sway, uint32_t type, const char *payload, uint32_t len
+) {
+    switch (type) {
+    case SWAY_MSG_GET_WORKSPACES:
+        return _send_reply(sway, type, MOCK_SWAY_WORKSPACES);
+
+    case SWAY_MSG_GET_TREE:
+        return _send_reply(sway, type, sway->tree);
+
+    case SWAY_MSG_RUN_COMMAND:;
+        free(sway->last_command);
+        sway->last_command    = strndup(payload, len);
+        sway->last_command_ns = mock_now_ns();
+        sway->num_commands++;
+
+        // One result per command.
+        char reply[4096] = "[{\"success\":true}";
+        for (uint32_t i = 0; i < len; i++) {
+            if (payload[i] == ';' && strlen(reply) + 20 < sizeof(reply)) {
+                strcat(reply, ",{\"success\":true}");
+            }
+        }
+        strcat(reply, "]");
+        return _send_reply(sway, type, reply);
+
+    default:
+        return _send_reply(sway, type, "[]");
+    }
+}
+
+static void _close_client(struct mock_sway *sway) {
+    wl_event_source_remove(sway->client_source);
+    close(sway->client_fd);
+    sway->client_source = NULL;
+    sway->client_fd     = -1;
+    sway->input_len     = 0;
+}
+
+// Answer the complete requests received, in order, up to a held tree.
+static int _handle_input(struct mock_sway *sway) {
+    struct sway_ipc_msg_header header;
+    size_t                     offset = 0;
+    while (sway->input_len - offset >= sizeof(header)) {
+        memcpy(&header, sway->input + offset, sizeof(header));
+        if (sway->input_len - offset - sizeof(header) < header.length) {
+            break;
+        }
+        if (sway->hold_tree && header.type == SWAY_MSG_GET_TREE) {
+            break;
+        }
+
+        if (_handle_request(
+                sway, header.type, sway->input + offset + sizeof(header),
+                header.length
+            ) != 0) {
+            return -1;
+        }
+        offset += sizeof(header) + header.length;
+    }
+
+    sway->input_len -= offset;
+    memmove(sway->input, sway->input + offset, sway->input_len);
+    return 0;
+}
+
+static int handle_client(int fd, uint32_t mask, void *data) {
+    struct mock_sway *sway = data;
+
+    if (sway->input_cap - sway->input_len < 4096) {
+        sway->input_cap = sway->input_cap * 2 + 4096;
+        sway->input     = realloc(sway->input, sway->input_cap);
+    }
+
+    ssize_t n = recv(
+        fd, sway->input + sway->input_len, sway->input_cap - sway->input_len,
+        0
+    );
+    if (n <= 0) {
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+            return 0;
+        }
+        _close_client(sway);
+        return 0;
+    }
+    sway->input_len += n;
+
+    if (_handle_input(sway) != 0) {
+        _close_client(sway);
+    }
+    return 0;
+}
+
+static int handle_listen(int fd, uint32_t mask, void *data) {
+    struct mock_sway *sway = data;
+
+    int client_fd = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        return 0;
+    }
+
+    // One client at a time.
+    if (sway->client_fd >= 0) {
+        _close_client(sway);
+    }
+
+    sway->client_fd     = client_fd;
+    sway->client_source = wl_event_loop_add_fd(
+        sway->event_loop, client_fd, WL_EVENT_READABLE, handle_client, sway
+    );
+    return 0;
+}
+
+int mock_sway_init(
+    struct mock_sway *sway, struct wl_event_loop *event_loop,
+    int32_t output_width, int32_t output_height
+) {
+    memset(sway, 0, sizeof(struct mock_sway));
+    sway->event_loop = event_loop;
+    sway->listen_fd  = -1;
+    sway->client_fd  = -1;
+
+    int32_t half = output_width / 2;
+    if (asprintf(
+            &sway->tree, MOCK_SWAY_TREE_FORMAT, output_width, output_height,
+            output_width, output_height, output_width, output_height, half,
+            output_height, half, output_width - half, output_height
+        ) < 0) {
+        return -1;
+    }
+
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    snprintf(
+        sway->path, sizeof(sway->path), "%s/sway-resize-mock-%d.sock",
+        dir != NULL ? dir : "/tmp", getpid()
+    );
+    unlink(sway->path);
+
+    struct sockaddr_un addr = {
+        .sun_family = AF_UNIX,
+    };
+    memcpy(addr.sun_path, sway->path, sizeof(addr.sun_path));
+
+    sway->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sway->listen_fd < 0 ||
+        bind(sway->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(sway->listen_fd, 4) != 0) {
+        LOG_ERR("Could not listen on '%s'.", sway->path);
+        mock_sway_finish(sway);
+        return -1;
+    }
+
+    sway->listen_source = wl_event_loop_add_fd(
+        event_loop, sway->listen_fd, WL_EVENT_READABLE, handle_listen, sway
+    );
+    return 0;
+}
+
+void mock_sway_finish(struct mock_sway *sway) {
+    if (sway->client_fd >= 0) {
+        _close_client(sway);
+    }
+    if (sway->listen_source != NULL) {
+        wl_event_source_remove(sway->listen_source);
+    }
+    if (sway->listen_fd >= 0) {
+        close(sway->listen_fd);
+        unlink(sway->path);
+    }
+
+    free(sway->tree);
+    free(sway->input);
+    free(sway->last_command);
+    memset(sway, 0, sizeof(struct mock_sway));
+    sway->listen_fd = -1;
+    sway->client_fd = -1;
+}
+
+void mock_sway_release_tree(struct mock_sway *sway) {
+    sway->hold_tree = false;
+    if (sway->client_fd >= 0 && _handle_input(sway) != 0) {
+        _close_client(sway);
+    }
+}
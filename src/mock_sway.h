@@ -0,0 +1,48 @@
+#ifndef __MOCK_SWAY_H_INCLUDED__
+#define __MOCK_SWAY_H_INCLUDED__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/un.h>
+#include <wayland-server.h>
+
+/*
+ * Stand-in for the Sway IPC socket, dispatched from the mock compositor event
+ * loop.
+ *
+ * The tree has two windows side by side on the mock output, the left one is
+ * focused. Commands are recorded and always succeed. The workspaces put the
+ * focus on the mock output.
+ */
+struct mock_sway {
+    struct wl_event_loop   *event_loop;
+    struct wl_event_source *listen_source;
+    struct wl_event_source *client_source;
+    int                     listen_fd;
+    int                     client_fd;
+    char                    path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    char                   *tree;
+    bool                    hold_tree; // until `mock_sway_release_tree`
+
+    // Request being received.
+    char  *input;
+    size_t input_len;
+    size_t input_cap;
+
+    uint32_t num_commands;
+    char    *last_command;
+    uint64_t last_command_ns;
+};
+
+// Listen on a socket in $XDG_RUNTIME_DIR, its path is in `path`.
+int mock_sway_init(
+    struct mock_sway *sway, struct wl_event_loop *event_loop,
+    int32_t output_width, int32_t output_height
+);
+void mock_sway_finish(struct mock_sway *sway);
+
+// Answer the GET_TREE request held back, and the ones received after it.
+void mock_sway_release_tree(struct mock_sway *sway);
+
+#endif
@@ -0,0 +1,249 @@
+#include "pointer.h"
+
+#include "frame.h"
+#include "hint.h"
+#include "live.h"
+#include "log.h"
+#include "render.h"
+#include "seat.h"
+#include "state.h"
+
+#include <linux/input-event-codes.h>
+#include <math.h>
+
+static void noop() {}
+
+static bool _near(double a, double b) {
+    return fabs(a - b) <= POINTER_GRAB_DISTANCE;
+}
+
+static bool _within(double a, double start, double len) {
+    return a >= start - POINTER_GRAB_DISTANCE &&
+           a <= start + len + POINTER_GRAB_DISTANCE;
+}
+
+// Return the resizable edge of the focused window under the position.
+static enum pointer_edge
+_find_edge_at(struct focused_window *fw, double x, double y) {
+    struct rect *rect = &fw->rect;
+
+    if (_within(y, rect->y, rect->h)) {
+        if (fw->resize_left && _near(x, rect->x)) {
+            return POINTER_EDGE_LEFT;
+        }
+        if (fw->resize_right && _near(x, rect->x + rect->w)) {
+            return POINTER_EDGE_RIGHT;
+        }
+    }
+
+    if (_within(x, rect->x, rect->w)) {
+        if (fw->resize_top && _near(y, rect->y)) {
+            return POINTER_EDGE_TOP;
+        }
+        if (fw->resize_bottom && _near(y, rect->y + rect->h)) {
+            return POINTER_EDGE_BOTTOM;
+        }
+    }
+
+    return POINTER_EDGE_NONE;
+}
+
+static void _update_hover(struct state *state, double x, double y) {
+    if (state->hint.picking) {
+        return;
+    }
+
+    enum pointer_edge edge = _find_edge_at(&state->focused_window, x, y);
+    if (edge != state->drag.hover_edge) {
+        state->drag.hover_edge = edge;
+        request_frame(state);
+    }
+}
+
+static void handle_pointer_enter(
+    void *data, struct wl_pointer *wl_pointer, uint32_t serial,
+    struct wl_surface *surface, wl_fixed_t surface_x, wl_fixed_t surface_y
+) {
+    struct seat *seat = data;
+    seat->pointer_x   = wl_fixed_to_double(surface_x);
+    seat->pointer_y   = wl_fixed_to_double(surface_y);
+
+    if (seat->state->drag.edge == POINTER_EDGE_NONE) {
+        _update_hover(seat->state, seat->pointer_x, seat->pointer_y);
+    }
+}
+
+static void handle_pointer_motion(
+    void *data, struct wl_pointer *wl_pointer, uint32_t time,
+    wl_fixed_t surface_x, wl_fixed_t surface_y
+) {
+    struct seat  *seat  = data;
+    struct state *state = seat->state;
+    seat->pointer_x     = wl_fixed_to_double(surface_x);
+    seat->pointer_y     = wl_fixed_to_double(surface_y);
+
+    latency_input(&state->latency, time);
+    if (state->drag.edge == POINTER_EDGE_NONE) {
+        _update_hover(state, seat->pointer_x, seat->pointer_y);
+    } else {
+        // Only the latest position is kept, the model is updated on the next
+        // frame callback.
+        state->drag.x     = seat->pointer_x;
+        state->drag.y     = seat->pointer_y;
+        state->drag.moved = true;
+        request_frame(state);
+    }
+    latency_input_done(&state->latency);
+}
+
+static void _start_drag(struct seat *seat) {
+    struct state        *state = seat->state;
+    struct pointer_drag *drag  = &state->drag;
+
+    drag->edge = _find_edge_at(
+        &state->focused_window, seat->pointer_x, seat->pointer_y
+    );
+    if (drag->edge == POINTER_EDGE_NONE) {
+        return;
+    }
+
+    bool horizontal =
+        drag->edge == POINTER_EDGE_LEFT || drag->edge == POINTER_EDGE_RIGHT;
+
+    drag->hover_edge   = drag->edge;
+    drag->direction    = horizontal ? RESIZE_HORIZONTAL : RESIZE_VERTICAL;
+    drag->moved        = false;
+    drag->x            = seat->pointer_x;
+    drag->y            = seat->pointer_y;
+    drag->start_window = state->focused_window;
+    drag->has_result   = false;
+}
+
+static void _end_drag(struct seat *seat) {
+    struct state        *state = seat->state;
+    struct pointer_drag *drag  = &state->drag;
+
+    // Motion received since the last frame has not been applied yet.
+    pointer_update_drag(state);
+    drag->edge = POINTER_EDGE_NONE;
+    _update_hover(state, seat->pointer_x, seat->pointer_y);
+
+    if (!state->live.enabled && drag->has_result) {
+        live_select(state, &drag->result, drag->direction);
+    }
+}
+
+static void _process_button(
+    struct seat *seat, uint32_t button, uint32_t button_state
+) {
+    struct state *state = seat->state;
+
+    if (button != BTN_LEFT) {
+        return;
+    }
+
+    if (button_state == WL_POINTER_BUTTON_STATE_RELEASED) {
+        if (state->drag.edge != POINTER_EDGE_NONE) {
+            _end_drag(seat);
+        }
+        return;
+    }
+
+    // Nothing is drawn to click on before the tree is received.
+    if (!state->focused_window_ready) {
+        return;
+    }
+
+    if (state->hint.picking) {
+        if (hint_pick_at(state, seat->pointer_x, seat->pointer_y)) {
+            request_frame(state);
+        }
+        return;
+    }
+
+    enum resize_direction    direction;
+    struct resize_parameter *param = render_find_guide_at(
+        state, seat->pointer_x, seat->pointer_y, &direction
+    );
+    if (param != NULL) {
+        live_select(state, param, direction);
+        return;
+    }
+
+    _start_drag(seat);
+}
+
+static void handle_pointer_button(
+    void *data, struct wl_pointer *wl_pointer, uint32_t serial, uint32_t time,
+    uint32_t button, uint32_t button_state
+) {
+    struct seat *seat = data;
+
+    latency_input(&seat->state->latency, time);
+    _process_button(seat, button, button_state);
+    latency_input_done(&seat->state->latency);
+}
+
+static const struct wl_pointer_listener wl_pointer_listener = {
+    .enter         = handle_pointer_enter,
+    .leave         = noop,
+    .motion        = handle_pointer_motion,
+    .button        = handle_pointer_button,
+    .axis          = noop,
+    .frame         = noop,
+    .axis_source   = noop,
+    .axis_stop     = noop,
+    .axis_discrete = noop,
+};
+
+void pointer_init(struct seat *seat, struct wl_pointer *wl_pointer) {
+    seat->wl_pointer = wl_pointer;
+    wl_pointer_add_listener(wl_pointer, &wl_pointer_listener, seat);
+}
+
+void pointer_update_drag(struct state *state) {
+    struct pointer_drag *drag = &state->drag;
+    if (drag->edge == POINTER_EDGE_NONE || !drag->moved) {
+        return;
+    }
+    drag->moved = false;
+
+    struct focused_window  previous = state->focused_window;
+    struct focused_window *fw       = &state->focused_window;
+    *fw                             = drag->start_window;
+
+    bool    horizontal = drag->direction == RESIZE_HORIZONTAL;
+    double  p          = horizontal ? drag->x : drag->y;
+    int32_t pos        = horizontal ? fw->rect.x : fw->rect.y;
+    int32_t size       = horizontal ? fw->rect.w : fw->rect.h;
+    bool    both       = horizontal ? fw->resize_left && fw->resize_right
+                                    : fw->resize_top && fw->resize_bottom;
+    bool    max_edge   = drag->edge == POINTER_EDGE_RIGHT ||
+                         drag->edge == POINTER_EDGE_BOTTOM;
+
+    // Move the dragged edge under the pointer. Windows resizable on both
+    // sides grow symmetrically, so the size changes twice as much.
+    int32_t delta = lround(max_edge ? p - (pos + size) : pos - p);
+
+    struct resize_parameter param = {
+        .value      = size + (both ? 2 : 1) * delta,
+        .relative   = false,
+        .percentage = false,
+    };
+
+    if (!resize_parameter_compute_guides(&param, fw, drag->direction)) {
+        *fw = previous;
+        return;
+    }
+
+    drag->result     = param;
+    drag->has_result = true;
+
+    if (state->live.enabled) {
+        live_apply(state, &param, drag->direction);
+        return;
+    }
+
+    resize_parameter_apply(&param, drag->direction, fw);
+    resize_parameters_compute_guides(state->resize_params, fw);
+}
@@ -0,0 +1,52 @@
+#ifndef __POINTER_H_INCLUDED__
+#define __POINTER_H_INCLUDED__
+
+#include "resize_params.h"
+#include "sway_win.h"
+
+#include <stdbool.h>
+#include <wayland-client.h>
+
+struct seat;
+struct state;
+
+// Distance in pixels within which the pointer grabs a window edge or a guide.
+#define POINTER_GRAB_DISTANCE 6
+
+enum pointer_edge {
+    POINTER_EDGE_NONE   = 0,
+    POINTER_EDGE_LEFT   = 1,
+    POINTER_EDGE_RIGHT  = 2,
+    POINTER_EDGE_TOP    = 3,
+    POINTER_EDGE_BOTTOM = 4,
+};
+
+/*
+ * Window edge dragged with the pointer.
+ *
+ * Motion events only record the pointer position. The window model is
+ * updated once per frame callback from the latest position, so that a high
+ * rate mouse does not cause more than one render per frame.
+ */
+struct pointer_drag {
+    // Resizable edge under the pointer, highlighted when rendering.
+    enum pointer_edge hover_edge;
+
+    enum pointer_edge     edge;
+    enum resize_direction direction;
+    bool                  moved;
+    double                x;
+    double                y;
+    struct focused_window start_window;
+
+    // Last applicable resize previewed by the drag.
+    struct resize_parameter result;
+    bool                    has_result;
+};
+
+void pointer_init(struct seat *seat, struct wl_pointer *wl_pointer);
+
+// Update the window model from the latest pointer position of a drag.
+void pointer_update_drag(struct state *state);
+
+#endif
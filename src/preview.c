@@ -0,0 +1,265 @@
+#include "preview.h"
+
+#include "frame.h"
+#include "log.h"
+#include "state.h"
+#include "trace.h"
+#include "utils.h"
+
+#include <string.h>
+#include <unistd.h>
+
+static void _release_buffer(struct preview *preview) {
+    if (preview->wl_buffer != NULL) {
+        wl_buffer_destroy(preview->wl_buffer);
+        preview->wl_buffer = NULL;
+    }
+}
+
+static void _end_capture(struct state *state, enum preview_capture_state end) {
+    struct preview *preview = &state->preview;
+
+    zwlr_screencopy_frame_v1_destroy(preview->frame);
+    preview->frame         = NULL;
+    preview->capture_state = end;
+    _release_buffer(preview);
+    trace_async_end("preview_capture", 0);
+
+    if (end == PREVIEW_CAPTURE_FAILED) {
+        shm_mapping_finish(&preview->shm);
+    }
+
+    // The first frame waited for the capture.
+    if (state->surface_configured) {
+        send_frame(state);
+    }
+}
+
+static void _copy(struct state *state) {
+    struct preview *preview = &state->preview;
+    struct image   *capture = &preview->capture;
+
+    if (preview->format == 0) {
+        LOG_WARN("Screencopy offers no supported buffer format.");
+        _end_capture(state, PREVIEW_CAPTURE_FAILED);
+        return;
+    }
+
+    if (shm_mapping_init(
+            &preview->shm, (size_t)capture->height * capture->stride, 0
+        ) != 0) {
+        LOG_WARN("Could not allocate the screencopy buffer.");
+        _end_capture(state, PREVIEW_CAPTURE_FAILED);
+        return;
+    }
+    capture->data = preview->shm.data;
+
+    struct wl_shm_pool *wl_shm_pool =
+        wl_shm_create_pool(state->wl_shm, preview->shm.fd, preview->shm.size);
+    preview->wl_buffer = wl_shm_pool_create_buffer(
+        wl_shm_pool, 0, capture->width, capture->height, capture->stride,
+        preview->format
+    );
+    wl_shm_pool_destroy(wl_shm_pool);
+
+    close(preview->shm.fd);
+    preview->shm.fd = -1;
+
+    zwlr_screencopy_frame_v1_copy(preview->frame, preview->wl_buffer);
+}
+
+static void handle_frame_buffer(
+    void *data, struct zwlr_screencopy_frame_v1 *frame, uint32_t format,
+    uint32_t width, uint32_t height, uint32_t stride
+) {
+    struct state   *state   = data;
+    struct preview *preview = &state->preview;
+
+    // Both have the memory layout of the cairo formats.
+    if (preview->format != 0 || (format != WL_SHM_FORMAT_ARGB8888 &&
+                                 format != WL_SHM_FORMAT_XRGB8888)) {
+        return;
+    }
+
+    preview->format  = format;
+    preview->capture = (struct image){
+        .width  = width,
+        .height = height,
+        .stride = stride,
+    };
+
+    // Older versions don't announce the end of the buffer types.
+    if (preview->manager_version < 3) {
+        _copy(state);
+    }
+}
+
+static void handle_frame_buffer_done(
+    void *data, struct zwlr_screencopy_frame_v1 *frame
+) {
+    _copy(data);
+}
+
+static void handle_frame_flags(
+    void *data, struct zwlr_screencopy_frame_v1 *frame, uint32_t flags
+) {
+    struct state *state     = data;
+    state->preview.y_invert = flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT;
+}
+
+static void handle_frame_ready(
+    void *data, struct zwlr_screencopy_frame_v1 *frame, uint32_t tv_sec_hi,
+    uint32_t tv_sec_lo, uint32_t tv_nsec
+) {
+    _end_capture(data, PREVIEW_CAPTURE_READY);
+}
+
+static void handle_frame_failed(
+    void *data, struct zwlr_screencopy_frame_v1 *frame
+) {
+    LOG_WARN("Could not capture the window content.");
+    _end_capture(data, PREVIEW_CAPTURE_FAILED);
+}
+
+static void noop() {}
+
+static const struct zwlr_screencopy_frame_v1_listener frame_listener = {
+    .buffer       = handle_frame_buffer,
+    .flags        = handle_frame_flags,
+    .ready        = handle_frame_ready,
+    .failed       = handle_frame_failed,
+    .damage       = noop,
+    .linux_dmabuf = noop,
+    .buffer_done  = handle_frame_buffer_done,
+};
+
+void preview_init(struct preview *preview, bool enabled) {
+    memset(preview, 0, sizeof(struct preview));
+    preview->enabled = enabled;
+    preview->shm.fd  = -1;
+}
+
+void preview_bind(
+    struct preview *preview, struct wl_registry *registry, uint32_t name,
+    uint32_t version
+) {
+    if (!preview->enabled) {
+        return;
+    }
+
+    preview->manager_version = min(version, 3);
+    preview->manager         = wl_registry_bind(
+        registry, name, &zwlr_screencopy_manager_v1_interface,
+        preview->manager_version
+    );
+}
+
+void preview_capture(struct state *state) {
+    struct preview *preview = &state->preview;
+    if (!preview->enabled) {
+        return;
+    }
+
+    if (preview->manager == NULL) {
+        LOG_WARN("The compositor does not support wlr-screencopy.");
+        return;
+    }
+
+    struct rect *rect = &state->focused_window.rect;
+    trace_async_begin("preview_capture", 0);
+    preview->window_id     = state->focused_window.id;
+    preview->capture_state = PREVIEW_CAPTURE_PENDING;
+    preview->frame = zwlr_screencopy_manager_v1_capture_output_region(
+        preview->manager, false, state->current_output->wl_output, rect->x,
+        rect->y, rect->w, rect->h
+    );
+    zwlr_screencopy_frame_v1_add_listener(
+        preview->frame, &frame_listener, state
+    );
+}
+
+bool preview_capturing(struct preview *preview) {
+    return preview->capture_state == PREVIEW_CAPTURE_PENDING;
+}
+
+// Another window was picked with --hint, the overlay covers it by now.
+static void _discard(struct preview *preview) {
+    _release_buffer(preview);
+    shm_mapping_finish(&preview->shm);
+
+    if (preview->surface != NULL) {
+        cairo_surface_destroy(preview->surface);
+        preview->surface = NULL;
+    }
+    preview->capture_state = PREVIEW_CAPTURE_NONE;
+}
+
+void preview_update(
+    struct preview *preview, int window_id, int32_t width, int32_t height
+) {
+    if (preview->capture_state == PREVIEW_CAPTURE_READY &&
+        window_id != preview->window_id) {
+        _discard(preview);
+    }
+
+    if (preview->capture_state != PREVIEW_CAPTURE_READY || width <= 0 ||
+        height <= 0) {
+        return;
+    }
+
+    if (preview->surface != NULL &&
+        cairo_image_surface_get_width(preview->surface) == width &&
+        cairo_image_surface_get_height(preview->surface) == height) {
+        return;
+    }
+
+    if (preview->surface != NULL) {
+        cairo_surface_destroy(preview->surface);
+    }
+
+    preview->surface = cairo_image_surface_create(
+        preview->format == WL_SHM_FORMAT_XRGB8888 ? CAIRO_FORMAT_RGB24
+                                                  : CAIRO_FORMAT_ARGB32,
+        width, height
+    );
+    cairo_surface_flush(preview->surface);
+
+    struct image scaled = {
+        .data   = cairo_image_surface_get_data(preview->surface),
+        .width  = width,
+        .height = height,
+        .stride = cairo_image_surface_get_stride(preview->surface),
+    };
+    struct image capture = preview->y_invert
+                               ? image_flipped(&preview->capture)
+                               : preview->capture;
+
+    trace_begin("preview_scale");
+    if (scaled.data == NULL || image_scale(&capture, &scaled) != 0) {
+        LOG_WARN("Could not scale the window content.");
+        cairo_surface_destroy(preview->surface);
+        preview->surface = NULL;
+    } else {
+        cairo_surface_mark_dirty(preview->surface);
+    }
+    trace_end("preview_scale");
+}
+
+void preview_finish(struct preview *preview) {
+    if (preview->frame != NULL) {
+        zwlr_screencopy_frame_v1_destroy(preview->frame);
+    }
+    _release_buffer(preview);
+    shm_mapping_finish(&preview->shm);
+
+    if (preview->surface != NULL) {
+        cairo_surface_destroy(preview->surface);
+    }
+
+    if (preview->manager != NULL) {
+        zwlr_screencopy_manager_v1_destroy(preview->manager);
+    }
+
+    memset(preview, 0, sizeof(struct preview));
+    preview->shm.fd = -1;
+}
@@ -0,0 +1,68 @@
+#ifndef __PREVIEW_H_INCLUDED__
+#define __PREVIEW_H_INCLUDED__
+
+#include "image_scale.h"
+#include "shm.h"
+#include "wlr-screencopy-unstable-v1-client-protocol.h"
+
+#include <cairo/cairo.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-client.h>
+
+struct state;
+
+enum preview_capture_state {
+    PREVIEW_CAPTURE_NONE    = 0,
+    PREVIEW_CAPTURE_PENDING = 1,
+    PREVIEW_CAPTURE_READY   = 2,
+    PREVIEW_CAPTURE_FAILED  = 3,
+};
+
+/*
+ * Content of the focused window drawn in place of its box.
+ *
+ * The window is captured once with wlr-screencopy, before the overlay is
+ * shown. Each time the window is drawn at a new size, the capture is
+ * rescaled into `surface`, which is reused until the size changes again.
+ * Another window picked with --hint is covered by the overlay by then, so it
+ * is drawn without preview and the capture is dropped.
+ */
+struct preview {
+    bool                               enabled;
+    struct zwlr_screencopy_manager_v1 *manager;
+    uint32_t                           manager_version;
+    struct zwlr_screencopy_frame_v1   *frame;
+    enum preview_capture_state         capture_state;
+    int                                window_id; // of the capture
+    struct shm_mapping                 shm;
+    struct wl_buffer                  *wl_buffer;
+    uint32_t                           format;
+    bool                               y_invert;
+    struct image                       capture;
+    cairo_surface_t                   *surface;
+};
+
+void preview_init(struct preview *preview, bool enabled);
+
+// Called on the screencopy manager global, which is bound only if enabled.
+void preview_bind(
+    struct preview *preview, struct wl_registry *registry, uint32_t name,
+    uint32_t version
+);
+
+// Capture the focused window on the current output. The first frame is sent
+// once the capture is done, so that the overlay is not captured.
+void preview_capture(struct state *state);
+
+bool preview_capturing(struct preview *preview);
+
+// Rescale the capture to the size in pixels the window is drawn at, if it is
+// the captured one.
+void preview_update(
+    struct preview *preview, int window_id, int32_t width, int32_t height
+);
+
+void preview_finish(struct preview *preview);
+
+#endif
@@ -1,8 +1,11 @@
 #include "render.h"
 
+#include "font.h"
+#include "hint.h"
 #include "resize_params.h"
 #include "utils_cairo.h"
 
+#include <math.h>
 #include <stddef.h>
 
 #define BG_COLOR              0x11111188
@@ -11,13 +14,14 @@
 #define GUIDE_LINE_COLOR      0xf8d5dbee
 #define GUIDE_LABEL_COLOR     0xeeeeeeff
 #define GUIDE_LABEL_FONT_SIZE 15
+#define HINT_LABEL_FONT_SIZE  40
 
 static void _render_vertical_guide(
-    cairo_t *cairo, uint32_t x, uint32_t start_y, uint32_t end_y, char *label
+    cairo_t *cairo, uint32_t x, uint32_t start_y, uint32_t end_y, char *label,
+    bool system_font
 ) {
-    cairo_set_font_size(cairo, GUIDE_LABEL_FONT_SIZE);
     cairo_text_extents_t te;
-    cairo_text_extents(cairo, label, &te);
+    font_text_extents(cairo, label, GUIDE_LABEL_FONT_SIZE, system_font, &te);
 
     uint32_t label_x = x - te.x_advance / 2;
     uint32_t label_y =
@@ -41,16 +45,17 @@ static void _render_vertical_guide(
     cairo_stroke(cairo);
 
     cairo_set_source_u32(cairo, GUIDE_LABEL_COLOR);
-    cairo_move_to(cairo, label_x, label_y);
-    cairo_show_text(cairo, label);
+    font_show_text(
+        cairo, label_x, label_y, label, GUIDE_LABEL_FONT_SIZE, system_font
+    );
 }
 
 static void _render_horizontal_guide(
-    cairo_t *cairo, uint32_t y, uint32_t start_x, uint32_t end_x, char *label
+    cairo_t *cairo, uint32_t y, uint32_t start_x, uint32_t end_x, char *label,
+    bool system_font
 ) {
-    cairo_set_font_size(cairo, GUIDE_LABEL_FONT_SIZE);
     cairo_text_extents_t te;
-    cairo_text_extents(cairo, label, &te);
+    font_text_extents(cairo, label, GUIDE_LABEL_FONT_SIZE, system_font, &te);
 
     uint32_t label_x = end_x + (start_x < end_x ? 3.5 : -te.x_advance - 3.5);
     uint32_t label_y = y + te.height / 2;
@@ -73,24 +78,40 @@ static void _render_horizontal_guide(
     cairo_stroke(cairo);
 
     cairo_set_source_u32(cairo, GUIDE_LABEL_COLOR);
-    cairo_move_to(cairo, label_x, label_y);
-    cairo_show_text(cairo, label);
+    font_show_text(
+        cairo, label_x, label_y, label, GUIDE_LABEL_FONT_SIZE, system_font
+    );
 }
 
 #define GUIDE_PADDING 10
 
+// Covers the guide markers and labels around the window and guide ends.
+#define EXTENT_MARGIN (GUIDE_LABEL_FONT_SIZE + 10)
+
+#define HOVER_EDGE_WIDTH 3
+
+// Guides are spread across the window, perpendicular to their direction.
+static uint32_t _guides_start_pos(
+    struct focused_window *focused_window, enum resize_direction direction,
+    size_t num_applicable
+) {
+    return direction == RESIZE_VERTICAL
+               ? focused_window->rect.x +
+                     (focused_window->rect.w - GUIDE_PADDING * num_applicable) /
+                         2
+               : focused_window->rect.y +
+                     (focused_window->rect.h - GUIDE_PADDING * num_applicable) /
+                         2;
+}
+
 static void _render_guides(
     cairo_t *cairo, struct resize_parameter *params, size_t num_params,
     struct focused_window *focused_window, enum resize_direction direction,
-    size_t num_applicable
+    size_t num_applicable, bool system_font
 ) {
     int      y = 0;
     uint32_t start_pos =
-        direction == RESIZE_VERTICAL
-            ? focused_window->rect.x +
-                  (focused_window->rect.w - GUIDE_PADDING * num_applicable) / 2
-            : focused_window->rect.y +
-                  (focused_window->rect.h - GUIDE_PADDING * num_applicable) / 2;
+        _guides_start_pos(focused_window, direction, num_applicable);
 
     for (int i = 0; i < num_params; i++) {
         struct resize_parameter *param = &params[i];
@@ -102,35 +123,33 @@ static void _render_guides(
         char label[5];
         rune_to_str(param->symbol, label);
 
-        cairo_set_font_size(cairo, GUIDE_LABEL_FONT_SIZE);
-        cairo_text_extents_t te;
-        cairo_text_extents(cairo, label, &te);
-
         uint32_t pos = start_pos + GUIDE_PADDING * (y + 1);
         if (direction == RESIZE_VERTICAL) {
             if (param->guides[0] != NO_GUIDE) {
                 _render_vertical_guide(
-                    cairo, pos, focused_window->rect.y, param->guides[0], label
+                    cairo, pos, focused_window->rect.y, param->guides[0], label,
+                    system_font
                 );
             }
             if (param->guides[1] != NO_GUIDE) {
                 _render_vertical_guide(
                     cairo, pos,
                     focused_window->rect.y + focused_window->rect.h - 1,
-                    param->guides[1], label
+                    param->guides[1], label, system_font
                 );
             }
         } else {
             if (param->guides[0] != NO_GUIDE) {
                 _render_horizontal_guide(
-                    cairo, pos, focused_window->rect.x, param->guides[0], label
+                    cairo, pos, focused_window->rect.x, param->guides[0], label,
+                    system_font
                 );
             }
             if (param->guides[1] != NO_GUIDE) {
                 _render_horizontal_guide(
                     cairo, pos,
                     focused_window->rect.x + focused_window->rect.w - 1,
-                    param->guides[1], label
+                    param->guides[1], label, system_font
                 );
             }
         }
@@ -138,34 +157,128 @@ static void _render_guides(
     }
 }
 
-void render(struct state *state, cairo_t *cairo) {
-    cairo_select_font_face(
-        cairo, "monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL
-    );
+static void _render_hover_edge(cairo_t *cairo, struct state *state) {
+    struct rect *rect = &state->focused_window.rect;
+
+    switch (state->drag.hover_edge) {
+    case POINTER_EDGE_LEFT:
+        cairo_move_to(cairo, rect->x + .5, rect->y);
+        cairo_line_to(cairo, rect->x + .5, rect->y + rect->h);
+        break;
+    case POINTER_EDGE_RIGHT:
+        cairo_move_to(cairo, rect->x + rect->w - .5, rect->y);
+        cairo_line_to(cairo, rect->x + rect->w - .5, rect->y + rect->h);
+        break;
+    case POINTER_EDGE_TOP:
+        cairo_move_to(cairo, rect->x, rect->y + .5);
+        cairo_line_to(cairo, rect->x + rect->w, rect->y + .5);
+        break;
+    case POINTER_EDGE_BOTTOM:
+        cairo_move_to(cairo, rect->x, rect->y + rect->h - .5);
+        cairo_line_to(cairo, rect->x + rect->w, rect->y + rect->h - .5);
+        break;
+    case POINTER_EDGE_NONE:
+        return;
+    }
+
+    cairo_set_line_width(cairo, HOVER_EDGE_WIDTH);
+    cairo_set_source_u32(cairo, GUIDE_LINE_COLOR);
+    cairo_stroke(cairo);
+}
 
+// Draw the captured window content, rescaled beforehand to the pixel size of
+// the window so that it is painted 1:1.
+static void _render_preview(cairo_t *cairo, struct state *state) {
+    struct rect     *rect    = &state->focused_window.rect;
+    cairo_surface_t *surface = state->preview.surface;
+    int32_t          width   = cairo_image_surface_get_width(surface);
+    int32_t          height  = cairo_image_surface_get_height(surface);
+
+    cairo_save(cairo);
+    cairo_translate(cairo, rect->x, rect->y);
+    cairo_scale(cairo, (double)rect->w / width, (double)rect->h / height);
+    cairo_set_source_surface(cairo, surface, 0, 0);
+    cairo_rectangle(cairo, 0, 0, width, height);
+    cairo_fill(cairo);
+    cairo_restore(cairo);
+}
+
+// Draw every visible window with its label in the middle, windows whose
+// label doesn't match the letter typed so far are left out.
+static void _render_hints(cairo_t *cairo, struct state *state) {
+    struct hint_mode *hint = &state->hint;
+
+    for (int i = 0; i < hint->visible.count; i++) {
+        char label[3];
+        if (!hint_matches(hint, i) || !hint_label(hint, i, label)) {
+            continue;
+        }
+
+        struct rect *rect = &hint->visible.windows[i].rect;
+        cairo_rectangle(cairo, rect->x + .5, rect->y + .5, rect->w, rect->h);
+        cairo_set_source_u32(cairo, WIN_BG_COLOR);
+        cairo_fill(cairo);
+
+        cairo_set_line_width(cairo, 1);
+        cairo_rectangle(
+            cairo, rect->x + .5, rect->y + .5, rect->w - 1, rect->h - 1
+        );
+        cairo_set_source_u32(cairo, WIN_BORDER_COLOR);
+        cairo_stroke(cairo);
+
+        cairo_text_extents_t te;
+        font_text_extents(
+            cairo, label, HINT_LABEL_FONT_SIZE, state->system_font, &te
+        );
+        cairo_set_source_u32(cairo, GUIDE_LABEL_COLOR);
+        font_show_text(
+            cairo, rect->x + (rect->w - te.x_advance) / 2,
+            rect->y + (rect->h + te.height) / 2, label, HINT_LABEL_FONT_SIZE,
+            state->system_font
+        );
+    }
+}
+
+void render(struct state *state, cairo_t *cairo) {
     cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
     cairo_set_source_u32(cairo, BG_COLOR);
     cairo_paint(cairo);
 
-    cairo_rectangle(
-        cairo, state->focused_window.rect.x + .5,
-        state->focused_window.rect.y + .5, state->focused_window.rect.w,
-        state->focused_window.rect.h
-    );
-    cairo_set_source_u32(cairo, WIN_BG_COLOR);
-    cairo_fill(cairo);
+    // The first frame is drawn while the tree is being received.
+    if (!state->focused_window_ready) {
+        return;
+    }
+
+    if (state->hint.picking) {
+        _render_hints(cairo, state);
+        return;
+    }
+
+    if (state->preview.surface != NULL) {
+        _render_preview(cairo, state);
+    } else {
+        cairo_rectangle(
+            cairo, state->focused_window.rect.x + .5,
+            state->focused_window.rect.y + .5, state->focused_window.rect.w,
+            state->focused_window.rect.h
+        );
+        cairo_set_source_u32(cairo, WIN_BG_COLOR);
+        cairo_fill(cairo);
+    }
 
     _render_guides(
         cairo, state->resize_params->params[RESIZE_VERTICAL],
         state->resize_params->counts[RESIZE_VERTICAL], &state->focused_window,
         RESIZE_VERTICAL,
-        state->resize_params->applicable_counts[RESIZE_VERTICAL]
+        state->resize_params->applicable_counts[RESIZE_VERTICAL],
+        state->system_font
     );
     _render_guides(
         cairo, state->resize_params->params[RESIZE_HORIZONTAL],
         state->resize_params->counts[RESIZE_HORIZONTAL], &state->focused_window,
         RESIZE_HORIZONTAL,
-        state->resize_params->applicable_counts[RESIZE_HORIZONTAL]
+        state->resize_params->applicable_counts[RESIZE_HORIZONTAL],
+        state->system_font
     );
 
     cairo_set_line_width(cairo, 1);
@@ -176,4 +289,124 @@ void render(struct state *state, cairo_t *cairo) {
     );
     cairo_set_source_u32(cairo, WIN_BORDER_COLOR);
     cairo_stroke(cairo);
+
+    _render_hover_edge(cairo, state);
+}
+
+struct rect render_extent(struct state *state) {
+    if (!state->focused_window_ready) {
+        return (struct rect){0};
+    }
+
+    if (state->hint.picking) {
+        struct rect extent = {0};
+        for (int i = 0; i < state->hint.visible.count; i++) {
+            extent = rect_union(extent, state->hint.visible.windows[i].rect);
+        }
+        return extent;
+    }
+
+    struct focused_window *fw = &state->focused_window;
+    int32_t                x0 = fw->rect.x;
+    int32_t                y0 = fw->rect.y;
+    int32_t                x1 = fw->rect.x + fw->rect.w;
+    int32_t                y1 = fw->rect.y + fw->rect.h;
+
+    enum resize_direction directions[] = {RESIZE_VERTICAL, RESIZE_HORIZONTAL};
+    for (size_t d = 0; d < ARRAY_LEN(directions); d++) {
+        enum resize_direction    direction = directions[d];
+        struct resize_parameter *params =
+            state->resize_params->params[direction];
+
+        for (size_t i = 0; i < state->resize_params->counts[direction]; i++) {
+            if (!params[i].applicable) {
+                continue;
+            }
+
+            for (int j = 0; j < 2; j++) {
+                int32_t guide = params[i].guides[j];
+                if (guide == NO_GUIDE) {
+                    continue;
+                }
+
+                if (direction == RESIZE_VERTICAL) {
+                    y0 = min(y0, guide);
+                    y1 = max(y1, guide);
+                } else {
+                    x0 = min(x0, guide);
+                    x1 = max(x1, guide);
+                }
+            }
+        }
+    }
+
+    return (struct rect){
+        .x = x0 - EXTENT_MARGIN,
+        .y = y0 - EXTENT_MARGIN,
+        .w = x1 - x0 + 2 * EXTENT_MARGIN,
+        .h = y1 - y0 + 2 * EXTENT_MARGIN,
+    };
+}
+
+static bool _hits_guide_line(
+    double pos, double start, double end, double x, double y
+) {
+    double low  = start < end ? start : end;
+    double high = start < end ? end : start;
+    return fabs(x - pos) <= POINTER_GRAB_DISTANCE &&
+           y >= low - POINTER_GRAB_DISTANCE &&
+           y <= high + POINTER_GRAB_DISTANCE;
+}
+
+struct resize_parameter *render_find_guide_at(
+    struct state *state, double x, double y, enum resize_direction *direction
+) {
+    if (state->hint.picking) {
+        return NULL;
+    }
+
+    struct focused_window *fw = &state->focused_window;
+
+    enum resize_direction directions[] = {RESIZE_VERTICAL, RESIZE_HORIZONTAL};
+    for (size_t d = 0; d < ARRAY_LEN(directions); d++) {
+        enum resize_direction    dir    = directions[d];
+        struct resize_parameter *params = state->resize_params->params[dir];
+        uint32_t                 start_pos = _guides_start_pos(
+            fw, dir, state->resize_params->applicable_counts[dir]
+        );
+
+        int n = 0;
+        for (size_t i = 0; i < state->resize_params->counts[dir]; i++) {
+            if (!params[i].applicable) {
+                continue;
+            }
+
+            uint32_t pos = start_pos + GUIDE_PADDING * (++n);
+            int32_t  edges[2];
+            if (dir == RESIZE_VERTICAL) {
+                edges[0] = fw->rect.y;
+                edges[1] = fw->rect.y + fw->rect.h - 1;
+            } else {
+                edges[0] = fw->rect.x;
+                edges[1] = fw->rect.x + fw->rect.w - 1;
+            }
+
+            for (int j = 0; j < 2; j++) {
+                int32_t guide = params[i].guides[j];
+                if (guide == NO_GUIDE) {
+                    continue;
+                }
+
+                // Horizontal guides are hit tested with swapped axes.
+                if (dir == RESIZE_VERTICAL
+                        ? _hits_guide_line(pos, edges[j], guide, x, y)
+                        : _hits_guide_line(pos, edges[j], guide, y, x)) {
+                    *direction = dir;
+                    return &params[i];
+                }
+            }
+        }
+    }
+
+    return NULL;
 }
@@ -7,4 +7,14 @@
 
 void render(struct state *state, cairo_t *cairo);
 
+// Area drawn over the background: the window, its guides and their labels,
+// in surface coordinates.
+struct rect render_extent(struct state *state);
+
+// Return the applicable parameter whose guide is drawn under the position,
+// or NULL.
+struct resize_parameter *render_find_guide_at(
+    struct state *state, double x, double y, enum resize_direction *direction
+);
+
 #endif
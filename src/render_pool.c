@@ -0,0 +1,179 @@
+#include "render_pool.h"
+
+#include "log.h"
+#include "render.h"
+
+#include <cairo/cairo.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+// Guides and labels are not evenly spread over the buffer, handing out
+// smaller tiles balances the work between threads.
+#define TILES_PER_THREAD 4
+
+// Tiles smaller than this are not worth the per-tile setup.
+#define MIN_TILE_HEIGHT 32
+
+static void _set_clip(cairo_t *cairo, const struct rect *clip) {
+    cairo_reset_clip(cairo);
+    if (clip != NULL) {
+        cairo_rectangle(cairo, clip->x, clip->y, clip->w, clip->h);
+        cairo_clip(cairo);
+    }
+}
+
+static bool _tile_in_clip(
+    struct surface_buffer_tile *tile, const struct rect *clip
+) {
+    return clip == NULL || (clip->y < (int32_t)(tile->y + tile->height) &&
+                            clip->y + clip->h > (int32_t)tile->y);
+}
+
+static void _render_tile(
+    struct state *state, struct surface_buffer_tile *tile, double scale,
+    const struct rect *clip
+) {
+    cairo_t *cairo = tile->cairo;
+    cairo_identity_matrix(cairo);
+    cairo_translate(cairo, 0, -(double)tile->y);
+    _set_clip(cairo, clip);
+    cairo_scale(cairo, scale, scale);
+
+    render(state, cairo);
+    cairo_surface_flush(tile->cairo_surface);
+}
+
+// Render tiles until none are left to claim. Must be called with the pool
+// mutex held.
+static void _render_pending_tiles(struct render_pool *pool) {
+    while (pool->next_tile < pool->num_tiles) {
+        struct surface_buffer_tile *tile =
+            &pool->buffer->tiles[pool->next_tile++];
+        struct state      *state = pool->state;
+        double             scale = pool->scale;
+        const struct rect *clip  = pool->clip;
+
+        pthread_mutex_unlock(&pool->mutex);
+        if (_tile_in_clip(tile, clip)) {
+            _render_tile(state, tile, scale, clip);
+        }
+        pthread_mutex_lock(&pool->mutex);
+
+        if (++pool->done_tiles == pool->num_tiles) {
+            pthread_cond_broadcast(&pool->done_cond);
+        }
+    }
+}
+
+static void *_render_pool_worker(void *data) {
+    struct render_pool *pool = data;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->stopping) {
+        _render_pending_tiles(pool);
+        pthread_cond_wait(&pool->work_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+int render_pool_init(struct render_pool *pool, size_t num_threads) {
+    pool->threads     = NULL;
+    pool->num_threads = num_threads < 1 ? 1 : num_threads;
+    pool->state       = NULL;
+    pool->buffer      = NULL;
+    pool->scale       = 1;
+    pool->clip        = NULL;
+    pool->num_tiles   = 0;
+    pool->next_tile   = 0;
+    pool->done_tiles  = 0;
+    pool->stopping    = false;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    if (pool->num_threads == 1) {
+        return 0;
+    }
+
+    pool->threads = calloc(pool->num_threads - 1, sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        LOG_ERR("Could not allocate render threads.");
+        pool->num_threads = 1;
+        return -1;
+    }
+
+    for (size_t i = 0; i < pool->num_threads - 1; i++) {
+        if (pthread_create(
+                &pool->threads[i], NULL, _render_pool_worker, pool
+            ) != 0) {
+            LOG_WARN("Could only start %zu render threads.", i + 1);
+            pool->num_threads = i + 1;
+            break;
+        }
+    }
+
+    return 0;
+}
+
+void render_pool_destroy(struct render_pool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t i = 0; i < pool->num_threads - 1; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    free(pool->threads);
+    pool->threads = NULL;
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+void render_pool_render(
+    struct render_pool *pool, struct state *state,
+    struct surface_buffer *buffer, double scale, const struct rect *clip
+) {
+    size_t num_tiles = pool->num_threads * TILES_PER_THREAD;
+    if (num_tiles > buffer->height / MIN_TILE_HEIGHT) {
+        num_tiles = buffer->height / MIN_TILE_HEIGHT;
+    }
+
+    if (pool->num_threads == 1 || num_tiles < 2 ||
+        surface_buffer_split_tiles(buffer, num_tiles) != 0) {
+        cairo_t *cairo = buffer->cairo;
+        cairo_identity_matrix(cairo);
+        _set_clip(cairo, clip);
+        cairo_scale(cairo, scale, scale);
+
+        render(state, cairo);
+        cairo_surface_flush(buffer->cairo_surface);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->state      = state;
+    pool->buffer     = buffer;
+    pool->scale      = scale;
+    pool->clip       = clip;
+    pool->num_tiles  = buffer->num_tiles;
+    pool->next_tile  = 0;
+    pool->done_tiles = 0;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    _render_pending_tiles(pool);
+    while (pool->done_tiles < pool->num_tiles) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+
+    pool->state     = NULL;
+    pool->buffer    = NULL;
+    pool->clip      = NULL;
+    pool->num_tiles = 0;
+    pthread_mutex_unlock(&pool->mutex);
+}
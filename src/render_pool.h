@@ -0,0 +1,48 @@
+#ifndef __RENDER_POOL_H_INCLUDED__
+#define __RENDER_POOL_H_INCLUDED__
+
+#include "surface_buffer.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RENDER_POOL_MAX_THREADS 64
+
+struct state;
+
+/*
+ * Fixed pool of threads rendering horizontal tiles of a surface buffer.
+ *
+ * The calling thread takes part in the rendering, so a pool of `n` threads
+ * spawns `n - 1` workers. A pool of a single thread renders the whole buffer
+ * on the calling thread.
+ */
+struct render_pool {
+    pthread_t             *threads;
+    size_t                 num_threads;
+    pthread_mutex_t        mutex;
+    pthread_cond_t         work_cond;
+    pthread_cond_t         done_cond;
+    struct state          *state;
+    struct surface_buffer *buffer;
+    double                 scale;
+    const struct rect     *clip;
+    size_t                 num_tiles;
+    size_t                 next_tile;
+    size_t                 done_tiles;
+    bool                   stopping;
+};
+
+int  render_pool_init(struct render_pool *pool, size_t num_threads);
+void render_pool_destroy(struct render_pool *pool);
+
+// Render the state into the buffer at the given scale and wait for all the
+// tiles to be done. Only the clip rectangle, in buffer pixels, is redrawn,
+// or the whole buffer if it is NULL. Tiles outside of it are skipped.
+void render_pool_render(
+    struct render_pool *pool, struct state *state,
+    struct surface_buffer *buffer, double scale, const struct rect *clip
+);
+
+#endif
@@ -0,0 +1,250 @@
+#include "render_thread.h"
+
+#include "log.h"
+#include "state.h"
+#include "stats.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static void _notify(struct render_thread *thread) {
+    uint64_t one = 1;
+    if (write(thread->event_fd, &one, sizeof(one)) < 0) {
+        LOG_ERR("Could not notify rendered frame.");
+    }
+}
+
+static void _render_frame(struct render_thread *thread) {
+    trace_begin("render");
+    stats_render_begin();
+    render_pool_render(
+        &thread->pool, thread->snapshot, thread->buffer, thread->scale,
+        thread->clipped ? &thread->clip : NULL
+    );
+    stats_render_end();
+    trace_end("render");
+}
+
+static void *_render_thread(void *data) {
+    struct render_thread *thread = data;
+
+    pthread_mutex_lock(&thread->mutex);
+    while (true) {
+        while (!thread->queued && !thread->stopping) {
+            pthread_cond_wait(&thread->cond, &thread->mutex);
+        }
+        if (!thread->queued) {
+            break;
+        }
+        thread->queued = false;
+        pthread_mutex_unlock(&thread->mutex);
+
+        _render_frame(thread);
+
+        pthread_mutex_lock(&thread->mutex);
+        thread->done = true;
+        _notify(thread);
+    }
+    pthread_mutex_unlock(&thread->mutex);
+
+    return NULL;
+}
+
+// Copy the guides so that the dispatch thread can compute new ones during
+// the frame.
+static int _copy_params(
+    struct render_thread *thread, const struct resize_parameters *params
+) {
+    struct resize_parameters *copy = &thread->params;
+    for (size_t d = 0; d < NUM_DIRECTIONS; d++) {
+        size_t count = params->counts[d];
+        if (count > thread->params_caps[d]) {
+            struct resize_parameter *array = realloc(
+                copy->params[d], count * sizeof(struct resize_parameter)
+            );
+            if (array == NULL) {
+                LOG_ERR("Could not allocate render guides.");
+                return -1;
+            }
+            copy->params[d]        = array;
+            thread->params_caps[d] = count;
+        }
+
+        if (count > 0) {
+            memcpy(
+                copy->params[d], params->params[d],
+                count * sizeof(struct resize_parameter)
+            );
+        }
+        copy->counts[d]            = count;
+        copy->applicable_counts[d] = params->applicable_counts[d];
+    }
+    return 0;
+}
+
+static int _copy_windows(
+    struct render_thread *thread, const struct visible_windows *visible
+) {
+    if (visible->count > thread->windows_cap) {
+        struct focused_window *windows = realloc(
+            thread->windows, visible->count * sizeof(struct focused_window)
+        );
+        if (windows == NULL) {
+            LOG_ERR("Could not allocate render windows.");
+            return -1;
+        }
+        thread->windows     = windows;
+        thread->windows_cap = visible->count;
+    }
+
+    if (visible->count > 0) {
+        memcpy(
+            thread->windows, visible->windows,
+            visible->count * sizeof(struct focused_window)
+        );
+    }
+    return 0;
+}
+
+// Copy the fields of the state that `render` reads.
+static int _snapshot(struct render_thread *thread, struct state *state) {
+    struct state *snapshot         = thread->snapshot;
+    snapshot->focused_window       = state->focused_window;
+    snapshot->focused_window_ready = state->focused_window_ready;
+    snapshot->drag                 = state->drag;
+    snapshot->hint                 = state->hint;
+    snapshot->preview              = state->preview;
+    snapshot->system_font          = state->system_font;
+    snapshot->resize_params        = NULL;
+
+    if (state->resize_params != NULL) {
+        if (_copy_params(thread, state->resize_params) != 0) {
+            return -1;
+        }
+        snapshot->resize_params = &thread->params;
+    }
+
+    if (_copy_windows(thread, &state->hint.visible) != 0) {
+        return -1;
+    }
+    snapshot->hint.visible.windows = thread->windows;
+    snapshot->hint.visible.cap     = thread->windows_cap;
+
+    return 0;
+}
+
+int render_thread_init(struct render_thread *thread, size_t num_threads) {
+    memset(thread, 0, sizeof(struct render_thread));
+    thread->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (thread->event_fd < 0) {
+        LOG_ERR("Could not create render eventfd.");
+        return -1;
+    }
+
+    thread->snapshot = calloc(1, sizeof(struct state));
+    if (thread->snapshot == NULL) {
+        LOG_ERR("Could not allocate render snapshot.");
+        close(thread->event_fd);
+        thread->event_fd = -1;
+        return -1;
+    }
+
+    pthread_mutex_init(&thread->mutex, NULL);
+    pthread_cond_init(&thread->cond, NULL);
+    render_pool_init(&thread->pool, num_threads);
+
+    if (pthread_create(&thread->thread, NULL, _render_thread, thread) != 0) {
+        LOG_WARN("Could not start render thread, rendering on input.");
+    } else {
+        thread->started = true;
+    }
+
+    return 0;
+}
+
+void render_thread_finish(struct render_thread *thread) {
+    if (thread->snapshot == NULL) {
+        return;
+    }
+
+    // A frame in flight is rendered before stopping, its buffer may be
+    // destroyed right after.
+    if (thread->started) {
+        pthread_mutex_lock(&thread->mutex);
+        thread->stopping = true;
+        pthread_cond_signal(&thread->cond);
+        pthread_mutex_unlock(&thread->mutex);
+        pthread_join(thread->thread, NULL);
+    }
+
+    render_pool_destroy(&thread->pool);
+    pthread_cond_destroy(&thread->cond);
+    pthread_mutex_destroy(&thread->mutex);
+    close(thread->event_fd);
+
+    for (size_t d = 0; d < NUM_DIRECTIONS; d++) {
+        free(thread->params.params[d]);
+    }
+    free(thread->windows);
+    free(thread->snapshot);
+    memset(thread, 0, sizeof(struct render_thread));
+    thread->event_fd = -1;
+}
+
+bool render_thread_busy(struct render_thread *thread) {
+    return thread->busy;
+}
+
+int render_thread_submit(
+    struct render_thread *thread, struct state *state,
+    struct surface_buffer *buffer, double scale, const struct rect *clip,
+    struct rect damage
+) {
+    if (_snapshot(thread, state) != 0) {
+        return -1;
+    }
+
+    thread->busy    = true;
+    thread->buffer  = buffer;
+    thread->scale   = scale;
+    thread->clipped = clip != NULL;
+    thread->clip    = clip != NULL ? *clip : (struct rect){0};
+    thread->damage  = damage;
+
+    if (!thread->started) {
+        _render_frame(thread);
+        thread->done = true;
+        _notify(thread);
+        return 0;
+    }
+
+    pthread_mutex_lock(&thread->mutex);
+    thread->queued = true;
+    pthread_cond_signal(&thread->cond);
+    pthread_mutex_unlock(&thread->mutex);
+
+    return 0;
+}
+
+struct surface_buffer *
+render_thread_take(struct render_thread *thread, struct rect *damage) {
+    uint64_t count;
+    if (read(thread->event_fd, &count, sizeof(count)) < 0) {
+        LOG_WARN("Could not read render notification.");
+    }
+
+    pthread_mutex_lock(&thread->mutex);
+    bool done    = thread->done;
+    thread->done = false;
+    pthread_mutex_unlock(&thread->mutex);
+    if (!done) {
+        return NULL;
+    }
+
+    thread->busy = false;
+    *damage      = thread->damage;
+    return thread->buffer;
+}
@@ -0,0 +1,74 @@
+#ifndef __RENDER_THREAD_H_INCLUDED__
+#define __RENDER_THREAD_H_INCLUDED__
+
+#include "render_pool.h"
+#include "resize_params.h"
+#include "surface_buffer.h"
+#include "sway_win.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct state;
+
+/*
+ * Thread rendering the frames, so that the dispatch thread keeps handling
+ * input while a frame is drawn.
+ *
+ * The dispatch thread hands over a buffer with a copy of what `render` reads
+ * from the state, and commits the buffer once `event_fd` signals that it is
+ * drawn. A single frame is in flight at a time. Its tiles are rendered by
+ * the render pool, with the render thread taking part.
+ *
+ * If the thread could not be started, frames are rendered when handed over
+ * and signaled the same way.
+ */
+struct render_thread {
+    pthread_t          thread;
+    bool               started;
+    pthread_mutex_t    mutex;
+    pthread_cond_t     cond;
+    int                event_fd;
+    bool               stopping;
+    bool               busy;   // handed over and not taken back yet
+    bool               queued; // not picked up by the thread yet
+    bool               done;
+    struct render_pool pool;
+
+    // Frame in flight, only used by the thread until it is done.
+    struct state          *snapshot;
+    struct surface_buffer *buffer;
+    double                 scale;
+    struct rect            clip; // in buffer pixels
+    bool                   clipped;
+    struct rect            damage; // in surface coordinates, for the commit
+
+    // Copies of the guides and the hint windows of the snapshot, kept from
+    // one frame to the next.
+    struct resize_parameters params;
+    size_t                   params_caps[NUM_DIRECTIONS];
+    struct focused_window   *windows;
+    int                      windows_cap;
+};
+
+int  render_thread_init(struct render_thread *thread, size_t num_threads);
+void render_thread_finish(struct render_thread *thread);
+
+bool render_thread_busy(struct render_thread *thread);
+
+// Render the state into the buffer on the thread. Only the clip rectangle,
+// in buffer pixels, is redrawn, or the whole buffer if it is NULL. `damage`
+// is given back with the buffer. Must not be called while busy.
+int render_thread_submit(
+    struct render_thread *thread, struct state *state,
+    struct surface_buffer *buffer, double scale, const struct rect *clip,
+    struct rect damage
+);
+
+// Called when `event_fd` is readable. Return the rendered buffer and its
+// damage, or NULL if the frame is not done.
+struct surface_buffer *
+render_thread_take(struct render_thread *thread, struct rect *damage);
+
+#endif
@@ -0,0 +1,126 @@
+#include "replay.h"
+
+#include "hint.h"
+#include "json_tape.h"
+#include "log.h"
+#include "render_pool.h"
+#include "resize_params.h"
+#include "surface_buffer.h"
+#include "sway_win.h"
+#include "trace.h"
+
+#include <cairo/cairo.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int _load_window(struct state *state, const char *tree_path) {
+    trace_begin("json_parse");
+    struct json_tape tape;
+    json_tape_init(&tape);
+    int err = json_tape_load_file(&tape, tree_path);
+    trace_end("json_parse");
+    if (err) {
+        LOG_ERR(
+            "Could not parse tree '%s' at offset %zu.", tree_path,
+            tape.error_offset
+        );
+        json_tape_finish(&tape);
+        return -1;
+    }
+
+    trace_begin("find_focused_window");
+    err = find_visible_windows(
+        &state->focused_window,
+        state->hint.enabled ? &state->hint.visible : NULL,
+        json_tape_root(&tape)
+    );
+    trace_end("find_focused_window");
+    json_tape_finish(&tape);
+
+    if (err) {
+        LOG_ERR("Could not find focused window.");
+        return -1;
+    }
+
+    state->focused_window_ready = true;
+    return 0;
+}
+
+static int _render(
+    struct state *state, const struct replay_options *options,
+    uint32_t scale_120
+) {
+    // Same buffer size as in `send_frame`.
+    struct surface_buffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.width         = state->surface_width * scale_120 / 120;
+    buffer.height        = state->surface_height * scale_120 / 120;
+    buffer.cairo_surface = cairo_image_surface_create(
+        CAIRO_FORMAT_ARGB32, buffer.width, buffer.height
+    );
+    if (cairo_surface_status(buffer.cairo_surface) != CAIRO_STATUS_SUCCESS) {
+        LOG_ERR("Could not create %ux%u image.", buffer.width, buffer.height);
+        cairo_surface_destroy(buffer.cairo_surface);
+        return -1;
+    }
+    buffer.cairo = cairo_create(buffer.cairo_surface);
+    buffer.data  = cairo_image_surface_get_data(buffer.cairo_surface);
+    buffer.state = SURFACE_BUFFER_READY;
+
+    struct render_pool pool;
+    render_pool_init(&pool, options->num_threads);
+    trace_begin("render");
+    render_pool_render(&pool, state, &buffer, scale_120 / 120.0, NULL);
+    trace_end("render");
+    render_pool_destroy(&pool);
+    surface_buffer_split_tiles(&buffer, 0);
+
+    int err = 0;
+    if (options->png_path != NULL) {
+        trace_begin("write_png");
+        cairo_status_t status = cairo_surface_write_to_png(
+            buffer.cairo_surface, options->png_path
+        );
+        trace_end("write_png");
+        if (status != CAIRO_STATUS_SUCCESS) {
+            LOG_ERR(
+                "Could not write '%s': %s", options->png_path,
+                cairo_status_to_string(status)
+            );
+            err = -1;
+        }
+    }
+
+    cairo_destroy(buffer.cairo);
+    cairo_surface_destroy(buffer.cairo_surface);
+    return err;
+}
+
+int replay_render(struct state *state, const struct replay_options *options) {
+    if (_load_window(state, options->tree_path) != 0) {
+        return -1;
+    }
+
+    struct focused_window *fw = &state->focused_window;
+    state->surface_width      = options->width;
+    state->surface_height     = options->height;
+    if (state->surface_width <= 0 || state->surface_height <= 0) {
+        state->surface_width  = fw->output_rect.w;
+        state->surface_height = fw->output_rect.h;
+    }
+
+    // The guides are computed once a window is picked.
+    hint_start(state);
+    if (!state->hint.picking) {
+        trace_begin("compute_guides");
+        resize_parameters_compute_guides(state->resize_params, fw);
+        trace_end("compute_guides");
+    }
+
+    int err = _render(state, options, lround(options->scale * 120));
+
+    free((void *)fw->output);
+    fw->output = NULL;
+    return err;
+}
@@ -0,0 +1,29 @@
+#ifndef __REPLAY_H_INCLUDED__
+#define __REPLAY_H_INCLUDED__
+
+#include "state.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct replay_options {
+    const char *tree_path;   // recorded GET_TREE reply
+    const char *png_path;    // not written if NULL
+    int32_t     width;       // surface size, the output size if 0
+    int32_t     height;
+    double      scale;
+    size_t      num_threads; // of the render pool
+};
+
+/*
+ * Render the overlay for a recorded tree without connecting to Sway or
+ * Wayland.
+ *
+ * The tree goes through the same steps as the reply of a live run, from
+ * finding the focused window to rendering with the render pool, into an
+ * image surface the size of the buffer a compositor would get. The guides
+ * must be loaded in the state.
+ */
+int replay_render(struct state *state, const struct replay_options *options);
+
+#endif
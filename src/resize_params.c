@@ -7,7 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-static int _load_resize_param_from_token(
+int resize_parameter_parse(
     struct resize_parameter *param, char *token,
     enum resize_direction *direction
 ) {
@@ -117,7 +117,7 @@ struct resize_parameters *load_resize_parameters(char *s) {
         struct resize_parameter param;
         enum resize_direction   direction;
 
-        if (_load_resize_param_from_token(&param, token, &direction) != 0) {
+        if (resize_parameter_parse(&param, token, &direction) != 0) {
             LOG_ERR("Could not parse token `%s`.", token);
             free_resize_params(params);
             return NULL;
@@ -153,8 +153,8 @@ struct resize_parameters *load_resize_parameters(char *s) {
     return params;
 }
 
-static int _resize_parameters_compute_guides(
-    struct resize_parameter *params, size_t len, struct focused_window *fw,
+bool resize_parameter_compute_guides(
+    struct resize_parameter *param, struct focused_window *fw,
     enum resize_direction direction
 ) {
     int32_t min_limit;
@@ -164,8 +164,6 @@ static int _resize_parameters_compute_guides(
     int32_t size;
     int32_t pos;
 
-    size_t num_applicable = 0;
-
     if (direction == RESIZE_HORIZONTAL) {
         min_limit         = fw->resize_left_limit;
         max_limit         = fw->resize_right_limit;
@@ -182,110 +180,114 @@ static int _resize_parameters_compute_guides(
         pos               = fw->rect.y;
     }
 
-    for (int i = 0; i < len; i++) {
-        struct resize_parameter *param = &params[i];
+    param->applicable = false;
 
-        if (!resizable_min_dir && !resizable_max_dir) {
-            param->applicable = false;
-            continue;
-        }
+    if (!resizable_min_dir && !resizable_max_dir) {
+        return false;
+    }
 
-        int32_t new_size;
+    int32_t new_size;
 
-        if (param->relative) {
-            new_size = param->percentage ? (100 + param->value) * size / 100
-                                         : size + param->value;
-        } else {
-            new_size = param->percentage
-                           ? (max_limit - min_limit) * param->value / 100
-                           : param->value;
-        }
+    if (param->relative) {
+        new_size = param->percentage ? (100 + param->value) * size / 100
+                                     : size + param->value;
+    } else {
+        new_size = param->percentage
+                       ? (max_limit - min_limit) * param->value / 100
+                       : param->value;
+    }
 
-        if (abs(new_size - size) < 2) {
-            param->applicable = false;
-            continue;
-        }
+    if (abs(new_size - size) < 2) {
+        return false;
+    }
 
-        int32_t guide_pos[2];
+    int32_t guide_pos[2];
 
-        if (new_size < 15) {
-            param->applicable = false;
-            continue;
-        }
+    if (new_size < 15) {
+        return false;
+    }
 
-        if (!resizable_min_dir) {
-            /*
-                pos
-                min_limit                    max_limit
-                |                            |
-            ----|--------|-------|-----------|------->
-                ^________^       ^
-                   size          guide_pos[0]
-                ^________________^
-                     new_size
-
-             */
-
-            guide_pos[0] = NO_GUIDE;
-            guide_pos[1] = new_size + pos;
-
-            if (guide_pos[1] > max_limit) {
-                param->applicable = false;
-                continue;
-            }
+    if (!resizable_min_dir) {
+        /*
+            pos
+            min_limit                    max_limit
+            |                            |
+        ----|--------|-------|-----------|------->
+            ^________^       ^
+               size          guide_pos[0]
+            ^________________^
+                 new_size
 
-        } else if (!resizable_max_dir) {
-            /*
-                min_limit                    max_limit
-                |                pos         |
-            ----|--------|-------|-----------|------->
-                         .       ^___________^
-                         .           size    .
-                         ^___________________^
-                                new_size
-             */
-
-            guide_pos[0] = pos + size - new_size;
-            guide_pos[1] = NO_GUIDE;
-
-            if (guide_pos[0] < min_limit) {
-                param->applicable = false;
-                continue;
-            }
-        } else {
-            /*
-                min_limit                                           max_limit
-                |                pos                                |
-            ----|--------|-------|-----------|-------|--------------|------->
-                         .       ^___________^       .
-                         .           size            .
-                         ^___________________________^
-                                   new_size
-             */
-
-            int32_t grow = (new_size - size) / 2;
-            guide_pos[0] = pos - grow;
-
-            if (guide_pos[0] < min_limit) {
-                param->applicable = false;
-                continue;
-            }
+         */
 
-            guide_pos[1] = pos + size + grow;
-            if (guide_pos[1] > max_limit) {
-                param->applicable = false;
-                continue;
-            }
+        guide_pos[0] = NO_GUIDE;
+        guide_pos[1] = new_size + pos;
+
+        if (guide_pos[1] > max_limit) {
+            return false;
+        }
+
+    } else if (!resizable_max_dir) {
+        /*
+            min_limit                    max_limit
+            |                pos         |
+        ----|--------|-------|-----------|------->
+                     .       ^___________^
+                     .           size    .
+                     ^___________________^
+                            new_size
+         */
+
+        guide_pos[0] = pos + size - new_size;
+        guide_pos[1] = NO_GUIDE;
+
+        if (guide_pos[0] < min_limit) {
+            return false;
+        }
+    } else {
+        /*
+            min_limit                                           max_limit
+            |                pos                                |
+        ----|--------|-------|-----------|-------|--------------|------->
+                     .       ^___________^       .
+                     .           size            .
+                     ^___________________________^
+                               new_size
+         */
+
+        int32_t grow = (new_size - size) / 2;
+        guide_pos[0] = pos - grow;
+
+        if (guide_pos[0] < min_limit) {
+            return false;
+        }
 
-            new_size = guide_pos[1] - guide_pos[0];
+        guide_pos[1] = pos + size + grow;
+        if (guide_pos[1] > max_limit) {
+            return false;
         }
 
-        param->size       = new_size;
-        param->guides[0]  = guide_pos[0];
-        param->guides[1]  = guide_pos[1];
-        param->applicable = true;
+        new_size = guide_pos[1] - guide_pos[0];
+    }
+
+    param->size       = new_size;
+    param->guides[0]  = guide_pos[0];
+    param->guides[1]  = guide_pos[1];
+    param->applicable = true;
+
+    return true;
+}
+
+static int _resize_parameters_compute_guides(
+    struct resize_parameter *params, size_t len, struct focused_window *fw,
+    enum resize_direction direction
+) {
+    size_t num_applicable = 0;
 
-        num_applicable++;
+    for (int i = 0; i < len; i++) {
+        if (resize_parameter_compute_guides(&params[i], fw, direction)) {
+            num_applicable++;
+        }
     }
 
     return num_applicable;
@@ -309,27 +311,44 @@ int resize_parameters_compute_guides(
            params->applicable_counts[RESIZE_HORIZONTAL] < 0;
 }
 
+void resize_parameter_apply(
+    struct resize_parameter *param, enum resize_direction direction,
+    struct focused_window *fw
+) {
+    if (direction == RESIZE_HORIZONTAL) {
+        if (param->guides[0] != NO_GUIDE) {
+            fw->rect.x = param->guides[0];
+        }
+        fw->rect.w = param->size;
+    } else {
+        if (param->guides[0] != NO_GUIDE) {
+            fw->rect.y = param->guides[0];
+        }
+        fw->rect.h = param->size;
+    }
+}
+
 static void
 _log_resize_params(struct resize_parameter *params, int len, const char *name) {
     if (len == 0) {
-        LOG_INFO("params[%s] = []", name);
+        LOG_DEBUG("params[%s] = []", name);
         return;
     }
 
     for (int i = 0; i < len; i++) {
         char symbol[5];
         rune_to_str(params[i].symbol, symbol);
-        LOG_INFO("params[%s][%d]", name, i);
-        LOG_INFO(" .symbol = %s (%d)", symbol, params[i].symbol);
-        LOG_INFO(" .value = %d", params[i].value);
-        LOG_INFO(" .relative = %s", params[i].relative ? "true" : "false");
-        LOG_INFO(" .percentage = %s", params[i].percentage ? "true" : "false");
-        LOG_INFO(" .applicable = %s", params[i].applicable ? "true" : "false");
+        LOG_DEBUG("params[%s][%d]", name, i);
+        LOG_DEBUG(" .symbol = %s (%d)", symbol, params[i].symbol);
+        LOG_DEBUG(" .value = %d", params[i].value);
+        LOG_DEBUG(" .relative = %s", params[i].relative ? "true" : "false");
+        LOG_DEBUG(" .percentage = %s", params[i].percentage ? "true" : "false");
+        LOG_DEBUG(" .applicable = %s", params[i].applicable ? "true" : "false");
 
         if (params[i].applicable) {
-            LOG_INFO("  .size = %d", params[i].size);
-            LOG_INFO("  .guides[0] = %d", params[i].guides[0]);
-            LOG_INFO("  .guides[1] = %d", params[i].guides[1]);
+            LOG_DEBUG("  .size = %d", params[i].size);
+            LOG_DEBUG("  .guides[0] = %d", params[i].guides[0]);
+            LOG_DEBUG("  .guides[1] = %d", params[i].guides[1]);
         }
     }
 }
@@ -43,10 +43,30 @@ const char *resize_direction_to_str(enum resize_direction direction);
  */
 struct resize_parameters *load_resize_parameters(char *s);
 
+// Parse a single guide, such as `a:h:+10%`. Return non-zero on error.
+int resize_parameter_parse(
+    struct resize_parameter *param, char *token,
+    enum resize_direction *direction
+);
+
 int resize_parameters_compute_guides(
     struct resize_parameters *params, struct focused_window *fw
 );
 
+// Compute the guides and target size of a single parameter. Return whether
+// the parameter is applicable to the window.
+bool resize_parameter_compute_guides(
+    struct resize_parameter *param, struct focused_window *fw,
+    enum resize_direction direction
+);
+
+// Update the window geometry as if the resize of an applicable parameter was
+// done.
+void resize_parameter_apply(
+    struct resize_parameter *param, enum resize_direction direction,
+    struct focused_window *fw
+);
+
 void log_resize_params(struct resize_parameters *params);
 
 struct resize_parameter *find_resize_param_by_symbol(
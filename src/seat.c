@@ -0,0 +1,481 @@
+#include "seat.h"
+
+#include "frame.h"
+#include "hint.h"
+#include "live.h"
+#include "log.h"
+#include "resize_params.h"
+#include "state.h"
+#include "trace.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <wayland-client-protocol.h>
+#include <xkbcommon/xkbcommon-keysyms.h>
+#include <xkbcommon/xkbcommon.h>
+
+static void noop() {}
+
+static void *_compile_keymap(void *data) {
+    struct seat *seat = data;
+
+    trace_begin("keymap_compile");
+    if (seat->keymap_data == NULL) {
+        seat->compiled_keymap = xkb_keymap_new_from_names(
+            seat->xkb_context, NULL, XKB_KEYMAP_COMPILE_NO_FLAGS
+        );
+    } else {
+        seat->compiled_keymap = xkb_keymap_new_from_buffer(
+            seat->xkb_context, seat->keymap_data, seat->keymap_size - 1,
+            XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS
+        );
+        munmap(seat->keymap_data, seat->keymap_size);
+        seat->keymap_data = NULL;
+    }
+    trace_end("keymap_compile");
+
+    atomic_store(&seat->keymap_compiled, true);
+
+    uint64_t one = 1;
+    if (write(seat->state->keymap_event_fd, &one, sizeof(one)) < 0) {
+        LOG_ERR("Could not notify keymap compilation.");
+    }
+
+    return NULL;
+}
+
+static void _set_key_repeat_timer(struct state *state, int32_t delay_ms) {
+    struct itimerspec spec = {0};
+    if (delay_ms > 0) {
+        int32_t interval_ms = 1000 / state->repeat_seat->repeat_rate;
+
+        spec.it_value.tv_sec     = delay_ms / 1000;
+        spec.it_value.tv_nsec    = (delay_ms % 1000) * 1000000;
+        spec.it_interval.tv_sec  = interval_ms / 1000;
+        spec.it_interval.tv_nsec = (interval_ms % 1000) * 1000000;
+    }
+
+    if (timerfd_settime(state->key_repeat_fd, 0, &spec, NULL) != 0) {
+        LOG_WARN("Could not set key repeat timer.");
+    }
+}
+
+static void _start_key_repeat(struct seat *seat, uint32_t key) {
+    struct state *state = seat->state;
+    if (state->key_repeat_fd < 0 || seat->repeat_rate <= 0 ||
+        !xkb_keymap_key_repeats(seat->xkb_keymap, key + 8)) {
+        return;
+    }
+
+    state->repeat_seat = seat;
+    state->repeat_key  = key;
+    _set_key_repeat_timer(state, seat->repeat_delay);
+}
+
+static void _stop_key_repeat(struct state *state) {
+    if (state->repeat_seat == NULL) {
+        return;
+    }
+
+    _set_key_repeat_timer(state, 0);
+    state->repeat_seat = NULL;
+}
+
+// Handle a key press, or its repetition while it is held. Return whether the
+// key triggered an action that makes sense to repeat.
+static bool _process_key_press(struct seat *seat, uint32_t key) {
+    struct state *state = seat->state;
+    char          text[64];
+
+    const xkb_keycode_t key_code = key + 8;
+    const xkb_keysym_t  key_sym =
+        xkb_state_key_get_one_sym(seat->xkb_state, key_code);
+    xkb_keysym_to_utf8(key_sym, text, sizeof(text));
+
+    if (key_sym == XKB_KEY_Escape) {
+        state->running = false;
+        return false;
+    }
+
+    uint32_t rune;
+    if (state->hint.picking) {
+        if (text[0] != '\0' && str_to_rune(text, &rune) > 0 &&
+            hint_handle_rune(state, rune)) {
+            request_frame(state);
+        }
+        return false;
+    }
+
+    if (state->live.enabled && live_handle_keysym(state, key_sym)) {
+        return state->running;
+    }
+
+    if (text[0] == '\0') {
+        return false;
+    }
+
+    str_to_rune(text, &rune);
+
+    struct resize_parameter *resize_param = find_resize_param_by_symbol(
+        state->resize_params, rune, &state->resize_direction
+    );
+    if (resize_param == NULL || !resize_param->applicable) {
+        return false;
+    }
+
+    return live_select(state, resize_param, state->resize_direction);
+}
+
+static void _process_key(
+    struct seat *seat, uint32_t time, uint32_t key, uint32_t key_state
+) {
+    struct state *state = seat->state;
+
+    // Keys typed after the one closing the overlay, replayed or not yet
+    // dispatched, must not resize again.
+    if (!state->running) {
+        return;
+    }
+
+    if (key_state != WL_KEYBOARD_KEY_STATE_PRESSED) {
+        if (state->repeat_seat == seat && state->repeat_key == key) {
+            _stop_key_repeat(state);
+        }
+        return;
+    }
+
+    trace_instant_arg("key_press", "time_ms", time);
+    latency_input(&state->latency, time);
+
+    _stop_key_repeat(state);
+    if (_process_key_press(seat, key)) {
+        _start_key_repeat(seat, key);
+    }
+    latency_input_done(&state->latency);
+}
+
+static void _process_modifiers(
+    struct seat *seat, uint32_t mods_depressed, uint32_t mods_latched,
+    uint32_t mods_locked, uint32_t group
+) {
+    xkb_state_update_mask(
+        seat->xkb_state, mods_depressed, mods_latched, mods_locked, 0, 0, group
+    );
+}
+
+static void _queue_event(
+    struct seat *seat, enum seat_pending_event_type type, uint32_t arg0,
+    uint32_t arg1, uint32_t arg2, uint32_t arg3
+) {
+    if (seat->num_pending_events == SEAT_MAX_PENDING_EVENTS) {
+        LOG_WARN("Dropping keyboard event received during startup.");
+        return;
+    }
+
+    seat->pending_events[seat->num_pending_events++] =
+        (struct seat_pending_event){
+            .type = type,
+            .args = {arg0, arg1, arg2, arg3},
+        };
+}
+
+// Keyboard events are queued until the keymap is installed and the guides
+// they pick from are computed.
+static bool _queue_events(struct seat *seat) {
+    return seat->xkb_state == NULL || !seat->state->focused_window_ready;
+}
+
+static void _replay_events(struct seat *seat) {
+    for (size_t i = 0;
+         i < seat->num_pending_events && seat->state->running; i++) {
+        struct seat_pending_event *event = &seat->pending_events[i];
+        switch (event->type) {
+        case SEAT_PENDING_KEY:
+            _process_key(
+                seat, event->args[0], event->args[1], event->args[2]
+            );
+            break;
+
+        case SEAT_PENDING_MODIFIERS:
+            _process_modifiers(
+                seat, event->args[0], event->args[1], event->args[2],
+                event->args[3]
+            );
+            break;
+        }
+    }
+    seat->num_pending_events = 0;
+}
+
+// Wait for the keymap worker, install its keymap and replay the queued
+// keyboard events if the guides are ready.
+static void _finish_keymap(struct seat *seat) {
+    pthread_join(seat->keymap_thread, NULL);
+    seat->keymap_compiling = false;
+
+    if (seat->compiled_keymap == NULL) {
+        LOG_ERR("Could not compile keymap.");
+        seat->num_pending_events = 0;
+        return;
+    }
+
+    seat->xkb_keymap      = seat->compiled_keymap;
+    seat->compiled_keymap = NULL;
+    seat->xkb_state       = xkb_state_new(seat->xkb_keymap);
+
+    if (!_queue_events(seat)) {
+        _replay_events(seat);
+    }
+}
+
+static void _free_keymap(struct seat *seat) {
+    if (seat->state->repeat_seat == seat) {
+        _stop_key_repeat(seat->state);
+    }
+
+    if (seat->keymap_compiling) {
+        pthread_join(seat->keymap_thread, NULL);
+        seat->keymap_compiling = false;
+
+        if (seat->compiled_keymap != NULL) {
+            xkb_keymap_unref(seat->compiled_keymap);
+            seat->compiled_keymap = NULL;
+        }
+    }
+
+    if (seat->xkb_state != NULL) {
+        xkb_state_unref(seat->xkb_state);
+        seat->xkb_state = NULL;
+    }
+    if (seat->xkb_keymap != NULL) {
+        xkb_keymap_unref(seat->xkb_keymap);
+        seat->xkb_keymap = NULL;
+    }
+    seat->num_pending_events = 0;
+}
+
+static void handle_keyboard_keymap(
+    void *data, struct wl_keyboard *keyboard, uint32_t format, int fd,
+    uint32_t size
+) {
+    struct seat *seat = data;
+    _free_keymap(seat);
+
+    seat->keymap_data = NULL;
+    seat->keymap_size = 0;
+
+    switch (format) {
+    case WL_KEYBOARD_KEYMAP_FORMAT_NO_KEYMAP:
+        break;
+
+    case WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1:;
+        void *buffer = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (buffer == MAP_FAILED) {
+            LOG_ERR("Could not mmap keymap data.");
+            close(fd);
+            return;
+        }
+
+        seat->keymap_data = buffer;
+        seat->keymap_size = size;
+        break;
+
+    default:
+        close(fd);
+        return;
+    }
+    close(fd);
+
+    // Nothing needs the keymap until the first key event, compile it while
+    // the surface gets created.
+    atomic_store(&seat->keymap_compiled, false);
+    seat->keymap_compiling = true;
+    if (pthread_create(&seat->keymap_thread, NULL, _compile_keymap, seat) !=
+        0) {
+        LOG_WARN("Could not start keymap thread, compiling synchronously.");
+        seat->keymap_compiling = false;
+        _compile_keymap(seat);
+
+        seat->xkb_keymap      = seat->compiled_keymap;
+        seat->compiled_keymap = NULL;
+        if (seat->xkb_keymap != NULL) {
+            seat->xkb_state = xkb_state_new(seat->xkb_keymap);
+        }
+    }
+}
+
+static void handle_keyboard_key(
+    void *data, struct wl_keyboard *keyboard, uint32_t serial, uint32_t time,
+    uint32_t key, uint32_t key_state
+) {
+    struct seat *seat = data;
+
+    if (_queue_events(seat)) {
+        _queue_event(seat, SEAT_PENDING_KEY, time, key, key_state, 0);
+        return;
+    }
+
+    _process_key(seat, time, key, key_state);
+}
+
+static void handle_keyboard_modifiers(
+    void *data, struct wl_keyboard *keyboard, uint32_t serial,
+    uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked,
+    uint32_t group
+) {
+    struct seat *seat = data;
+
+    if (_queue_events(seat)) {
+        _queue_event(
+            seat, SEAT_PENDING_MODIFIERS, mods_depressed, mods_latched,
+            mods_locked, group
+        );
+        return;
+    }
+
+    _process_modifiers(seat, mods_depressed, mods_latched, mods_locked, group);
+}
+
+static void handle_keyboard_repeat_info(
+    void *data, struct wl_keyboard *keyboard, int32_t rate, int32_t delay
+) {
+    struct seat *seat  = data;
+    seat->repeat_rate  = rate;
+    seat->repeat_delay = delay;
+}
+
+static void handle_keyboard_leave(
+    void *data, struct wl_keyboard *keyboard, uint32_t serial,
+    struct wl_surface *surface
+) {
+    struct seat *seat = data;
+    if (seat->state->repeat_seat == seat) {
+        _stop_key_repeat(seat->state);
+    }
+}
+
+static const struct wl_keyboard_listener wl_keyboard_listener = {
+    .keymap      = handle_keyboard_keymap,
+    .enter       = noop,
+    .leave       = handle_keyboard_leave,
+    .key         = handle_keyboard_key,
+    .modifiers   = handle_keyboard_modifiers,
+    .repeat_info = handle_keyboard_repeat_info,
+};
+
+static void handle_seat_capabilities(
+    void *data, struct wl_seat *wl_seat, uint32_t capabilities
+) {
+    struct seat *seat = data;
+    if (capabilities & WL_SEAT_CAPABILITY_KEYBOARD &&
+        seat->wl_keyboard == NULL) {
+        seat->wl_keyboard = wl_seat_get_keyboard(seat->wl_seat);
+        wl_keyboard_add_listener(
+            seat->wl_keyboard, &wl_keyboard_listener, data
+        );
+    }
+
+    if (capabilities & WL_SEAT_CAPABILITY_POINTER &&
+        seat->wl_pointer == NULL) {
+        pointer_init(seat, wl_seat_get_pointer(seat->wl_seat));
+    }
+}
+
+static const struct wl_seat_listener wl_seat_listener = {
+    .name         = noop,
+    .capabilities = handle_seat_capabilities,
+};
+
+struct seat *seat_create(struct state *state, struct wl_seat *wl_seat) {
+    struct seat *seat = calloc(1, sizeof(struct seat));
+    if (seat == NULL) {
+        LOG_ERR("Could not allocate seat.");
+        return NULL;
+    }
+
+    seat->wl_seat     = wl_seat;
+    seat->wl_keyboard = NULL;
+    seat->wl_pointer  = NULL;
+    seat->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    seat->xkb_state   = NULL;
+    seat->xkb_keymap  = NULL;
+    seat->state       = state;
+    atomic_init(&seat->keymap_compiled, false);
+
+    // Defaults used by compositors not sending repeat_info.
+    seat->repeat_rate  = 25;
+    seat->repeat_delay = 600;
+
+    wl_seat_add_listener(seat->wl_seat, &wl_seat_listener, seat);
+
+    return seat;
+}
+
+void seats_destroy(struct wl_list *seats) {
+    struct seat *seat;
+    struct seat *tmp;
+    wl_list_for_each_safe (seat, tmp, seats, link) {
+        if (seat->wl_keyboard != NULL) {
+            wl_keyboard_destroy(seat->wl_keyboard);
+        }
+
+        if (seat->wl_pointer != NULL) {
+            wl_pointer_destroy(seat->wl_pointer);
+        }
+
+        _free_keymap(seat);
+        if (seat->keymap_data != NULL) {
+            munmap(seat->keymap_data, seat->keymap_size);
+        }
+        xkb_context_unref(seat->xkb_context);
+
+        wl_seat_destroy(seat->wl_seat);
+        wl_list_remove(&seat->link);
+        free(seat);
+    }
+}
+
+void seats_handle_compiled_keymaps(struct state *state) {
+    uint64_t count;
+    if (read(state->keymap_event_fd, &count, sizeof(count)) < 0) {
+        LOG_WARN("Could not read keymap notification.");
+    }
+
+    struct seat *seat;
+    wl_list_for_each (seat, &state->seats, link) {
+        if (seat->keymap_compiling && atomic_load(&seat->keymap_compiled)) {
+            _finish_keymap(seat);
+        }
+    }
+}
+
+void seats_replay_events(struct state *state) {
+    struct seat *seat;
+    wl_list_for_each (seat, &state->seats, link) {
+        if (!_queue_events(seat)) {
+            _replay_events(seat);
+        }
+    }
+}
+
+void seats_handle_key_repeat(struct state *state) {
+    uint64_t expirations;
+    if (read(state->key_repeat_fd, &expirations, sizeof(expirations)) < 0) {
+        return;
+    }
+
+    // Expirations missed while busy are coalesced into a single repeat.
+    struct seat *seat = state->repeat_seat;
+    if (seat == NULL || seat->xkb_state == NULL || !state->running) {
+        return;
+    }
+
+    latency_input_now(&state->latency);
+    if (!_process_key_press(seat, state->repeat_key)) {
+        _stop_key_repeat(state);
+    }
+    latency_input_done(&state->latency);
+}
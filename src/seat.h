@@ -0,0 +1,67 @@
+#ifndef __SEAT_H_INCLUDED__
+#define __SEAT_H_INCLUDED__
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-client.h>
+#include <xkbcommon/xkbcommon.h>
+
+struct state;
+
+// Keyboard events received while the keymap is being compiled.
+#define SEAT_MAX_PENDING_EVENTS 32
+
+enum seat_pending_event_type {
+    SEAT_PENDING_KEY       = 0,
+    SEAT_PENDING_MODIFIERS = 1,
+};
+
+struct seat_pending_event {
+    enum seat_pending_event_type type;
+    uint32_t                     args[4];
+};
+
+struct seat {
+    struct wl_list      link; // type: struct seat
+    struct wl_seat     *wl_seat;
+    struct wl_keyboard *wl_keyboard;
+    struct wl_pointer  *wl_pointer;
+    struct xkb_context *xkb_context;
+    struct xkb_keymap  *xkb_keymap;
+    struct xkb_state   *xkb_state;
+    struct state       *state;
+    int32_t             repeat_rate;
+    int32_t             repeat_delay;
+    double              pointer_x;
+    double              pointer_y;
+
+    // Keymap compilation happens on `keymap_thread`. The keymap data is only
+    // accessed by the thread until `keymap_compiled` is set.
+    pthread_t          keymap_thread;
+    bool               keymap_compiling;
+    atomic_bool        keymap_compiled;
+    void              *keymap_data;
+    size_t             keymap_size;
+    struct xkb_keymap *compiled_keymap;
+
+    struct seat_pending_event pending_events[SEAT_MAX_PENDING_EVENTS];
+    size_t                    num_pending_events;
+};
+
+struct seat *seat_create(struct state *state, struct wl_seat *wl_seat);
+void         seats_destroy(struct wl_list *seats);
+
+// Install the keymaps compiled by the worker threads and replay the keyboard
+// events received in the meantime. Called when `state->keymap_event_fd` is
+// readable.
+void seats_handle_compiled_keymaps(struct state *state);
+
+// Replay the keyboard events received before the guides were computed.
+void seats_replay_events(struct state *state);
+
+// Repeat the held key. Called when `state->key_repeat_fd` expires.
+void seats_handle_key_repeat(struct state *state);
+
+#endif
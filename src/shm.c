@@ -0,0 +1,150 @@
+#include "shm.h"
+
+#include "log.h"
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define SHM_HUGE_PAGE_SIZE (2 << 20)
+
+static int _create_shm_file(unsigned int memfd_flags) {
+    int fd = memfd_create("sway-resize-shm", MFD_CLOEXEC | memfd_flags);
+    if (fd >= 0 || memfd_flags != 0) {
+        return fd;
+    }
+
+    char name[] = "/tmp/wl-shm-XXXXXX";
+    fd          = mkostemp(name, O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    unlink(name);
+    return fd;
+}
+
+static int _allocate_shm_file(size_t size, unsigned int memfd_flags) {
+    int fd = _create_shm_file(memfd_flags);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int err;
+    while ((err = ftruncate(fd, size)) && errno == EINTR) {}
+    if (err) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int _map_shm_file(
+    struct shm_mapping *mapping, size_t size, unsigned int memfd_flags
+) {
+    int fd = _allocate_shm_file(size, memfd_flags);
+    if (fd < 0) {
+        return -1;
+    }
+
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    mapping->fd   = fd;
+    mapping->data = data;
+    mapping->size = size;
+    stats_shm_mapped(size);
+    return 0;
+}
+
+static void _prefault(struct shm_mapping *mapping) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(mapping->data, mapping->size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+
+    // Kernels older than 5.14 can't populate a shared mapping for writing,
+    // MAP_POPULATE only maps the pages read-only. Write to each page instead.
+    volatile char *data      = mapping->data;
+    long           page_size = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < mapping->size; i += page_size) {
+        data[i] = 0;
+    }
+}
+
+static void *_prefault_thread(void *data) {
+    _prefault(data);
+    return NULL;
+}
+
+int shm_mapping_init(struct shm_mapping *mapping, size_t size, uint32_t flags) {
+    memset(mapping, 0, sizeof(struct shm_mapping));
+    mapping->fd = -1;
+
+    int err = -1;
+    if (flags & SHM_HUGE_PAGES) {
+#ifdef MFD_HUGETLB
+        // This fails unless huge pages are reserved in the hugetlb pool.
+        size_t huge_size =
+            (size + SHM_HUGE_PAGE_SIZE - 1) & ~(SHM_HUGE_PAGE_SIZE - 1);
+        err = _map_shm_file(mapping, huge_size, MFD_HUGETLB);
+#endif
+    }
+
+    if (err) {
+        if (_map_shm_file(mapping, size, 0) != 0) {
+            return -1;
+        }
+
+        if (flags & SHM_HUGE_PAGES) {
+            // Only honored when shmem_enabled is set to advise.
+            madvise(mapping->data, mapping->size, MADV_HUGEPAGE);
+        }
+    }
+
+    if (flags & SHM_PREFAULT_THREAD) {
+        if (pthread_create(
+                &mapping->prefault_thread, NULL, _prefault_thread, mapping
+            ) == 0) {
+            mapping->prefaulting = true;
+        } else {
+            LOG_WARN("Could not start prefault thread, prefaulting inline.");
+            _prefault(mapping);
+        }
+    } else if (flags & SHM_PREFAULT) {
+        _prefault(mapping);
+    }
+
+    return 0;
+}
+
+void shm_mapping_wait(struct shm_mapping *mapping) {
+    if (mapping->prefaulting) {
+        pthread_join(mapping->prefault_thread, NULL);
+        mapping->prefaulting = false;
+    }
+}
+
+void shm_mapping_finish(struct shm_mapping *mapping) {
+    shm_mapping_wait(mapping);
+
+    if (mapping->data != NULL) {
+        munmap(mapping->data, mapping->size);
+    }
+
+    if (mapping->fd >= 0) {
+        close(mapping->fd);
+    }
+
+    memset(mapping, 0, sizeof(struct shm_mapping));
+    mapping->fd = -1;
+}
@@ -0,0 +1,42 @@
+#ifndef __SHM_H_INCLUDED__
+#define __SHM_H_INCLUDED__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum shm_flags {
+    // Fault all pages in when mapping, so that the first render does not
+    // take a page fault every 4 KiB.
+    SHM_PREFAULT = 1 << 0,
+
+    // Back the mapping with huge pages, from the hugetlb pool if some are
+    // reserved, else with transparent huge pages if enabled for shmem.
+    SHM_HUGE_PAGES = 1 << 1,
+
+    // Fault the pages in on a thread instead, for mappings made ahead of
+    // time while something else is waited for.
+    SHM_PREFAULT_THREAD = 1 << 2,
+};
+
+struct shm_mapping {
+    int       fd;
+    void     *data;
+    size_t    size;
+    pthread_t prefault_thread;
+    bool      prefaulting;
+};
+
+// Create a shared memory file of at least `size` bytes and map it.
+// `mapping->size` is the actual size, rounded up to the page size used.
+// With SHM_PREFAULT_THREAD, shm_mapping_wait must be called before writing to
+// it.
+int shm_mapping_init(struct shm_mapping *mapping, size_t size, uint32_t flags);
+
+// Wait for the pages to be faulted in.
+void shm_mapping_wait(struct shm_mapping *mapping);
+
+void shm_mapping_finish(struct shm_mapping *mapping);
+
+#endif
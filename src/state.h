@@ -2,8 +2,16 @@
 #define __STATE_H_INCLUDED__
 
 #include "fractional-scale-v1-client-protocol.h"
+#include "hint.h"
+#include "latency.h"
+#include "live.h"
+#include "pointer.h"
+#include "preview.h"
+#include "render_thread.h"
 #include "resize_params.h"
+#include "seat.h"
 #include "surface_buffer.h"
+#include "sway_ipc.h"
 #include "viewporter-client-protocol.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 
@@ -11,31 +19,24 @@
 #include <stdint.h>
 #include <wayland-client.h>
 #include <wayland-util.h>
-#include <xkbcommon/xkbcommon.h>
 
 struct output {
     struct wl_list           link; // type: struct output
+    struct state            *state;
+    bool                     ready;
     struct wl_output        *wl_output;
     struct zxdg_output_v1   *xdg_output;
     char                    *name;
     int32_t                  scale;
     int32_t                  width;
     int32_t                  height;
+    int32_t                  mode_width;
+    int32_t                  mode_height;
     int32_t                  x;
     int32_t                  y;
     enum wl_output_transform transform;
 };
 
-struct seat {
-    struct wl_list      link; // type: struct seat
-    struct wl_seat     *wl_seat;
-    struct wl_keyboard *wl_keyboard;
-    struct xkb_context *xkb_context;
-    struct xkb_keymap  *xkb_keymap;
-    struct xkb_state   *xkb_state;
-    struct state       *state;
-};
-
 struct state {
     struct wl_display                     *wl_display;
     struct wl_registry                    *wl_registry;
@@ -45,23 +46,41 @@ struct state {
     struct wp_viewporter                  *wp_viewporter;
     struct wp_viewport                    *wp_viewport;
     struct wp_fractional_scale_manager_v1 *fractional_scale_mgr;
+    struct wp_fractional_scale_v1         *fractional_scale;
     struct surface_buffer_pool             surface_buffer_pool;
+    struct render_thread                   render_thread;
     struct wl_surface                     *wl_surface;
     struct wl_callback                    *wl_surface_callback;
+    bool                                   frame_pending; // while rendering
     struct zwlr_layer_surface_v1          *wl_layer_surface;
     struct zxdg_output_manager_v1         *xdg_output_manager;
     struct wl_list                         outputs;
+    int                                    pending_outputs;
     struct wl_list                         seats;
+    int                                    keymap_event_fd;
+    int                                    key_repeat_fd;
+    struct seat                           *repeat_seat;
+    uint32_t                               repeat_key;
+    struct sway_ipc_client                 sway_ipc;
     struct output                         *current_output;
+    char                                  *output_name; // focused workspace
     uint32_t                               scale_120;
     uint32_t                               surface_height;
     uint32_t                               surface_width;
     bool                                   running;
     bool                                   surface_configured;
+    bool                                   system_font;
     struct resize_parameters              *resize_params;
     struct focused_window                  focused_window;
+    bool                                   focused_window_ready;
     struct resize_parameter               *selected_resize;
     enum resize_direction                  resize_direction;
+    struct live_resize                     live;
+    struct hint_mode                       hint;
+    struct latency                         latency;
+    struct preview                         preview;
+    struct pointer_drag                    drag;
+    struct rect                            drawn_extent;
 };
 
 #endif
@@ -0,0 +1,139 @@
+#include "stats.h"
+
+#include "alloc_hook.h"
+#include "log.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#ifdef STATS_ALLOC
+static const char *phase_names[STATS_NUM_PHASES] = {
+    [STATS_PHASE_STARTUP]     = "startup",
+    [STATS_PHASE_INTERACTIVE] = "interactive",
+    [STATS_PHASE_TEARDOWN]    = "teardown",
+};
+#endif
+
+static struct {
+    bool                 enabled;
+    atomic_int           phase;
+    uint64_t             render_start_ns;
+    atomic_uint_fast64_t frames;
+    atomic_uint_fast64_t render_ns;
+    atomic_uint_fast64_t shm_bytes;
+    atomic_uint_fast64_t buffers_reused;
+    atomic_uint_fast64_t buffers_created;
+    atomic_uint_fast64_t ipc_bytes;
+    atomic_uint_fast64_t allocs[STATS_NUM_PHASES];
+    atomic_uint_fast64_t alloc_bytes[STATS_NUM_PHASES];
+} stats;
+
+static uint64_t _now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t _load(atomic_uint_fast64_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static void _add(atomic_uint_fast64_t *counter, uint64_t value) {
+    if (stats.enabled) {
+        atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+    }
+}
+
+static void _stats_write() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    uint64_t frames = _load(&stats.frames);
+    fprintf(
+        stderr,
+        "stats: frames=%llu render_ms=%.3f shm_bytes=%llu peak_rss_kb=%ld "
+        "buffers_reused=%llu buffers_created=%llu ipc_bytes=%llu",
+        (unsigned long long)frames,
+        frames == 0 ? 0 : _load(&stats.render_ns) / 1e6 / frames,
+        (unsigned long long)_load(&stats.shm_bytes), usage.ru_maxrss,
+        (unsigned long long)_load(&stats.buffers_reused),
+        (unsigned long long)_load(&stats.buffers_created),
+        (unsigned long long)_load(&stats.ipc_bytes)
+    );
+#ifdef STATS_ALLOC
+    for (int i = 0; i < STATS_NUM_PHASES; i++) {
+        fprintf(
+            stderr, " allocs_%s=%llu alloc_bytes_%s=%llu", phase_names[i],
+            (unsigned long long)_load(&stats.allocs[i]), phase_names[i],
+            (unsigned long long)_load(&stats.alloc_bytes[i])
+        );
+    }
+#endif
+    fputc('\n', stderr);
+}
+
+#ifdef STATS_ALLOC
+static void _count_alloc(size_t size, void *caller) {
+    int phase = atomic_load_explicit(&stats.phase, memory_order_relaxed);
+    _add(&stats.allocs[phase], 1);
+    _add(&stats.alloc_bytes[phase], size);
+}
+#endif
+
+int stats_init() {
+    if (atexit(_stats_write) != 0) {
+        LOG_ERR("Could not register stats report.");
+        return -1;
+    }
+
+    stats.enabled = true;
+#ifdef STATS_ALLOC
+    alloc_hook_set(_count_alloc);
+#endif
+    return 0;
+}
+
+bool stats_enabled() {
+    return stats.enabled;
+}
+
+void stats_set_phase(enum stats_phase phase) {
+    atomic_store_explicit(&stats.phase, phase, memory_order_relaxed);
+}
+
+void stats_render_begin() {
+    if (stats.enabled) {
+        stats.render_start_ns = _now_ns();
+    }
+}
+
+void stats_render_end() {
+    if (!stats.enabled) {
+        return;
+    }
+
+    _add(&stats.render_ns, _now_ns() - stats.render_start_ns);
+    if (atomic_fetch_add(&stats.frames, 1) == 0) {
+        stats_set_phase(STATS_PHASE_INTERACTIVE);
+    }
+}
+
+void stats_shm_mapped(size_t size) {
+    _add(&stats.shm_bytes, size);
+}
+
+void stats_buffer_reused() {
+    _add(&stats.buffers_reused, 1);
+}
+
+void stats_buffer_created() {
+    _add(&stats.buffers_created, 1);
+}
+
+void stats_ipc_received(size_t size) {
+    _add(&stats.ipc_bytes, size);
+}
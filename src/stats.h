@@ -0,0 +1,39 @@
+#ifndef __STATS_H_INCLUDED__
+#define __STATS_H_INCLUDED__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+enum stats_phase {
+    STATS_PHASE_STARTUP = 0, // until the first frame is drawn
+    STATS_PHASE_INTERACTIVE,
+    STATS_PHASE_TEARDOWN,
+    STATS_NUM_PHASES,
+};
+
+/*
+ * Counters of the work done by a run, reported on a single line.
+ *
+ * Nothing is counted until `stats_init` is called. Counters can be updated
+ * from any thread. Heap allocations are counted by the allocator wrappers of
+ * alloc_hook.c, built in with the `alloc_stats` meson option, on glibc only.
+ */
+
+// Start counting. The report is written to stderr when the program exits.
+int stats_init();
+
+bool stats_enabled();
+
+void stats_set_phase(enum stats_phase phase);
+
+// Time the rendering of a frame, on the render thread. The startup phase ends
+// with the first frame.
+void stats_render_begin();
+void stats_render_end();
+
+void stats_shm_mapped(size_t size);
+void stats_buffer_reused();
+void stats_buffer_created();
+void stats_ipc_received(size_t size);
+
+#endif
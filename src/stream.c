@@ -0,0 +1,318 @@
+#include "stream.h"
+
+#include "log.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define STREAM_READ_SIZE 4096
+
+static uint64_t _now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int _reserve(char **buf, size_t *cap, size_t needed) {
+    if (needed <= *cap) {
+        return 0;
+    }
+
+    size_t new_cap = *cap == 0 ? STREAM_READ_SIZE : *cap;
+    while (new_cap < needed) {
+        new_cap *= 2;
+    }
+
+    char *new_buf = realloc(*buf, new_cap);
+    if (new_buf == NULL) {
+        LOG_ERR("Could not allocate stream buffer.");
+        return -1;
+    }
+
+    *buf = new_buf;
+    *cap = new_cap;
+    return 0;
+}
+
+static void handle_command_reply(void *data, struct sway_ipc_msg *msg) {
+    struct stream *stream = data;
+    trace_async_end("stream_batch", stream->batches_replied++);
+
+    if (msg == NULL) {
+        LOG_ERR("Could not receive command reply.");
+        stream->failed = true;
+        return;
+    }
+
+    // Scripts wait for the replies, don't keep them in the buffer.
+    puts(msg->payload);
+    fflush(stdout);
+}
+
+static void _send_batch(struct stream *stream) {
+    if (stream->batch_count == 0) {
+        return;
+    }
+
+    trace_async_begin("stream_batch", stream->batches_sent++);
+    if (sway_ipc_client_send(
+            stream->client, SWAY_MSG_RUN_COMMAND, stream->batch,
+            stream->batch_len, handle_command_reply, stream
+        ) != 0) {
+        stream->failed = true;
+    }
+
+    stream->batch_len   = 0;
+    stream->batch_count = 0;
+}
+
+static void _add_command(
+    struct stream *stream, enum resize_direction direction, uint32_t size
+) {
+    char cmd[64];
+    int  len = snprintf(
+        cmd, sizeof(cmd), "%sresize set %s %dpx",
+        stream->batch_count > 0 ? ";" : "",
+        direction == RESIZE_VERTICAL ? "height" : "width", size
+    );
+
+    size_t needed = stream->batch_len + len;
+    if (_reserve(&stream->batch, &stream->batch_cap, needed) != 0) {
+        stream->failed = true;
+        return;
+    }
+
+    memcpy(stream->batch + stream->batch_len, cmd, len);
+    stream->batch_len += len;
+    stream->batch_count++;
+
+    if (stream->batch_count == STREAM_MAX_BATCH) {
+        _send_batch(stream);
+    }
+}
+
+static void _handle_line(struct stream *stream, char *line) {
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t' ||
+                       line[len - 1] == '\r')) {
+        line[--len] = '\0';
+    }
+
+    if (len == 0 || line[0] == '#') {
+        return;
+    }
+
+    struct resize_parameter param;
+    enum resize_direction   direction;
+    char                   *colon = strchr(line, ':');
+    if (colon != NULL) {
+        // The symbol can be left out, as with --apply.
+        char spec[STREAM_MAX_GUIDE];
+        int  n = snprintf(
+            spec, sizeof(spec), "%s%s",
+            strchr(colon + 1, ':') == NULL ? "=:" : "", line
+        );
+        if (n < 0 || (size_t)n >= sizeof(spec)) {
+            LOG_WARN("Guide is too long: `%.32s...`.", line);
+            return;
+        }
+        if (resize_parameter_parse(&param, spec, &direction) != 0) {
+            LOG_WARN("Could not parse guide `%s`.", line);
+            return;
+        }
+    } else {
+        uint32_t                 symbol = 0;
+        struct resize_parameter *found  = NULL;
+        if (stream->params != NULL &&
+            (size_t)str_to_rune(line, &symbol) == len) {
+            found = find_resize_param_by_symbol(
+                stream->params, symbol, &direction
+            );
+        }
+        if (found == NULL) {
+            LOG_WARN("No guide matches `%s`.", line);
+            return;
+        }
+        param = *found;
+    }
+
+    if (direction != RESIZE_HORIZONTAL && direction != RESIZE_VERTICAL) {
+        LOG_WARN("Only h and v guides can be applied: `%s`.", line);
+        return;
+    }
+
+    if (!resize_parameter_compute_guides(&param, stream->fw, direction)) {
+        LOG_WARN("Guide `%s` does not fit the focused window.", line);
+        return;
+    }
+
+    resize_parameter_apply(&param, direction, stream->fw);
+    _add_command(stream, direction, param.size);
+}
+
+static void _process(struct stream *stream);
+
+static void handle_tree_reply(void *data, struct sway_ipc_msg *msg) {
+    struct stream *stream = data;
+    trace_async_end("stream_tree", 0);
+    stream->model_pending = false;
+    stream->model_time_ms = _now_ms();
+
+    if (msg == NULL) {
+        LOG_ERR("Could not receive tree message.");
+        stream->failed = true;
+        return;
+    }
+
+    if (json_tape_parse(&stream->tape, msg->payload, msg->length) != 0) {
+        LOG_WARN("Could not parse tree, keeping the previous window.");
+        _process(stream);
+        return;
+    }
+
+    const struct json_node *tree = json_tape_root(&stream->tape);
+    struct focused_window   fw   = {0};
+    int                     err  = find_focused_window(&fw, tree);
+
+    if (err) {
+        LOG_WARN("Could not find focused window, keeping the previous one.");
+        free((void *)fw.output);
+    } else {
+        free((void *)stream->fw->output);
+        *stream->fw = fw;
+    }
+
+    _process(stream);
+}
+
+// Resolve all the complete lines, the last one doesn't need a line feed once
+// the input ended.
+static void _process(struct stream *stream) {
+    if (stream->model_pending || stream->failed) {
+        return;
+    }
+
+    bool complete =
+        stream->eof ? stream->input_len > 0
+                    : memchr(stream->input, '\n', stream->input_len) != NULL;
+    if (!complete) {
+        return;
+    }
+
+    if (_now_ms() - stream->model_time_ms > STREAM_MODEL_MAX_AGE_MS) {
+        trace_async_begin("stream_tree", 0);
+        stream->model_pending = true;
+        if (sway_ipc_client_send(
+                stream->client, SWAY_MSG_GET_TREE, "", 0, handle_tree_reply,
+                stream
+            ) != 0) {
+            stream->failed = true;
+        }
+        return;
+    }
+
+    // Room for the terminator was reserved when reading.
+    size_t processed = stream->input_len;
+    char  *end       = stream->input + processed;
+    if (!stream->eof) {
+        end       = memrchr(stream->input, '\n', stream->input_len);
+        processed = end - stream->input + 1;
+    }
+    *end = '\0';
+
+    char *strtok_p;
+    char *line = strtok_r(stream->input, "\n", &strtok_p);
+    while (line != NULL) {
+        _handle_line(stream, line);
+        line = strtok_r(NULL, "\n", &strtok_p);
+    }
+    _send_batch(stream);
+
+    stream->input_len -= processed;
+    memmove(stream->input, stream->input + processed, stream->input_len);
+}
+
+static void handle_input(void *data, int fd, short revents) {
+    struct stream *stream = data;
+
+    if (_reserve(
+            &stream->input, &stream->input_cap,
+            stream->input_len + STREAM_READ_SIZE + 1
+        ) != 0) {
+        stream->failed = true;
+        return;
+    }
+
+    ssize_t n = read(
+        stream->fd, stream->input + stream->input_len, STREAM_READ_SIZE
+    );
+    if (n < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+            return;
+        }
+        LOG_ERR("Could not read guides.");
+        n = 0;
+    }
+
+    if (n == 0) {
+        stream->eof = true;
+        event_loop_remove_fd(&stream->event_loop, stream->fd);
+    }
+
+    stream->input_len += n;
+    _process(stream);
+}
+
+int stream_init(
+    struct stream *stream, int fd, struct sway_ipc_client *client,
+    struct resize_parameters *params, struct focused_window *fw
+) {
+    memset(stream, 0, sizeof(struct stream));
+    stream->fd            = fd;
+    stream->client        = client;
+    stream->params        = params;
+    stream->fw            = fw;
+    stream->model_time_ms = _now_ms();
+    json_tape_init(&stream->tape);
+
+    event_loop_init(&stream->event_loop, NULL);
+    if (event_loop_add_fd(
+            &stream->event_loop, fd, POLLIN, handle_input, stream
+        ) != 0) {
+        return -1;
+    }
+
+    return sway_ipc_client_attach(client, &stream->event_loop);
+}
+
+int stream_run(struct stream *stream) {
+    while (!stream->failed && !stream->client->failed &&
+           (!stream->eof || stream->model_pending || stream->input_len > 0)) {
+        if (event_loop_dispatch(&stream->event_loop, -1) < 0) {
+            return -1;
+        }
+    }
+
+    if (stream->failed || sway_ipc_client_wait(stream->client) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void stream_finish(struct stream *stream) {
+    free(stream->input);
+    free(stream->batch);
+    json_tape_finish(&stream->tape);
+    memset(stream, 0, sizeof(struct stream));
+}
@@ -0,0 +1,70 @@
+#ifndef __STREAM_H_INCLUDED__
+#define __STREAM_H_INCLUDED__
+
+#include "event_loop.h"
+#include "resize_params.h"
+#include "sway_ipc.h"
+#include "sway_win.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Commands sent in a single message at most.
+#define STREAM_MAX_BATCH 256
+
+// Longest guide accepted on a line, a guide is a few dozen bytes.
+#define STREAM_MAX_GUIDE 256
+
+// The window model is fetched again before a batch if it is older than this,
+// to catch focus changes and resizes done by someone else.
+#define STREAM_MODEL_MAX_AGE_MS 200
+
+/*
+ * Resize the focused window to guides read line by line, e.g. `a:h:+10%`,
+ * `v:600` without symbol, or a symbol from the loaded guides.
+ *
+ * All the complete lines available are resolved against the cached window
+ * model, which is updated as if each resize was done, and their commands are
+ * sent in one message. Sway answers requests in order, so a tree fetched
+ * after a batch already includes its resizes.
+ */
+struct stream {
+    int                       fd;
+    bool                      eof;
+    bool                      failed;
+    struct event_loop         event_loop;
+    struct sway_ipc_client   *client;
+    struct resize_parameters *params;
+    struct focused_window    *fw;
+    uint64_t                  model_time_ms;
+    bool                      model_pending;
+    struct json_tape          tape; // of the last tree, buffers are reused
+
+    // Input not processed yet.
+    char  *input;
+    size_t input_len;
+    size_t input_cap;
+
+    // Commands of the next message, separated with `;`.
+    char    *batch;
+    size_t   batch_len;
+    size_t   batch_cap;
+    int      batch_count;
+    uint64_t batches_sent; // trace ids of the batches, replied in order
+    uint64_t batches_replied;
+};
+
+// `fw` was just fetched. `params` may be NULL when no guides were given.
+int stream_init(
+    struct stream *stream, int fd, struct sway_ipc_client *client,
+    struct resize_parameters *params, struct focused_window *fw
+);
+
+// Process the input until it ends and all the replies are received. Return
+// non-zero if the connection to Sway failed.
+int stream_run(struct stream *stream);
+
+void stream_finish(struct stream *stream);
+
+#endif
@@ -1,44 +1,15 @@
 #include "surface_buffer.h"
 
 #include "log.h"
+#include "stats.h"
 
 #include <cairo/cairo.h>
-#include <errno.h>
-#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <unistd.h>
 
 #define CAIRO_SURFACE_FORMAT CAIRO_FORMAT_ARGB32
 
-static int create_shm_file(void) {
-    char name[] = "/tmp/wl-shm-XXXXXX";
-    int  fd     = mkostemp(name, O_CLOEXEC);
-    if (fd < 0) {
-        return -1;
-    }
-
-    unlink(name);
-    return fd;
-}
-
-int allocate_shm_file(size_t size) {
-    int fd = create_shm_file();
-    if (fd < 0) {
-        return -1;
-    }
-
-    int err;
-    while ((err = ftruncate(fd, size)) && errno == EINTR) {}
-    if (err) {
-        close(fd);
-        return -1;
-    }
-
-    return fd;
-}
-
 static void handle_buffer_release(void *data, struct wl_buffer *wl_buffer) {
     ((struct surface_buffer *)data)->state = SURFACE_BUFFER_READY;
 }
@@ -48,42 +19,40 @@ static const struct wl_buffer_listener wl_buffer_listener = {
 };
 
 static struct surface_buffer *surface_buffer_init(
-    struct wl_shm *wl_shm, struct surface_buffer *buffer, int32_t width,
-    int32_t height
+    struct wl_shm *wl_shm, struct surface_buffer_pool *pool,
+    struct surface_buffer *buffer, int32_t width, int32_t height
 ) {
     const uint32_t stride =
         cairo_format_stride_for_width(CAIRO_SURFACE_FORMAT, width);
     const uint32_t data_size = height * stride;
-    void          *data;
 
-    int fd = allocate_shm_file(data_size);
-    if (fd < 0) {
+    if (pool->reserve.data != NULL && pool->reserve.size >= data_size) {
+        shm_mapping_wait(&pool->reserve);
+        buffer->shm = pool->reserve;
+        memset(&pool->reserve, 0, sizeof(struct shm_mapping));
+        pool->reserve.fd = -1;
+    } else if (shm_mapping_init(&buffer->shm, data_size, pool->flags) != 0) {
         LOG_ERR("Could not allocate shared buffer for surface buffer.");
         return NULL;
     }
 
-    data = mmap(NULL, data_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-    if (data == MAP_FAILED) {
-        LOG_ERR("Could not mmap shared buffer for surface buffer.");
-
-        close(fd);
-        return NULL;
-    }
-
-    struct wl_shm_pool *wl_shm_pool = wl_shm_create_pool(wl_shm, fd, data_size);
-    buffer->wl_buffer               = wl_shm_pool_create_buffer(
+    struct wl_shm_pool *wl_shm_pool =
+        wl_shm_create_pool(wl_shm, buffer->shm.fd, buffer->shm.size);
+    buffer->wl_buffer = wl_shm_pool_create_buffer(
         wl_shm_pool, 0, width, height, stride, WL_SHM_FORMAT_ARGB8888
     );
     wl_buffer_add_listener(buffer->wl_buffer, &wl_buffer_listener, buffer);
     wl_shm_pool_destroy(wl_shm_pool);
 
-    close(fd);
+    close(buffer->shm.fd);
+    buffer->shm.fd = -1;
 
-    buffer->data      = data;
-    buffer->data_size = data_size;
-    buffer->width     = width;
-    buffer->height    = height;
-    buffer->state     = SURFACE_BUFFER_READY;
+    buffer->data        = buffer->shm.data;
+    buffer->data_size   = data_size;
+    buffer->width       = width;
+    buffer->height      = height;
+    buffer->state       = SURFACE_BUFFER_READY;
+    buffer->full_damage = true;
 
     buffer->cairo_surface = cairo_image_surface_create_for_data(
         buffer->data, CAIRO_SURFACE_FORMAT, width, height, stride
@@ -98,6 +67,8 @@ static void surface_buffer_destroy(struct surface_buffer *buffer) {
         return;
     }
 
+    surface_buffer_split_tiles(buffer, 0);
+
     if (buffer->cairo) {
         cairo_destroy(buffer->cairo);
     }
@@ -110,20 +81,45 @@ static void surface_buffer_destroy(struct surface_buffer *buffer) {
         wl_buffer_destroy(buffer->wl_buffer);
     }
 
-    if (buffer->data) {
-        munmap(buffer->data, buffer->data_size);
-    }
+    shm_mapping_finish(&buffer->shm);
 
     memset(buffer, 0, sizeof(struct surface_buffer));
 }
 
-void surface_buffer_pool_init(struct surface_buffer_pool *pool) {
+void surface_buffer_pool_init(
+    struct surface_buffer_pool *pool, uint32_t shm_flags
+) {
     memset(pool, 0, sizeof(struct surface_buffer_pool));
+    pool->flags      = shm_flags;
+    pool->reserve.fd = -1;
 }
 
 void surface_buffer_pool_destroy(struct surface_buffer_pool *pool) {
     surface_buffer_destroy(&pool->buffers[0]);
     surface_buffer_destroy(&pool->buffers[1]);
+    shm_mapping_finish(&pool->reserve);
+}
+
+int surface_buffer_pool_reserve(
+    struct surface_buffer_pool *pool, uint32_t width, uint32_t height
+) {
+    shm_mapping_finish(&pool->reserve);
+
+    // Only the reserved mapping has time to be prefaulted in the background,
+    // the other buffers are needed right away.
+    uint32_t flags = pool->flags;
+    if (flags & SHM_PREFAULT) {
+        flags |= SHM_PREFAULT_THREAD;
+    }
+
+    const uint32_t stride =
+        cairo_format_stride_for_width(CAIRO_SURFACE_FORMAT, width);
+    if (shm_mapping_init(&pool->reserve, height * stride, flags) != 0) {
+        LOG_WARN("Could not reserve shared memory for the first buffer.");
+        return -1;
+    }
+
+    return 0;
 }
 
 struct surface_buffer *get_next_buffer(
@@ -148,11 +144,62 @@ struct surface_buffer *get_next_buffer(
     }
 
     if (buffer->state == SURFACE_BUFFER_UNITIALIZED) {
-        if (surface_buffer_init(wl_shm, buffer, width, height) == NULL) {
+        if (surface_buffer_init(wl_shm, pool, buffer, width, height) == NULL) {
             LOG_ERR("Could not initialize next buffer.");
             return NULL;
         }
+        stats_buffer_created();
+    } else {
+        stats_buffer_reused();
     }
 
     return buffer;
 }
+
+int surface_buffer_split_tiles(
+    struct surface_buffer *buffer, size_t num_tiles
+) {
+    if (buffer->num_tiles == num_tiles) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < buffer->num_tiles; i++) {
+        cairo_destroy(buffer->tiles[i].cairo);
+        cairo_surface_destroy(buffer->tiles[i].cairo_surface);
+    }
+    free(buffer->tiles);
+    buffer->tiles     = NULL;
+    buffer->num_tiles = 0;
+
+    if (num_tiles == 0) {
+        return 0;
+    }
+
+    buffer->tiles = calloc(num_tiles, sizeof(struct surface_buffer_tile));
+    if (buffer->tiles == NULL) {
+        LOG_ERR("Could not allocate surface buffer tiles.");
+        return -1;
+    }
+
+    const uint32_t stride =
+        cairo_format_stride_for_width(CAIRO_SURFACE_FORMAT, buffer->width);
+    uint32_t y = 0;
+    for (size_t i = 0; i < num_tiles; i++) {
+        struct surface_buffer_tile *tile = &buffer->tiles[i];
+
+        // Spread the remaining rows over the first tiles.
+        tile->y      = y;
+        tile->height = buffer->height / num_tiles +
+                       (i < buffer->height % num_tiles ? 1 : 0);
+        y           += tile->height;
+
+        tile->cairo_surface = cairo_image_surface_create_for_data(
+            (unsigned char *)buffer->data + tile->y * stride,
+            CAIRO_SURFACE_FORMAT, buffer->width, tile->height, stride
+        );
+        tile->cairo = cairo_create(tile->cairo_surface);
+    }
+    buffer->num_tiles = num_tiles;
+
+    return 0;
+}
@@ -1,6 +1,9 @@
 #ifndef __SURFACE_BUFFER_H_INCLUDED__
 #define __SURFACE_BUFFER_H_INCLUDED__
 
+#include "shm.h"
+#include "utils.h"
+
 #include <cairo/cairo.h>
 #include <wayland-client.h>
 
@@ -13,29 +16,62 @@ enum surface_buffer_state {
     SURFACE_BUFFER_BUSY  = 2,
 };
 
+// Horizontal band of a surface buffer with its own cairo context, so that
+// several threads can render into the same buffer.
+struct surface_buffer_tile {
+    cairo_surface_t *cairo_surface;
+    cairo_t         *cairo;
+    uint32_t         y;
+    uint32_t         height;
+};
+
 struct surface_buffer {
-    enum surface_buffer_state state;
-    struct wl_buffer         *wl_buffer;
-    cairo_surface_t          *cairo_surface;
-    cairo_t                  *cairo;
-    void                     *data;
-    size_t                    data_size;
-    uint32_t                  width;
-    uint32_t                  height;
+    enum surface_buffer_state   state;
+    struct shm_mapping          shm;
+    struct wl_buffer           *wl_buffer;
+    cairo_surface_t            *cairo_surface;
+    cairo_t                    *cairo;
+    void                       *data;
+    size_t                      data_size;
+    uint32_t                    width;
+    uint32_t                    height;
+    struct surface_buffer_tile *tiles;
+    size_t                      num_tiles;
+
+    // Area that changed since the buffer was last drawn, in surface
+    // coordinates. A new buffer has no content and is drawn whole.
+    struct rect damage;
+    bool        full_damage;
 };
 
 struct surface_buffer_pool {
     struct surface_buffer buffers[2];
+    uint32_t              flags; // enum shm_flags
+    struct shm_mapping    reserve;
 };
 
-void surface_buffer_pool_init(struct surface_buffer_pool *pool);
+void surface_buffer_pool_init(
+    struct surface_buffer_pool *pool, uint32_t shm_flags
+);
 void surface_buffer_pool_destroy(struct surface_buffer_pool *pool);
 
+// Map the memory of a buffer of the given size ahead of time, so that it can
+// be prefaulted while waiting for the surface to be configured. The next
+// buffer that fits in it takes it over.
+int surface_buffer_pool_reserve(
+    struct surface_buffer_pool *pool, uint32_t width, uint32_t height
+);
+
 struct surface_buffer *get_next_buffer(
     struct wl_shm *wl_shm, struct surface_buffer_pool *pool, uint32_t width,
     uint32_t height
 );
 
-int allocate_shm_file(size_t size);
+// Split the buffer into `num_tiles` horizontal tiles. The tiles are kept
+// until the buffer is destroyed or split differently. Splitting into 0 tiles
+// frees them.
+int surface_buffer_split_tiles(
+    struct surface_buffer *buffer, size_t num_tiles
+);
 
 #endif
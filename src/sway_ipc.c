@@ -1,21 +1,25 @@
 #include "sway_ipc.h"
 
+#include "event_loop.h"
 #include "log.h"
+#include "stats.h"
 
-#include <jansson.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
-struct sway_ipc_msg_header {
-    char     magic[6];
-    uint32_t length;
-    uint32_t type;
-} __attribute__((__packed__));
+#define SWAY_IPC_MAGIC "i3-ipc"
+
+// Upper bound of frames written by a single writev.
+#define SWAY_IPC_MAX_WRITE_FRAMES 32
 
 int sway_ipc_open_socket() {
     char *socket_path = getenv("SWAYSOCK");
@@ -24,7 +28,7 @@ int sway_ipc_open_socket() {
         return -1;
     }
 
-    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (fd == -1) {
         LOG_ERR("Unable to create UNIX socket.");
         return -2;
@@ -40,73 +44,513 @@ int sway_ipc_open_socket() {
     if (connect(fd, (struct sockaddr *)&addr, sizeof(struct sockaddr_un)) ==
         -1) {
         LOG_ERR("Unable to connect to '%s'.", socket_path);
+        close(fd);
         return -3;
     }
 
     return fd;
 }
 
+// Gathered write of the iovec array. This is `writev` with MSG_NOSIGNAL, so
+// that Sway going away is reported as an error instead of killing us with
+// SIGPIPE.
+static ssize_t _writev(int fd, struct iovec *iov, int iovcnt) {
+    struct msghdr msg = {
+        .msg_iov    = iov,
+        .msg_iovlen = iovcnt,
+    };
+
+    return sendmsg(fd, &msg, MSG_NOSIGNAL);
+}
+
+// Write the whole iovec array, retrying on partial writes and interruptions.
+static int _writev_all(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t written = _writev(fd, iov, iovcnt);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        while (iovcnt > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base  = (char *)iov->iov_base + written;
+            iov->iov_len  -= written;
+        }
+    }
+
+    return 0;
+}
+
 int sway_ipc_send(
     int fd, enum sway_ipc_msg_type type, char *payload, uint32_t len
 ) {
     struct sway_ipc_msg_header header = {
-        .magic  = "i3-ipc",
+        .magic  = SWAY_IPC_MAGIC,
         .length = len,
         .type   = type,
     };
 
-    if (write(fd, &header, sizeof(header)) < 0) {
-        LOG_ERR("Could not send header.");
-        return 0;
-    }
+    struct iovec iov[] = {
+        {.iov_base = &header, .iov_len = sizeof(header)},
+        {.iov_base = payload, .iov_len = len},
+    };
 
-    if (write(fd, payload, len) < 0) {
-        LOG_ERR("Could not send payload.");
+    if (_writev_all(fd, iov, len == 0 ? 1 : 2) < 0) {
+        LOG_ERR("Could not send message.");
         return 0;
     }
 
     return 1;
 }
 
-struct sway_ipc_msg *sway_ipc_recv(int fd) {
-    struct sway_ipc_msg_header header;
-
-    char  *buf   = (char *)&header;
+// Receive exactly `len` bytes. Return < 0 on error or if the peer closed
+// the connection.
+static int _recv_all(int fd, void *buf, size_t len) {
     size_t buf_i = 0;
-    while (buf_i < sizeof(header)) {
-        ssize_t received = recv(fd, buf + buf_i, sizeof(header) - buf_i, 0);
+    while (buf_i < len) {
+        ssize_t received = recv(fd, (char *)buf + buf_i, len - buf_i, 0);
         if (received < 0) {
-            LOG_ERR("Could not recieve header.");
-            return NULL;
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (received == 0) {
+            errno = ECONNRESET;
+            return -1;
         }
 
         buf_i += received;
+        stats_ipc_received(received);
+    }
+
+    return 0;
+}
+
+struct sway_ipc_msg *sway_ipc_recv(int fd) {
+    struct sway_ipc_msg_header header;
+
+    if (_recv_all(fd, &header, sizeof(header)) < 0) {
+        LOG_ERR("Could not receive header.");
+        return NULL;
     }
 
     struct sway_ipc_msg *msg =
         malloc(sizeof(struct sway_ipc_msg) + header.length + 1);
-    msg->length = header.length;
-    msg->type   = header.type;
-
     if (msg == NULL) {
         LOG_ERR("Could not allocate message buffer.");
         return NULL;
     }
 
-    buf_i = 0;
-    while (buf_i < header.length) {
-        ssize_t received =
-            recv(fd, msg->payload + buf_i, header.length - buf_i, 0);
-        if (received < 0) {
-            LOG_ERR("Could not receive payload.");
-            return NULL;
-        }
+    msg->length = header.length;
+    msg->type   = header.type;
 
-        buf_i += received;
+    if (_recv_all(fd, msg->payload, header.length) < 0) {
+        LOG_ERR("Could not receive payload.");
+        free(msg);
+        return NULL;
     }
 
     // If the payload is a string, we want to make sure it is null terminated.
-    msg->payload[buf_i] = 0;
+    msg->payload[header.length] = 0;
 
     return msg;
 }
+
+int sway_ipc_client_init(struct sway_ipc_client *client, int fd) {
+    memset(client, 0, sizeof(struct sway_ipc_client));
+    client->fd = fd;
+
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        LOG_ERR("Could not make Sway socket non-blocking.");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void _fail(struct sway_ipc_client *client) {
+    if (client->failed) {
+        return;
+    }
+    client->failed = true;
+
+    if (client->event_loop != NULL) {
+        event_loop_remove_fd(client->event_loop, client->fd);
+        client->event_loop = NULL;
+    }
+
+    // Handlers may queue new requests, which fail right away.
+    while (client->in_flight_len > 0) {
+        struct sway_ipc_request request =
+            client->in_flight[client->in_flight_head++];
+        client->in_flight_len--;
+        if (request.handler != NULL) {
+            request.handler(request.data, NULL);
+        }
+    }
+    while (client->frames_len > 0) {
+        struct sway_ipc_frame frame = client->frames[client->frames_head++];
+        client->frames_len--;
+        if (frame.handler != NULL) {
+            frame.handler(frame.data, NULL);
+        }
+    }
+}
+
+void sway_ipc_client_finish(struct sway_ipc_client *client) {
+    // Nobody waits for the replies anymore, e.g. when the overlay is closed
+    // before the tree is received. Their handlers would report an error.
+    client->in_flight_len = 0;
+    client->frames_len    = 0;
+    _fail(client);
+
+    close(client->fd);
+    free(client->frames);
+    free(client->payloads);
+    free(client->in_flight);
+    free(client->msg);
+    memset(client, 0, sizeof(struct sway_ipc_client));
+    client->fd = -1;
+}
+
+static void _update_events(struct sway_ipc_client *client) {
+    if (client->event_loop != NULL) {
+        event_loop_set_events(
+            client->event_loop, client->fd,
+            client->frames_len > 0 ? POLLIN | POLLOUT : POLLIN
+        );
+    }
+}
+
+static void _handle_events(void *data, int fd, short revents) {
+    struct sway_ipc_client *client = data;
+
+    if (revents & POLLOUT) {
+        sway_ipc_client_flush(client);
+    }
+
+    if (revents & (POLLIN | POLLHUP | POLLERR)) {
+        sway_ipc_client_dispatch(client);
+    }
+}
+
+int sway_ipc_client_attach(
+    struct sway_ipc_client *client, struct event_loop *event_loop
+) {
+    if (event_loop_add_fd(
+            event_loop, client->fd, POLLIN, _handle_events, client
+        ) != 0) {
+        return -1;
+    }
+
+    client->event_loop = event_loop;
+    _update_events(client);
+
+    return 0;
+}
+
+// Make room for one more element in a FIFO array, dropping the consumed
+// head first.
+static int _fifo_reserve(
+    void **array, size_t elem_size, size_t *head, size_t len, size_t *cap
+) {
+    if (*head + len < *cap) {
+        return 0;
+    }
+
+    if (*head > 0) {
+        memmove(*array, (char *)*array + *head * elem_size, len * elem_size);
+        *head = 0;
+        if (len < *cap) {
+            return 0;
+        }
+    }
+
+    size_t new_cap   = *cap == 0 ? 8 : *cap * 2;
+    void  *new_array = realloc(*array, new_cap * elem_size);
+    if (new_array == NULL) {
+        return -1;
+    }
+
+    *array = new_array;
+    *cap   = new_cap;
+
+    return 0;
+}
+
+int sway_ipc_client_send(
+    struct sway_ipc_client *client, enum sway_ipc_msg_type type,
+    const char *payload, uint32_t len, sway_ipc_reply_handler_t handler,
+    void *data
+) {
+    if (client->failed) {
+        return -1;
+    }
+
+    if (_fifo_reserve(
+            (void **)&client->frames, sizeof(struct sway_ipc_frame),
+            &client->frames_head, client->frames_len, &client->frames_cap
+        ) != 0) {
+        LOG_ERR("Could not allocate IPC frame.");
+        return -1;
+    }
+
+    if (client->payloads_len + len > client->payloads_cap) {
+        size_t new_cap = client->payloads_cap == 0 ? 256 : client->payloads_cap;
+        while (new_cap < client->payloads_len + len) {
+            new_cap *= 2;
+        }
+
+        char *payloads = realloc(client->payloads, new_cap);
+        if (payloads == NULL) {
+            LOG_ERR("Could not allocate IPC payload.");
+            return -1;
+        }
+        client->payloads     = payloads;
+        client->payloads_cap = new_cap;
+    }
+
+    memcpy(client->payloads + client->payloads_len, payload, len);
+
+    client->frames[client->frames_head + client->frames_len++] =
+        (struct sway_ipc_frame){
+            .header =
+                {
+                    .magic  = SWAY_IPC_MAGIC,
+                    .length = len,
+                    .type   = type,
+                },
+            .payload_offset = client->payloads_len,
+            .handler        = handler,
+            .data           = data,
+        };
+    client->payloads_len += len;
+
+    return sway_ipc_client_flush(client);
+}
+
+int sway_ipc_client_flush(struct sway_ipc_client *client) {
+    while (client->frames_len > 0 && !client->failed) {
+        struct iovec iov[SWAY_IPC_MAX_WRITE_FRAMES * 2];
+        int          iovcnt = 0;
+
+        for (size_t i = 0;
+             i < client->frames_len && i < SWAY_IPC_MAX_WRITE_FRAMES; i++) {
+            struct sway_ipc_frame *frame =
+                &client->frames[client->frames_head + i];
+
+            iov[iovcnt++] = (struct iovec){
+                .iov_base = &frame->header,
+                .iov_len  = sizeof(frame->header),
+            };
+            if (frame->header.length > 0) {
+                iov[iovcnt++] = (struct iovec){
+                    .iov_base = client->payloads + frame->payload_offset,
+                    .iov_len  = frame->header.length,
+                };
+            }
+        }
+
+        // Skip what was written by a previous partial write.
+        size_t skip = client->sent;
+        int    first = 0;
+        while (skip >= iov[first].iov_len) {
+            skip -= iov[first++].iov_len;
+        }
+        iov[first].iov_base  = (char *)iov[first].iov_base + skip;
+        iov[first].iov_len  -= skip;
+
+        ssize_t written = _writev(client->fd, iov + first, iovcnt - first);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+
+            LOG_ERR("Could not send IPC message.");
+            _fail(client);
+            return -1;
+        }
+
+        client->sent += written;
+        while (client->frames_len > 0) {
+            struct sway_ipc_frame *frame =
+                &client->frames[client->frames_head];
+            size_t frame_size = sizeof(frame->header) + frame->header.length;
+            if (client->sent < frame_size) {
+                break;
+            }
+
+            if (_fifo_reserve(
+                    (void **)&client->in_flight,
+                    sizeof(struct sway_ipc_request), &client->in_flight_head,
+                    client->in_flight_len, &client->in_flight_cap
+                ) != 0) {
+                LOG_ERR("Could not allocate IPC request.");
+                _fail(client);
+                return -1;
+            }
+            size_t tail = client->in_flight_head + client->in_flight_len++;
+            client->in_flight[tail] = (struct sway_ipc_request){
+                .handler = frame->handler,
+                .data    = frame->data,
+            };
+
+            client->sent -= frame_size;
+            client->frames_head++;
+            client->frames_len--;
+        }
+    }
+
+    if (client->frames_len == 0) {
+        client->frames_head  = 0;
+        client->payloads_len = 0;
+    }
+
+    _update_events(client);
+
+    return client->failed ? -1 : 0;
+}
+
+// Receive into `buf` without blocking. Return the number of bytes received,
+// 0 if nothing is available and < 0 on error or end of stream.
+static ssize_t _recv_some(int fd, void *buf, size_t len) {
+    for (;;) {
+        ssize_t received = recv(fd, buf, len, 0);
+        if (received > 0) {
+            stats_ipc_received(received);
+            return received;
+        }
+        if (received == 0) {
+            LOG_ERR("Sway closed the IPC connection.");
+            return -1;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+
+        LOG_ERR("Could not receive IPC message.");
+        return -1;
+    }
+}
+
+int sway_ipc_client_dispatch(struct sway_ipc_client *client) {
+    while (!client->failed) {
+        if (client->header_received < sizeof(client->header)) {
+            ssize_t received = _recv_some(
+                client->fd, (char *)&client->header + client->header_received,
+                sizeof(client->header) - client->header_received
+            );
+            if (received < 0) {
+                _fail(client);
+                return -1;
+            }
+            if (received == 0) {
+                return 0;
+            }
+
+            client->header_received += received;
+            if (client->header_received < sizeof(client->header)) {
+                continue;
+            }
+
+            size_t msg_size =
+                sizeof(struct sway_ipc_msg) + client->header.length + 1;
+            if (msg_size > client->msg_cap) {
+                struct sway_ipc_msg *msg = realloc(client->msg, msg_size);
+                if (msg == NULL) {
+                    LOG_ERR("Could not allocate message buffer.");
+                    _fail(client);
+                    return -1;
+                }
+                client->msg     = msg;
+                client->msg_cap = msg_size;
+            }
+
+            client->msg->length      = client->header.length;
+            client->msg->type        = client->header.type;
+            client->payload_received = 0;
+        }
+
+        if (client->payload_received < client->header.length) {
+            ssize_t received = _recv_some(
+                client->fd, client->msg->payload + client->payload_received,
+                client->header.length - client->payload_received
+            );
+            if (received < 0) {
+                _fail(client);
+                return -1;
+            }
+            if (received == 0) {
+                return 0;
+            }
+
+            client->payload_received += received;
+            if (client->payload_received < client->header.length) {
+                continue;
+            }
+        }
+
+        client->msg->payload[client->header.length] = '\0';
+        client->header_received                     = 0;
+
+        if (client->in_flight_len == 0) {
+            LOG_WARN("Dropping unexpected IPC reply.");
+            continue;
+        }
+
+        struct sway_ipc_request request =
+            client->in_flight[client->in_flight_head++];
+        client->in_flight_len--;
+        if (client->in_flight_len == 0) {
+            client->in_flight_head = 0;
+        }
+
+        if (request.handler != NULL) {
+            request.handler(request.data, client->msg);
+        }
+    }
+
+    return -1;
+}
+
+int sway_ipc_client_wait(struct sway_ipc_client *client) {
+    while (!client->failed &&
+           (client->frames_len > 0 || client->in_flight_len > 0)) {
+        struct pollfd pollfd = {
+            .fd     = client->fd,
+            .events = client->frames_len > 0 ? POLLIN | POLLOUT : POLLIN,
+        };
+
+        if (poll(&pollfd, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERR("Could not poll Sway socket.");
+            return -1;
+        }
+
+        if (pollfd.revents & POLLOUT) {
+            sway_ipc_client_flush(client);
+        }
+        if (pollfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            sway_ipc_client_dispatch(client);
+        }
+    }
+
+    return client->failed ? -1 : 0;
+}
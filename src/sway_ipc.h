@@ -1,17 +1,28 @@
 #ifndef __SWAY_IPC_H_INCLUDED__
 #define __SWAY_IPC_H_INCLUDED__
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+struct event_loop;
+
 struct sway_ipc_msg {
     uint32_t length;
     uint32_t type;
     char     payload[];
 };
 
+struct sway_ipc_msg_header {
+    char     magic[6];
+    uint32_t length;
+    uint32_t type;
+} __attribute__((__packed__));
+
 enum sway_ipc_msg_type {
-    SWAY_MSG_RUN_COMMAND = 0,
-    SWAY_MSG_GET_TREE    = 4,
+    SWAY_MSG_RUN_COMMAND    = 0,
+    SWAY_MSG_GET_WORKSPACES = 1,
+    SWAY_MSG_GET_TREE       = 4,
 };
 
 int sway_ipc_open_socket();
@@ -20,4 +31,86 @@ int sway_ipc_send(
 );
 struct sway_ipc_msg *sway_ipc_recv(int fd);
 
+/*
+ * Non-blocking IPC client.
+ *
+ * Requests are queued and written with `writev` when the socket is
+ * writable, several of them can be in flight. Sway answers in order, so
+ * replies are matched with the oldest request in flight.
+ *
+ * The reply given to handlers belongs to the client and is only valid during
+ * the call. It is NULL if the connection failed before the reply arrived.
+ * Requests sent without handler have their reply dropped.
+ */
+typedef void (*sway_ipc_reply_handler_t)(void *data, struct sway_ipc_msg *msg);
+
+struct sway_ipc_frame {
+    struct sway_ipc_msg_header header;
+    size_t                     payload_offset;
+    sway_ipc_reply_handler_t   handler;
+    void                      *data;
+};
+
+struct sway_ipc_request {
+    sway_ipc_reply_handler_t handler;
+    void                    *data;
+};
+
+struct sway_ipc_client {
+    int                fd;
+    bool               failed;
+    struct event_loop *event_loop;
+
+    // Frames waiting to be written, `sent` bytes of the first one are
+    // already written. Payloads are stored in `payloads`.
+    struct sway_ipc_frame *frames;
+    size_t                 frames_head;
+    size_t                 frames_len;
+    size_t                 frames_cap;
+    size_t                 sent;
+    char                  *payloads;
+    size_t                 payloads_len;
+    size_t                 payloads_cap;
+
+    struct sway_ipc_request *in_flight;
+    size_t                   in_flight_head;
+    size_t                   in_flight_len;
+    size_t                   in_flight_cap;
+
+    // Reply being received.
+    struct sway_ipc_msg_header header;
+    size_t                     header_received;
+    struct sway_ipc_msg       *msg;
+    size_t                     msg_cap;
+    size_t                     payload_received;
+};
+
+// Take ownership of a connected socket and make it non-blocking.
+int sway_ipc_client_init(struct sway_ipc_client *client, int fd);
+
+// Close the connection. Requests still pending are dropped without calling
+// their handlers.
+void sway_ipc_client_finish(struct sway_ipc_client *client);
+
+// Dispatch the socket from the event loop. The client updates the polled
+// events when it has data to write.
+int sway_ipc_client_attach(
+    struct sway_ipc_client *client, struct event_loop *event_loop
+);
+
+int sway_ipc_client_send(
+    struct sway_ipc_client *client, enum sway_ipc_msg_type type,
+    const char *payload, uint32_t len, sway_ipc_reply_handler_t handler,
+    void *data
+);
+
+// Write as many queued frames as possible without blocking.
+int sway_ipc_client_flush(struct sway_ipc_client *client);
+
+// Read and dispatch the replies available without blocking.
+int sway_ipc_client_dispatch(struct sway_ipc_client *client);
+
+// Block until all the queued requests got their reply.
+int sway_ipc_client_wait(struct sway_ipc_client *client);
+
 #endif
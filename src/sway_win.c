@@ -1,8 +1,9 @@
 #include "sway_win.h"
 
+#include "json_tape.h"
 #include "log.h"
 
-#include <jansson.h>
+#include <stdlib.h>
 #include <string.h>
 
 enum orientation {
@@ -11,17 +12,17 @@ enum orientation {
     ORIENTATION_VERTICAL   = 2,
 };
 
-static enum orientation _get_orientation(json_t *tree) {
-    json_t *field = json_object_get(tree, "orientation");
+static enum orientation _get_orientation(const struct json_node *tree) {
+    const struct json_node *field = json_node_get(tree, "orientation");
     if (field == NULL) {
         return ORIENTATION_NONE;
     }
 
-    if (!json_is_string(field)) {
+    if (!json_node_is(field, JSON_NODE_STRING)) {
         return ORIENTATION_NONE;
     }
 
-    const char *value = json_string_value(field);
+    const char *value = json_node_string(field);
     if (strcmp(value, "horizontal") == 0) {
         return ORIENTATION_HORIZONTAL;
     }
@@ -33,21 +34,22 @@ static enum orientation _get_orientation(json_t *tree) {
     return ORIENTATION_NONE;
 }
 
-#define JSON_OBJ_GET_INTEGER(node, var, key)               \
-    json_t *var##json = json_object_get(node, key);        \
-    if (var##json == NULL) {                               \
-        LOG_ERR("Object field '%s' not found.", key);      \
-        return -1;                                         \
-    }                                                      \
-    if (!json_is_integer(var##json)) {                     \
-        LOG_ERR("Object field '%s' not an integer.", key); \
-        return -1;                                         \
-    }                                                      \
-    int var = json_integer_value(var##json);
-
-static int _get_rect(json_t *node, struct rect *rect, char *field) {
-    json_t *rect_node = json_object_get(node, field);
-    if (!json_is_object(rect_node)) {
+#define JSON_OBJ_GET_INTEGER(node, var, key)                      \
+    const struct json_node *var##json = json_node_get(node, key); \
+    if (var##json == NULL) {                                      \
+        LOG_ERR("Object field '%s' not found.", key);             \
+        return -1;                                                \
+    }                                                             \
+    if (!json_node_is(var##json, JSON_NODE_INTEGER)) {            \
+        LOG_ERR("Object field '%s' not an integer.", key);        \
+        return -1;                                                \
+    }                                                             \
+    int var = var##json->integer;
+
+static int
+_get_rect(const struct json_node *node, struct rect *rect, char *field) {
+    const struct json_node *rect_node = json_node_get(node, field);
+    if (!json_node_is(rect_node, JSON_NODE_OBJECT)) {
         return -1;
     }
 
@@ -64,13 +66,15 @@ static int _get_rect(json_t *node, struct rect *rect, char *field) {
     return 0;
 }
 
-static int _get_array_node_rect(json_t *array_node, int i, struct rect *rect) {
-    json_t *node = json_array_get(array_node, i);
+static int _get_array_node_rect(
+    const struct json_node *array_node, int i, struct rect *rect
+) {
+    const struct json_node *node = json_node_at(array_node, i);
     if (node == NULL) {
         LOG_ERR("'nodes[%d]' not found.", i);
         return -1;
     }
-    if (!json_is_object(node)) {
+    if (!json_node_is(node, JSON_NODE_OBJECT)) {
         LOG_ERR("'nodes[%d]' is not an object.", i);
         return -1;
     }
@@ -78,21 +82,262 @@ static int _get_array_node_rect(json_t *array_node, int i, struct rect *rect) {
     return _get_rect(node, rect, "rect");
 }
 
-static int _find_focused_window_rec(struct focused_window *fw, json_t *tree) {
+// Title bars are part of the size set by resize commands.
+static int
+_get_sibling(const struct json_node *nodes, int i, struct sibling *sibling) {
+    const struct json_node *node = json_node_at(nodes, i);
+    if (!json_node_is(node, JSON_NODE_OBJECT)) {
+        LOG_ERR("'nodes[%d]' is not an object.", i);
+        return -1;
+    }
+
+    JSON_OBJ_GET_INTEGER(node, id, "id");
+    sibling->id = id;
+    if (_get_rect(node, &sibling->rect, "rect") != 0) {
+        return -1;
+    }
+
+    struct rect deco_rect;
+    if (_get_rect(node, &deco_rect, "deco_rect") == 0) {
+        sibling->rect.h += deco_rect.h;
+        sibling->rect.y -= deco_rect.h;
+    }
+
+    return 0;
+}
+
+// Called on each split container of the focus path, the innermost one is
+// kept.
+static int _get_siblings(
+    struct siblings *siblings, const struct json_node *nodes, int node_count,
+    int focused, bool horizontal
+) {
+    siblings->count = 0;
+    if (node_count > SWAY_WIN_MAX_SIBLINGS) {
+        LOG_DEBUG("Too many siblings for layout presets: %d.", node_count);
+        return 0;
+    }
+
+    for (int i = 0; i < node_count; i++) {
+        if (_get_sibling(nodes, i, &siblings->nodes[i]) != 0) {
+            return -1;
+        }
+    }
+
+    siblings->horizontal = horizontal;
+    siblings->focused    = focused;
+    siblings->count      = node_count;
+    return 0;
+}
+
+// Set the limits of the child `i` of a split container from its neighbours.
+static int _set_neighbour_limits(
+    struct focused_window *fw, const struct json_node *container,
+    const struct json_node *nodes, int node_count, int i
+) {
+    struct rect container_rect, neighbour_rect;
+    _get_rect(container, &container_rect, "rect");
+
+    switch (_get_orientation(container)) {
+    case ORIENTATION_HORIZONTAL:
+        if ((fw->resize_left = (i > 0))) {
+            if (_get_array_node_rect(nodes, i - 1, &neighbour_rect) != 0) {
+                LOG_ERR("Could not get left neighbour rect.");
+                return -1;
+            }
+            fw->resize_left_limit = neighbour_rect.x;
+        } else {
+            fw->resize_left_limit = container_rect.x;
+        }
+        if ((fw->resize_right = (i < node_count - 1))) {
+            if (_get_array_node_rect(nodes, i + 1, &neighbour_rect) != 0) {
+                LOG_ERR("Could not get right neighbour rect.");
+                return -1;
+            }
+            fw->resize_right_limit = neighbour_rect.x + neighbour_rect.w;
+        } else {
+            fw->resize_right_limit = container_rect.x + container_rect.w;
+        }
+        break;
+
+    case ORIENTATION_VERTICAL:
+        if ((fw->resize_top = (i > 0))) {
+            if (_get_array_node_rect(nodes, i - 1, &neighbour_rect) != 0) {
+                LOG_ERR("Could not get top neighbour rect.");
+                return -1;
+            }
+            fw->resize_top_limit = neighbour_rect.y;
+        } else {
+            fw->resize_top_limit = container_rect.y;
+        }
+        if ((fw->resize_bottom = (i < node_count - 1))) {
+            if (_get_array_node_rect(nodes, i + 1, &neighbour_rect) != 0) {
+                LOG_ERR("Could not get bottom neighbour rect.");
+                return -1;
+            }
+            fw->resize_bottom_limit = neighbour_rect.y + neighbour_rect.h;
+        } else {
+            fw->resize_bottom_limit = container_rect.y + container_rect.h;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+// Floating windows can be resized up to the output edges.
+static void _set_floating_limits(struct focused_window *fw) {
+    fw->floating            = true;
+    fw->resize_left         = true;
+    fw->resize_right        = true;
+    fw->resize_top          = true;
+    fw->resize_bottom       = true;
+    fw->resize_top_limit    = fw->output_rect.y;
+    fw->resize_bottom_limit = fw->output_rect.y + fw->output_rect.h;
+    fw->resize_left_limit   = fw->output_rect.x;
+    fw->resize_right_limit  = fw->output_rect.x + fw->output_rect.w;
+}
+
+static int _add_visible_window(
+    struct visible_windows *visible, struct focused_window *fw,
+    const struct json_node *node
+) {
+    if (visible->count == visible->cap) {
+        int                    cap     = visible->cap * 2 + 16;
+        struct focused_window *windows = realloc(
+            visible->windows, cap * sizeof(struct focused_window)
+        );
+        if (windows == NULL) {
+            LOG_ERR("Could not allocate visible windows.");
+            return -1;
+        }
+        visible->windows = windows;
+        visible->cap     = cap;
+    }
+
+    JSON_OBJ_GET_INTEGER(node, id, "id");
+
+    struct focused_window *window = &visible->windows[visible->count];
+    *window                       = *fw;
+    window->id                    = id;
+    window->output                = NULL;
+    window->siblings.count        = 0;
+    if (_get_rect(node, &window->rect, "rect") != 0) {
+        return -1;
+    }
+
+    struct rect deco_rect;
+    if (_get_rect(node, &deco_rect, "deco_rect") == 0) {
+        window->rect.h += deco_rect.h;
+        window->rect.y -= deco_rect.h;
+    }
+
+    visible->count++;
+    return 0;
+}
+
+// Walk the containers shown in `tree`, which are all the children of split
+// containers and only the focused child of tabbed and stacked ones. The
+// limits set by each container are passed down to its children.
+static int _collect_visible_rec(
+    struct visible_windows *visible, struct focused_window *fw,
+    const struct json_node *tree
+) {
+    const struct json_node *nodes      = json_node_get(tree, "nodes");
+    int                     node_count = json_node_array_size(nodes);
+    if (node_count == 0) {
+        const char *type = json_node_string(json_node_get(tree, "type"));
+        if (type != NULL && strcmp(type, "workspace") == 0) {
+            return 0;
+        }
+
+        return _add_visible_window(visible, fw, tree);
+    }
+
+    int         shown_id = -1;
+    const char *layout   = json_node_string(json_node_get(tree, "layout"));
+    if (layout != NULL &&
+        (strcmp(layout, "tabbed") == 0 || strcmp(layout, "stacked") == 0)) {
+        const struct json_node *first_focus =
+            json_node_at(json_node_get(tree, "focus"), 0);
+        if (json_node_is(first_focus, JSON_NODE_INTEGER)) {
+            shown_id = first_focus->integer;
+        }
+    }
+
+    for (int i = 0; i < node_count; i++) {
+        const struct json_node *node = json_node_at(nodes, i);
+        if (!json_node_is(node, JSON_NODE_OBJECT)) {
+            LOG_ERR("'nodes[%d]' is not an object.", i);
+            return -1;
+        }
+
+        if (shown_id >= 0) {
+            JSON_OBJ_GET_INTEGER(node, id, "id");
+            if (id != shown_id) {
+                continue;
+            }
+        }
+
+        struct focused_window child = *fw;
+        if (node_count > 1 &&
+            _set_neighbour_limits(&child, tree, nodes, node_count, i) != 0) {
+            return -1;
+        }
+        if (_collect_visible_rec(visible, &child, node) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
 
-    if (!json_is_object(tree)) {
+static int _collect_visible(
+    struct visible_windows *visible, struct focused_window *fw,
+    const struct json_node *workspace
+) {
+    visible->count = 0;
+    if (_collect_visible_rec(visible, fw, workspace) != 0) {
+        return -1;
+    }
+
+    const struct json_node *floating_nodes =
+        json_node_get(workspace, "floating_nodes");
+    int floating_nodes_count = json_node_array_size(floating_nodes);
+    for (int i = 0; i < floating_nodes_count; i++) {
+        struct focused_window child = *fw;
+        _set_floating_limits(&child);
+        if (_collect_visible_rec(
+                visible, &child, json_node_at(floating_nodes, i)
+            ) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int _find_focused_window_rec(
+    struct focused_window *fw, struct visible_windows *visible,
+    const struct json_node *tree
+) {
+
+    if (!json_node_is(tree, JSON_NODE_OBJECT)) {
         LOG_ERR("Node is not an object.");
         return -1;
     }
 
-    json_t     *type_node = json_object_get(tree, "type");
-    const char *type      = NULL;
-    if (type_node != NULL && json_is_string(type_node)) {
-        type = json_string_value(type_node);
+    const struct json_node *type_node = json_node_get(tree, "type");
+    const char             *type      = NULL;
+    if (type_node != NULL && json_node_is(type_node, JSON_NODE_STRING)) {
+        type = json_node_string(type_node);
         if (strcmp("output", type) == 0) {
-            json_t *name = json_object_get(tree, "name");
-            if (name != NULL && json_is_string(name)) {
-                fw->output = json_string_value(name);
+            const struct json_node *name = json_node_get(tree, "name");
+            if (name != NULL && json_node_is(name, JSON_NODE_STRING)) {
+                fw->output = json_node_string(name);
             }
 
             if (_get_rect(tree, &fw->output_rect, "rect") == 0) {
@@ -102,10 +347,15 @@ static int _find_focused_window_rec(struct focused_window *fw, json_t *tree) {
                 fw->resize_right_limit  = fw->output_rect.x + fw->output_rect.w;
             }
         }
+
+        if (visible != NULL && strcmp("workspace", type) == 0 &&
+            _collect_visible(visible, fw, tree) != 0) {
+            return -1;
+        }
     }
 
-    json_t *focused = json_object_get(tree, "focused");
-    if (focused != NULL && json_is_true(focused)) {
+    const struct json_node *focused = json_node_get(tree, "focused");
+    if (focused != NULL && json_node_is(focused, JSON_NODE_TRUE)) {
         JSON_OBJ_GET_INTEGER(tree, id, "id");
         fw->id = id;
         struct rect deco_rect;
@@ -122,44 +372,44 @@ static int _find_focused_window_rec(struct focused_window *fw, json_t *tree) {
         return 0;
     }
 
-    json_t *focus = json_object_get(tree, "focus");
+    const struct json_node *focus = json_node_get(tree, "focus");
     if (focus == NULL) {
         return -1;
     }
 
-    if (!json_is_array(focus)) {
+    if (!json_node_is(focus, JSON_NODE_ARRAY)) {
         return -1;
     }
 
-    json_t *first_focus = json_array_get(focus, 0);
+    const struct json_node *first_focus = json_node_at(focus, 0);
     if (first_focus == NULL) {
         return -1;
     }
-    if (!json_is_integer(first_focus)) {
+    if (!json_node_is(first_focus, JSON_NODE_INTEGER)) {
         return -1;
     }
-    int focused_id = json_integer_value(first_focus);
+    int focused_id = first_focus->integer;
 
-    fw->floating  = false;
-    json_t *nodes = json_object_get(tree, "nodes");
+    fw->floating                  = false;
+    const struct json_node *nodes = json_node_get(tree, "nodes");
     if (nodes == NULL) {
         LOG_ERR("Could not find 'nodes' field.");
         return -1;
     }
 
-    if (!json_is_array(nodes)) {
+    if (!json_node_is(nodes, JSON_NODE_ARRAY)) {
         LOG_ERR("'nodes' field is not an array.");
         return -1;
     }
 
-    int node_count = json_array_size(nodes);
+    int node_count = json_node_array_size(nodes);
     for (int i = 0; i < node_count; i++) {
-        json_t *node = json_array_get(nodes, i);
+        const struct json_node *node = json_node_at(nodes, i);
         if (node == NULL) {
             LOG_ERR("'nodes[%d]' not found.", i);
             return -1;
         }
-        if (!json_is_object(node)) {
+        if (!json_node_is(node, JSON_NODE_OBJECT)) {
             LOG_ERR("'nodes[%d]' is not an object.", i);
             return -1;
         }
@@ -167,116 +417,76 @@ static int _find_focused_window_rec(struct focused_window *fw, json_t *tree) {
         JSON_OBJ_GET_INTEGER(node, id, "id");
         if (id == focused_id) {
             if (node_count > 1 && (type == NULL || (strcmp(type, "root")))) {
-                struct rect container_rect, neighbour_rect;
-                _get_rect(tree, &container_rect, "rect");
-
-                switch (_get_orientation(tree)) {
-                case ORIENTATION_HORIZONTAL:
-                    if ((fw->resize_left = (i > 0))) {
-                        if (_get_array_node_rect(
-                                nodes, i - 1, &neighbour_rect
-                            ) != 0) {
-                            LOG_ERR("Could not get left neighbour rect.");
-                            return -1;
-                        }
-                        fw->resize_left_limit = neighbour_rect.x;
-                    } else {
-                        fw->resize_left_limit = container_rect.x;
-                    }
-                    if ((fw->resize_right = (i < node_count - 1))) {
-                        if (_get_array_node_rect(
-                                nodes, i + 1, &neighbour_rect
-                            ) != 0) {
-                            LOG_ERR("Could not get right neighbour rect.");
-                            return -1;
-                        }
-                        fw->resize_right_limit =
-                            neighbour_rect.x + neighbour_rect.w;
-                    } else {
-                        fw->resize_right_limit =
-                            container_rect.x + container_rect.w;
-                    }
-                    break;
-
-                case ORIENTATION_VERTICAL:
-                    if ((fw->resize_top = (i > 0))) {
-                        if (_get_array_node_rect(
-                                nodes, i - 1, &neighbour_rect
-                            ) != 0) {
-                            LOG_ERR("Could not get top neighbour rect.");
-                            return -1;
-                        }
-                        fw->resize_top_limit = neighbour_rect.y;
-                    } else {
-                        fw->resize_top_limit = container_rect.y;
-                    }
-                    if ((fw->resize_bottom = (i < node_count - 1))) {
-                        if (_get_array_node_rect(
-                                nodes, i + 1, &neighbour_rect
-                            ) != 0) {
-                            LOG_ERR("Could not get bottom neighbour rect.");
-                            return -1;
-                        }
-                        fw->resize_bottom_limit =
-                            neighbour_rect.y + neighbour_rect.h;
-                    } else {
-                        fw->resize_bottom_limit =
-                            container_rect.y + container_rect.h;
-                    }
-                    break;
-
-                default:
-                    break;
+                enum orientation orientation = _get_orientation(tree);
+                if (orientation != ORIENTATION_NONE &&
+                    _get_siblings(
+                        &fw->siblings, nodes, node_count, i,
+                        orientation == ORIENTATION_HORIZONTAL
+                    ) != 0) {
+                    return -1;
+                }
+
+                if (_set_neighbour_limits(fw, tree, nodes, node_count, i) !=
+                    0) {
+                    return -1;
                 }
             }
 
-            return _find_focused_window_rec(fw, node);
+            return _find_focused_window_rec(fw, visible, node);
         }
     }
 
-    fw->floating           = true;
-    json_t *floating_nodes = json_object_get(tree, "floating_nodes");
+    fw->floating       = true;
+    fw->siblings.count = 0;
+    const struct json_node *floating_nodes =
+        json_node_get(tree, "floating_nodes");
     if (floating_nodes == NULL) {
         LOG_ERR("Could not find 'floating_nodes' field.");
         return -1;
     }
 
-    if (!json_is_array(nodes)) {
+    if (!json_node_is(nodes, JSON_NODE_ARRAY)) {
         LOG_ERR("'floating_nodes' field is not an array.");
         return -1;
     }
 
-    int floating_nodes_count = json_array_size(floating_nodes);
+    int floating_nodes_count = json_node_array_size(floating_nodes);
     for (int i = 0; i < floating_nodes_count; i++) {
-        json_t *node = json_array_get(floating_nodes, i);
+        const struct json_node *node = json_node_at(floating_nodes, i);
         if (node == NULL) {
             LOG_ERR("'floating_nodes[%d]' not found.", i);
             return -1;
         }
-        if (!json_is_object(node)) {
+        if (!json_node_is(node, JSON_NODE_OBJECT)) {
             LOG_ERR("'node[%d]' is not an object.", i);
             return -1;
         }
 
         JSON_OBJ_GET_INTEGER(node, id, "id");
         if (id == focused_id) {
-            fw->resize_left         = true;
-            fw->resize_right        = true;
-            fw->resize_top          = true;
-            fw->resize_bottom       = true;
-            fw->resize_top_limit    = fw->output_rect.y;
-            fw->resize_bottom_limit = fw->output_rect.y + fw->output_rect.h;
-            fw->resize_left_limit   = fw->output_rect.x;
-            fw->resize_right_limit  = fw->output_rect.x + fw->output_rect.w;
-
-            return _find_focused_window_rec(fw, node);
+            _set_floating_limits(fw);
+            return _find_focused_window_rec(fw, visible, node);
         }
     }
 
     return -1;
 }
 
-int find_focused_window(struct focused_window *fw, json_t *tree) {
+static void _to_output_coords(struct focused_window *fw) {
+    fw->rect.x -= fw->output_rect.x;
+    fw->rect.y -= fw->output_rect.y;
+
+    fw->resize_left_limit  -= fw->output_rect.x;
+    fw->resize_right_limit -= fw->output_rect.x;
+
+    fw->resize_bottom_limit -= fw->output_rect.y;
+    fw->resize_top_limit    -= fw->output_rect.y;
+}
+
+int find_visible_windows(
+    struct focused_window *fw, struct visible_windows *visible,
+    const struct json_node *tree
+) {
     fw->id                  = -1;
     fw->resize_bottom       = false;
     fw->resize_top          = false;
@@ -290,50 +500,89 @@ int find_focused_window(struct focused_window *fw, json_t *tree) {
     fw->rect.y              = 0;
     fw->rect.w              = 0;
     fw->rect.h              = 0;
+    fw->siblings.count      = 0;
+
+    if (visible != NULL) {
+        visible->count = 0;
+    }
 
-    int err = _find_focused_window_rec(fw, tree);
+    int err = _find_focused_window_rec(fw, visible, tree);
     if (err) {
         return err;
     }
 
     if (fw->output != NULL) {
-        // We kept a reference to the json_t value.
+        // The name points into the tape.
         fw->output = strdup(fw->output);
     }
 
-    fw->rect.x -= fw->output_rect.x;
-    fw->rect.y -= fw->output_rect.y;
+    _to_output_coords(fw);
+    for (int i = 0; visible != NULL && i < visible->count; i++) {
+        _to_output_coords(&visible->windows[i]);
+    }
 
-    fw->resize_left_limit  -= fw->output_rect.x;
-    fw->resize_right_limit -= fw->output_rect.x;
+    return 0;
+}
 
-    fw->resize_bottom_limit -= fw->output_rect.y;
-    fw->resize_top_limit    -= fw->output_rect.y;
+int find_focused_window(
+    struct focused_window *fw, const struct json_node *tree
+) {
+    return find_visible_windows(fw, NULL, tree);
+}
 
-    return 0;
+const char *find_focused_output(const struct json_node *workspaces) {
+    int count = json_node_array_size(workspaces);
+    for (int i = 0; i < count; i++) {
+        const struct json_node *workspace = json_node_at(workspaces, i);
+        const struct json_node *focused   = json_node_get(workspace, "focused");
+        if (focused == NULL || !json_node_is(focused, JSON_NODE_TRUE)) {
+            continue;
+        }
+
+        const struct json_node *output = json_node_get(workspace, "output");
+        if (output == NULL || !json_node_is(output, JSON_NODE_STRING)) {
+            LOG_ERR("Focused workspace has no output.");
+            return NULL;
+        }
+        return json_node_string(output);
+    }
+
+    return NULL;
+}
+
+void visible_windows_finish(struct visible_windows *visible) {
+    free(visible->windows);
+    visible->windows = NULL;
+    visible->count   = 0;
+    visible->cap     = 0;
 }
 
 void log_focused_window(struct focused_window *fw) {
-    LOG_INFO("focused_window");
-    LOG_INFO(" .id = %d", fw->id);
-    LOG_INFO(" .output = %s", fw->output);
-    LOG_INFO(
+    LOG_DEBUG("focused_window");
+    LOG_DEBUG(" .id = %d", fw->id);
+    LOG_DEBUG(" .output = %s", fw->output);
+    LOG_DEBUG(
         " .resize_top_limit = %d (%s)", fw->resize_top_limit,
         fw->resize_top ? "resizable" : "fixed"
     );
-    LOG_INFO(
+    LOG_DEBUG(
         " .resize_bottom_limit = %d (%s)", fw->resize_bottom_limit,
         fw->resize_bottom ? "resizable" : "fixed"
     );
-    LOG_INFO(
+    LOG_DEBUG(
         " .resize_right_limit = %d (%s)", fw->resize_right_limit,
         fw->resize_right ? "resizable" : "fixed"
     );
-    LOG_INFO(
+    LOG_DEBUG(
         " .resize_left_limit = %d (%s)", fw->resize_left_limit,
         fw->resize_left ? "resizable" : "fixed"
     );
-    LOG_INFO(
+    LOG_DEBUG(
         " .rect = %dx%d+%d+%d", fw->rect.w, fw->rect.h, fw->rect.x, fw->rect.y
     );
+    LOG_DEBUG(
+        " .siblings = %d %s, focused %d", fw->siblings.count,
+        fw->siblings.horizontal ? "horizontal" : "vertical",
+        fw->siblings.focused
+    );
 }
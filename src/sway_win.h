@@ -1,29 +1,70 @@
 #ifndef __SWAY_WIN_H_INCLUDED__
 #define __SWAY_WIN_H_INCLUDED__
 
+#include "json_tape.h"
 #include "utils.h"
 
-#include <jansson.h>
 #include <stdbool.h>
 #include <stdint.h>
 
-struct focused_window {
+#define SWAY_WIN_MAX_SIBLINGS 16
+
+struct sibling {
     int         id;
-    const char *output;
     struct rect rect;
-    struct rect output_rect;
-    int32_t     resize_top_limit;
-    int32_t     resize_bottom_limit;
-    int32_t     resize_left_limit;
-    int32_t     resize_right_limit;
-    bool        resize_top;
-    bool        resize_bottom;
-    bool        resize_left;
-    bool        resize_right;
-    bool        floating;
 };
 
-int  find_focused_window(struct focused_window *fw, json_t *tree);
+// Children of the innermost split container holding the focused window, in
+// layout order. `count` is 0 if there is none or it has too many children.
+struct siblings {
+    bool           horizontal;
+    int            count;
+    int            focused;
+    struct sibling nodes[SWAY_WIN_MAX_SIBLINGS];
+};
+
+struct focused_window {
+    int             id;
+    const char     *output;
+    struct rect     rect;
+    struct rect     output_rect;
+    int32_t         resize_top_limit;
+    int32_t         resize_bottom_limit;
+    int32_t         resize_left_limit;
+    int32_t         resize_right_limit;
+    bool            resize_top;
+    bool            resize_bottom;
+    bool            resize_left;
+    bool            resize_right;
+    bool            floating;
+    struct siblings siblings;
+};
+
+// Windows shown on the workspace of the focused window, tiled ones in
+// layout order then floating ones. Each has the limits it would have if it
+// was focused, and no siblings.
+struct visible_windows {
+    struct focused_window *windows;
+    int                    count;
+    int                    cap;
+};
+
+int find_focused_window(
+    struct focused_window *fw, const struct json_node *tree
+);
+
+// Same as `find_focused_window`, also collecting the visible windows in the
+// same walk of the tree. Their `output` is NULL.
+int find_visible_windows(
+    struct focused_window *fw, struct visible_windows *visible,
+    const struct json_node *tree
+);
+void visible_windows_finish(struct visible_windows *visible);
+
+// Name of the output of the focused workspace in a GET_WORKSPACES reply,
+// pointing into the tape. NULL if no workspace is focused.
+const char *find_focused_output(const struct json_node *workspaces);
+
 void log_focused_window(struct focused_window *fw);
 
 #endif
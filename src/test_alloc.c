@@ -0,0 +1,314 @@
+#include "alloc_hook.h"
+#include "bench.h"
+#include "hint.h"
+#include "log.h"
+#include "render.h"
+#include "render_pool.h"
+#include "render_thread.h"
+#include "resize_params.h"
+#include "surface_buffer.h"
+
+#include <cairo/cairo.h>
+#include <dlfcn.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OUTPUT_WIDTH   1280
+#define OUTPUT_HEIGHT  720
+#define SCALE          1.5
+#define RENDER_THREADS 4
+#define WARMUP         3
+#define ITERATIONS     50
+
+// More windows than letters, for two-letter labels.
+#define HINT_COLUMNS 6
+#define HINT_ROWS    5
+
+#ifdef __GLIBC__
+
+/*
+ * Count the heap allocations seen by alloc_hook.c while `counting` is set, by
+ * who made the call: the program, directly or through libc, or a library it
+ * uses.
+ *
+ * Cairo keeps paths, polygons and boxes in buffers of a fixed size and
+ * allocates past that, so drawing a long dashed guide allocates in cairo on
+ * every frame. Those are reported but not checked.
+ */
+static atomic_bool          counting;
+static atomic_uint_fast64_t program_allocs;
+static atomic_uint_fast64_t library_allocs;
+static void                *program_base;
+static void                *libc_base;
+
+static void _count(size_t size, void *caller) {
+    if (!atomic_load_explicit(&counting, memory_order_relaxed)) {
+        return;
+    }
+
+    Dl_info info;
+    if (dladdr(caller, &info) != 0 && info.dli_fbase != program_base &&
+        info.dli_fbase != libc_base) {
+        atomic_fetch_add(&library_allocs, 1);
+        return;
+    }
+    atomic_fetch_add(&program_allocs, 1);
+}
+
+static int _init_counting() {
+    Dl_info info;
+    if (dladdr((void *)_count, &info) == 0) {
+        return -1;
+    }
+    program_base = info.dli_fbase;
+
+    void *libc_malloc = dlsym(RTLD_NEXT, "malloc");
+    if (libc_malloc == NULL || dladdr(libc_malloc, &info) == 0) {
+        return -1;
+    }
+    libc_base = info.dli_fbase;
+
+    alloc_hook_set(_count);
+    return 0;
+}
+
+struct fixture {
+    struct state          state;      // guides of a half-screen window
+    struct state          hint_state; // picking among the hint windows
+    struct focused_window window;     // of `state`, before any resize
+    cairo_surface_t      *surface;
+    cairo_t              *cairo;
+    struct surface_buffer buffer;
+    struct render_pool    pool;
+    struct render_thread  thread;
+};
+
+static void _hint_state_init(struct state *state) {
+    bench_state_init(state, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+    hint_init(&state->hint, true);
+
+    struct visible_windows *visible = &state->hint.visible;
+    visible->cap     = HINT_COLUMNS * HINT_ROWS;
+    visible->windows = calloc(visible->cap, sizeof(struct focused_window));
+    for (int i = 0; i < visible->cap; i++) {
+        struct focused_window window = state->focused_window;
+        window.rect.w                = OUTPUT_WIDTH / HINT_COLUMNS;
+        window.rect.h                = OUTPUT_HEIGHT / HINT_ROWS;
+        window.rect.x                = i % HINT_COLUMNS * window.rect.w;
+        window.rect.y                = i / HINT_COLUMNS * window.rect.h;
+
+        visible->windows[visible->count++] = window;
+    }
+
+    hint_start(state);
+}
+
+static void _fixture_init(struct fixture *fixture) {
+    memset(fixture, 0, sizeof(struct fixture));
+    bench_state_init(&fixture->state, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+    fixture->window = fixture->state.focused_window;
+    _hint_state_init(&fixture->hint_state);
+
+    fixture->surface = cairo_image_surface_create(
+        CAIRO_FORMAT_ARGB32, OUTPUT_WIDTH * SCALE, OUTPUT_HEIGHT * SCALE
+    );
+    fixture->cairo = cairo_create(fixture->surface);
+    cairo_scale(fixture->cairo, SCALE, SCALE);
+
+    // Same as the buffers of the surface buffer pool.
+    struct surface_buffer *buffer = &fixture->buffer;
+    buffer->width                 = OUTPUT_WIDTH * SCALE;
+    buffer->height                = OUTPUT_HEIGHT * SCALE;
+    buffer->cairo_surface         = cairo_image_surface_create(
+        CAIRO_FORMAT_ARGB32, buffer->width, buffer->height
+    );
+    buffer->cairo = cairo_create(buffer->cairo_surface);
+    buffer->data  = cairo_image_surface_get_data(buffer->cairo_surface);
+    buffer->state = SURFACE_BUFFER_READY;
+    render_pool_init(&fixture->pool, RENDER_THREADS);
+    render_thread_init(&fixture->thread, RENDER_THREADS);
+}
+
+static void _fixture_finish(struct fixture *fixture) {
+    render_thread_finish(&fixture->thread);
+    render_pool_destroy(&fixture->pool);
+    surface_buffer_split_tiles(&fixture->buffer, 0);
+    cairo_destroy(fixture->buffer.cairo);
+    cairo_surface_destroy(fixture->buffer.cairo_surface);
+    cairo_destroy(fixture->cairo);
+    cairo_surface_destroy(fixture->surface);
+
+    hint_finish(&fixture->hint_state.hint);
+    bench_state_finish(&fixture->hint_state);
+    bench_state_finish(&fixture->state);
+}
+
+// What a guide key does in live mode: find its parameter, apply it to the
+// window and recompute the guides.
+static void _run_keys(struct fixture *fixture) {
+    struct state             *state  = &fixture->state;
+    struct resize_parameters *params = state->resize_params;
+
+    enum resize_direction directions[] = {RESIZE_VERTICAL, RESIZE_HORIZONTAL};
+    for (size_t d = 0; d < ARRAY_LEN(directions); d++) {
+        for (size_t i = 0; i < params->counts[directions[d]]; i++) {
+            char     text[5];
+            uint32_t rune;
+            rune_to_str(params->params[directions[d]][i].symbol, text);
+            str_to_rune(text, &rune);
+
+            enum resize_direction    direction;
+            struct resize_parameter *param =
+                find_resize_param_by_symbol(params, rune, &direction);
+            if (param == NULL || !param->applicable) {
+                continue;
+            }
+
+            state->focused_window = fixture->window;
+            resize_parameter_apply(param, direction, &state->focused_window);
+            resize_parameters_compute_guides(params, &state->focused_window);
+        }
+    }
+
+    state->focused_window = fixture->window;
+    resize_parameters_compute_guides(params, &state->focused_window);
+}
+
+// Type a two-letter label, then pick a window with the pointer.
+static void _run_hints(struct fixture *fixture) {
+    struct state     *state = &fixture->hint_state;
+    struct hint_mode *hint  = &state->hint;
+
+    hint->picking = true;
+    hint->prefix  = -1;
+    hint_handle_rune(state, HINT_ALPHABET[0]);
+    for (int i = 0; i < hint->visible.count; i++) {
+        char label[3];
+        if (hint_matches(hint, i)) {
+            hint_label(hint, i, label);
+        }
+    }
+    hint_handle_rune(state, HINT_ALPHABET[1]);
+
+    hint->picking = true;
+    hint->prefix  = -1;
+    hint_pick_at(state, OUTPUT_WIDTH / 2, OUTPUT_HEIGHT / 2);
+    hint->picking = true;
+}
+
+static void _run_pointer(struct fixture *fixture) {
+    struct state *state = &fixture->state;
+    render_extent(state);
+
+    for (int y = 0; y < OUTPUT_HEIGHT; y += 8) {
+        for (int x = 0; x < OUTPUT_WIDTH; x += 8) {
+            enum resize_direction direction;
+            render_find_guide_at(state, x, y, &direction);
+        }
+    }
+}
+
+static void _run_render(struct fixture *fixture) {
+    render(&fixture->state, fixture->cairo);
+    render(&fixture->hint_state, fixture->cairo);
+}
+
+// What `send_frame` renders, on all the threads of the pool.
+static void _run_render_pool(struct fixture *fixture) {
+    struct rect clip = render_extent(&fixture->state);
+    render_pool_render(
+        &fixture->pool, &fixture->state, &fixture->buffer, SCALE, NULL
+    );
+    render_pool_render(
+        &fixture->pool, &fixture->state, &fixture->buffer, SCALE, &clip
+    );
+}
+
+// What `send_frame` and `commit_frame` do with the render thread: copy the
+// state, render it and take the buffer back.
+static void _run_render_thread(struct fixture *fixture) {
+    struct state *states[] = {&fixture->state, &fixture->hint_state};
+    for (size_t i = 0; i < ARRAY_LEN(states); i++) {
+        render_thread_submit(
+            &fixture->thread, states[i], &fixture->buffer, SCALE, NULL,
+            (struct rect){0}
+        );
+
+        struct pollfd pollfd = {
+            .fd     = fixture->thread.event_fd,
+            .events = POLLIN,
+        };
+        struct rect damage;
+        poll(&pollfd, 1, -1);
+        render_thread_take(&fixture->thread, &damage);
+    }
+}
+
+static int _check_path(
+    struct fixture *fixture, const char *name, void (*run)(struct fixture *)
+) {
+    for (int i = 0; i < WARMUP; i++) {
+        run(fixture);
+    }
+
+    atomic_store(&program_allocs, 0);
+    atomic_store(&library_allocs, 0);
+    atomic_store(&counting, true);
+    for (int i = 0; i < ITERATIONS; i++) {
+        run(fixture);
+    }
+    atomic_store(&counting, false);
+
+    uint64_t program   = atomic_load(&program_allocs);
+    uint64_t libraries = atomic_load(&library_allocs);
+    printf(
+        "%-14s %8.2f allocations/run, %8.2f in libraries\n", name,
+        (double)program / ITERATIONS, (double)libraries / ITERATIONS
+    );
+    if (program != 0) {
+        LOG_ERR(
+            "%s made %llu allocations after warm-up.", name,
+            (unsigned long long)program
+        );
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Run the paths taken on input and for every frame many times over a
+ * prepared state, and fail if any of them still allocates once warmed up.
+ */
+int main() {
+    if (_init_counting() != 0) {
+        LOG_ERR("Could not locate the program and libc.");
+        return 1;
+    }
+
+    struct fixture fixture;
+    _fixture_init(&fixture);
+
+    int failures  = 0;
+    failures     += _check_path(&fixture, "keys", _run_keys);
+    failures     += _check_path(&fixture, "hints", _run_hints);
+    failures     += _check_path(&fixture, "pointer", _run_pointer);
+    failures     += _check_path(&fixture, "render", _run_render);
+    failures     += _check_path(&fixture, "render_pool", _run_render_pool);
+    failures     += _check_path(&fixture, "render_thread", _run_render_thread);
+
+    _fixture_finish(&fixture);
+
+    return failures == 0 ? 0 : 1;
+}
+
+#else
+
+int main() {
+    LOG_WARN("Allocations are only counted on glibc.");
+    return 77; // skipped
+}
+
+#endif
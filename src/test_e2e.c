@@ -0,0 +1,188 @@
+#include "e2e.h"
+#include "log.h"
+
+#include <inttypes.h>
+#include <linux/input-event-codes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OUTPUT_WIDTH  1280
+#define OUTPUT_HEIGHT 720
+#define TIMEOUT_MS    5000
+
+static bool _first_attach(struct e2e *e2e) {
+    return e2e->compositor.stats.attaches > 0;
+}
+
+static bool _second_attach(struct e2e *e2e) {
+    return e2e->compositor.stats.attaches > 1;
+}
+
+static bool _scaled_attach(struct e2e *e2e) {
+    return e2e->compositor.stats.buffer_width == OUTPUT_WIDTH * 3 / 2;
+}
+
+static bool _command_received(struct e2e *e2e) {
+    return e2e->sway.num_commands > 0;
+}
+
+static bool _unmapped(struct e2e *e2e) {
+    return e2e->compositor.stats.unmaps > 0;
+}
+
+// Type `keys` before the tree is received, so that they are queued and
+// replayed once it is. Nothing typed after the key closing the overlay may
+// send a command or unmap it again.
+static int _check_queued_keys(
+    const char *exe, const uint32_t *keys, int num_keys,
+    const char *expected_command
+) {
+    char *args[] = {"-g", "a:h:25% b:h:75%", NULL};
+
+    struct e2e e2e;
+    if (e2e_start(&e2e, exe, args, OUTPUT_WIDTH, OUTPUT_HEIGHT) != 0) {
+        return 1;
+    }
+
+    e2e.sway.hold_tree = true;
+    if (e2e_run_until(&e2e, _first_attach, TIMEOUT_MS) != 0) {
+        LOG_ERR("No first frame before the tree.");
+        e2e_finish(&e2e, 0);
+        return 1;
+    }
+    for (int i = 0; i < num_keys; i++) {
+        mock_compositor_press_key(&e2e.compositor, keys[i]);
+    }
+    mock_sway_release_tree(&e2e.sway);
+
+    int      failures     = 0;
+    int      status       = e2e_wait_exit(&e2e, TIMEOUT_MS);
+    uint32_t num_expected = expected_command == NULL ? 0 : 1;
+    if (status != 0) {
+        LOG_ERR("sway-resize exited with status %d.", status);
+        failures++;
+    }
+    if (e2e.sway.num_commands != num_expected ||
+        (expected_command != NULL &&
+         strcmp(e2e.sway.last_command, expected_command) != 0)) {
+        LOG_ERR(
+            "Queued keys sent %u commands, the last one '%s'.",
+            e2e.sway.num_commands,
+            e2e.sway.last_command == NULL ? "" : e2e.sway.last_command
+        );
+        failures++;
+    }
+    if (e2e.compositor.stats.unmaps != num_expected) {
+        LOG_ERR(
+            "Queued keys unmapped the overlay %u times.",
+            e2e.compositor.stats.unmaps
+        );
+        failures++;
+    }
+
+    e2e_finish(&e2e, 0);
+    return failures;
+}
+
+/*
+ * Usage: test_e2e SWAY_RESIZE
+ *
+ * Run sway-resize against the mock compositor and Sway: check that the first
+ * frame is shown before the tree is received and the window drawn in the
+ * next one, that a scale change is rendered at the new size and that
+ * pressing a guide key sends its command and unmaps the overlay before
+ * tearing it down. Then check that keys typed during startup stop at the
+ * one closing the overlay.
+ */
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        LOG_ERR("Usage: %s SWAY_RESIZE", argv[0]);
+        return 1;
+    }
+
+    char *args[] = {"-g", "a:h:25% b:h:75%", NULL};
+
+    struct e2e e2e;
+    if (e2e_start(&e2e, argv[1], args, OUTPUT_WIDTH, OUTPUT_HEIGHT) != 0) {
+        return 1;
+    }
+
+    int                           failures = 0;
+    struct mock_compositor_stats *stats    = &e2e.compositor.stats;
+
+    // The first frame only needs the workspaces.
+    e2e.sway.hold_tree = true;
+    if (e2e_run_until(&e2e, _first_attach, TIMEOUT_MS) != 0) {
+        LOG_ERR("No first frame before the tree.");
+        e2e_finish(&e2e, 0);
+        return 1;
+    }
+    if (stats->buffer_width != OUTPUT_WIDTH ||
+        stats->buffer_height != OUTPUT_HEIGHT) {
+        LOG_ERR(
+            "First buffer is %dx%d.", stats->buffer_width,
+            stats->buffer_height
+        );
+        failures++;
+    }
+    if (stats->damage_area == 0) {
+        LOG_ERR("First frame has no damage.");
+        failures++;
+    }
+    if (stats->buffer_bytes < (uint64_t)OUTPUT_WIDTH * OUTPUT_HEIGHT * 4) {
+        LOG_ERR(
+            "First buffer is only %" PRIu64 " bytes.", stats->buffer_bytes
+        );
+        failures++;
+    }
+
+    mock_sway_release_tree(&e2e.sway);
+    if (e2e_run_until(&e2e, _second_attach, TIMEOUT_MS) != 0) {
+        LOG_ERR("Window not drawn after the tree.");
+        e2e_finish(&e2e, 0);
+        return 1;
+    }
+
+    mock_compositor_set_scale(&e2e.compositor, 180);
+    if (e2e_run_until(&e2e, _scaled_attach, TIMEOUT_MS) != 0) {
+        LOG_ERR("No buffer attached at scale 1.5.");
+        e2e_finish(&e2e, 0);
+        return 1;
+    }
+
+    if (mock_compositor_press_key(&e2e.compositor, KEY_A) != 0 ||
+        e2e_run_until(&e2e, _command_received, TIMEOUT_MS) != 0) {
+        LOG_ERR("No command received.");
+        e2e_finish(&e2e, 0);
+        return 1;
+    }
+
+    const char *expected = "resize set width 320px";
+    if (strcmp(e2e.sway.last_command, expected) != 0) {
+        LOG_ERR(
+            "Received '%s' instead of '%s'.", e2e.sway.last_command, expected
+        );
+        failures++;
+    }
+
+    // The surface is destroyed without a null buffer during the teardown.
+    if (e2e_run_until(&e2e, _unmapped, TIMEOUT_MS) != 0) {
+        LOG_ERR("Overlay not unmapped after the command.");
+        failures++;
+    }
+
+    int status = e2e_finish(&e2e, TIMEOUT_MS);
+    if (status != 0) {
+        LOG_ERR("sway-resize exited with status %d.", status);
+        failures++;
+    }
+
+    failures += _check_queued_keys(
+        argv[1], (uint32_t[]){KEY_ESC, KEY_A}, 2, NULL
+    );
+    failures += _check_queued_keys(
+        argv[1], (uint32_t[]){KEY_A, KEY_B}, 2, "resize set width 320px"
+    );
+
+    return failures == 0 ? 0 : 1;
+}
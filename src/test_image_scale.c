@@ -0,0 +1,158 @@
+#include "image_scale.h"
+#include "log.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+static struct image _image_new(int32_t width, int32_t height) {
+    return (struct image){
+        .data   = calloc((size_t)width * height, 4),
+        .width  = width,
+        .height = height,
+        .stride = width * 4,
+    };
+}
+
+static uint32_t _pixel(const struct image *image, int32_t x, int32_t y) {
+    uint32_t pixel;
+    memcpy(&pixel, image->data + (ptrdiff_t)y * image->stride + 4 * x, 4);
+    return pixel;
+}
+
+static void _fill_random(struct image *image, unsigned int seed) {
+    srand(seed);
+    for (int32_t y = 0; y < image->height; y++) {
+        for (int32_t x = 0; x < image->width * 4; x++) {
+            image->data[y * image->stride + x] = rand() & 0xff;
+        }
+    }
+}
+
+static int
+_check_constant(int32_t src_w, int32_t src_h, int32_t w, int32_t h) {
+    struct image src = _image_new(src_w, src_h);
+    struct image dst = _image_new(w, h);
+    for (int32_t i = 0; i < src_w * src_h; i++) {
+        memcpy(src.data + 4 * i, &(uint32_t){0x80ff4010}, 4);
+    }
+
+    int failures = 0;
+    image_scale(&src, &dst);
+    for (int32_t y = 0; y < h; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            if (_pixel(&dst, x, y) != 0x80ff4010) {
+                failures++;
+            }
+        }
+    }
+
+    if (failures != 0) {
+        LOG_ERR(
+            "%dx%d -> %dx%d: constant image changed at %d pixels.", src_w,
+            src_h, w, h, failures
+        );
+    }
+
+    free(src.data);
+    free(dst.data);
+    return failures != 0;
+}
+
+// The SIMD and scalar paths must give the exact same pixels.
+static int _check_paths(int32_t src_w, int32_t src_h, int32_t w, int32_t h) {
+    struct image src    = _image_new(src_w, src_h);
+    struct image simd   = _image_new(w, h);
+    struct image scalar = _image_new(w, h);
+    _fill_random(&src, src_w * 31 + src_h);
+
+    image_scale(&src, &simd);
+    image_scale_scalar(&src, &scalar);
+
+    int failed = memcmp(simd.data, scalar.data, (size_t)w * h * 4) != 0;
+    if (failed) {
+        LOG_ERR(
+            "%dx%d -> %dx%d: SIMD and scalar results differ.", src_w, src_h, w,
+            h
+        );
+    }
+
+    free(src.data);
+    free(simd.data);
+    free(scalar.data);
+    return failed;
+}
+
+static int _check_flipped_copy() {
+    struct image src = _image_new(7, 5);
+    struct image dst = _image_new(7, 5);
+    _fill_random(&src, 1);
+
+    // At the same size, every sample falls on a source pixel.
+    struct image flipped = image_flipped(&src);
+    image_scale(&flipped, &dst);
+
+    int failures = 0;
+    for (int32_t y = 0; y < 5; y++) {
+        for (int32_t x = 0; x < 7; x++) {
+            if (_pixel(&dst, x, y) != _pixel(&src, x, 4 - y)) {
+                failures++;
+            }
+        }
+    }
+
+    if (failures != 0) {
+        LOG_ERR("Flipped copy differs at %d pixels.", failures);
+    }
+
+    free(src.data);
+    free(dst.data);
+    return failures != 0;
+}
+
+static int _check_box_average() {
+    // Two 2x2 blocks, halved into two pixels.
+    uint8_t rows[2][16] = {
+        {0, 10, 20, 255, 4, 10, 20, 255, 100, 0, 0, 0, 200, 1, 0, 0},
+        {0, 10, 20, 255, 8, 10, 21, 255, 100, 0, 0, 0, 200, 2, 0, 0},
+    };
+    struct image src = {
+        .data   = &rows[0][0],
+        .width  = 4,
+        .height = 2,
+        .stride = 16,
+    };
+    struct image dst = _image_new(2, 1);
+
+    image_scale(&src, &dst);
+
+    uint8_t expected[8] = {3, 10, 20, 255, 150, 1, 0, 0};
+    int     failed      = memcmp(dst.data, expected, sizeof(expected)) != 0;
+    if (failed) {
+        LOG_ERR("Box filter gave the wrong averages.");
+    }
+
+    free(dst.data);
+    return failed;
+}
+
+int main() {
+    int failures = 0;
+
+    failures += _check_constant(64, 48, 64, 48);
+    failures += _check_constant(64, 48, 13, 9);
+    failures += _check_constant(13, 9, 64, 48);
+    failures += _check_constant(1000, 700, 37, 41);
+
+    failures += _check_paths(64, 48, 64, 48);
+    failures += _check_paths(64, 48, 33, 17);
+    failures += _check_paths(17, 33, 120, 90);
+    failures += _check_paths(1001, 703, 37, 41);
+    failures += _check_paths(1920, 1080, 191, 107);
+    failures += _check_paths(3, 3, 1, 1);
+
+    failures += _check_flipped_copy();
+    failures += _check_box_average();
+
+    return failures == 0 ? 0 : 1;
+}
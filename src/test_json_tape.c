@@ -0,0 +1,230 @@
+#include "json_tape.h"
+#include "log.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *invalid[] = {
+    "",
+    "   ",
+    "{",
+    "}",
+    "[1,]",
+    "[,1]",
+    "{\"a\"}",
+    "{\"a\":}",
+    "{\"a\":1,}",
+    "{1:2}",
+    "[1 2]",
+    "[\"a\" \"b\"]",
+    "[tru]",
+    "[nul]",
+    "[1.2.3e]",
+    "[\"\\x\"]",
+    "[\"\\u12\"]",
+    "\"open",
+    "[1]]",
+    "{} {}",
+};
+
+static int _check(bool ok, const char *what) {
+    if (!ok) {
+        LOG_ERR("Unexpected %s.", what);
+        return 1;
+    }
+    return 0;
+}
+
+static int _check_string(
+    const struct json_node *node, const char *expected, size_t len
+) {
+    const char *value = json_node_string(node);
+    if (value == NULL || node->size != len || memcmp(value, expected, len)) {
+        LOG_ERR("Unexpected string, expected '%s'.", expected);
+        return 1;
+    }
+    return 0;
+}
+
+static int _check_values() {
+    static const char json[] =
+        " {\"int\": -42, \"real\": 1.5e3, \"big\": 123456789012345678901234,"
+        " \"t\": true, \"f\": false, \"n\": null,"
+        " \"esc\": \"a\\\"b\\\\c\\/\\n\\u00e9\\u2014\\ud83d\\ude00\","
+        " \"str,:{}[]\": [[], {}, [1, [2, {\"x\": 3}]], \"\"]} ";
+
+    struct json_tape tape;
+    json_tape_init(&tape);
+    if (json_tape_parse(&tape, json, strlen(json)) != 0) {
+        LOG_ERR("Could not parse at offset %zu.", tape.error_offset);
+        json_tape_finish(&tape);
+        return 1;
+    }
+
+    const struct json_node *root     = json_tape_root(&tape);
+    int                     failures = 0;
+    failures += _check(json_node_is(root, JSON_NODE_OBJECT), "root type");
+    failures += _check(
+        root->size == 8 && root->skip == tape.nodes_len, "size of the root"
+    );
+
+    const struct json_node *integer = json_node_get(root, "int");
+    failures += _check(
+        json_node_is(integer, JSON_NODE_INTEGER) && integer->integer == -42,
+        "integer"
+    );
+    const struct json_node *real = json_node_get(root, "real");
+    failures += _check(
+        json_node_is(real, JSON_NODE_REAL) && real->real == 1500, "real"
+    );
+    failures += _check(
+        json_node_is(json_node_get(root, "big"), JSON_NODE_REAL),
+        "integer out of range"
+    );
+    failures += _check(
+        json_node_is(json_node_get(root, "t"), JSON_NODE_TRUE), "true"
+    );
+    failures += _check(
+        json_node_is(json_node_get(root, "f"), JSON_NODE_FALSE), "false"
+    );
+    failures += _check(
+        json_node_is(json_node_get(root, "n"), JSON_NODE_NULL), "null"
+    );
+    failures += _check(json_node_get(root, "missing") == NULL, "missing key");
+
+    static const char unescaped[] =
+        "a\"b\\c/\n\xc3\xa9\xe2\x80\x94\xf0\x9f\x98\x80";
+    failures += _check_string(
+        json_node_get(root, "esc"), unescaped, sizeof(unescaped) - 1
+    );
+
+    // Structural characters in keys and nested containers are skipped over.
+    const struct json_node *array = json_node_get(root, "str,:{}[]");
+    failures += _check(json_node_array_size(array) == 4, "array size");
+    failures += _check(
+        json_node_array_size(json_node_at(array, 0)) == 0, "empty array"
+    );
+    failures += _check(
+        json_node_is(json_node_at(array, 1), JSON_NODE_OBJECT) &&
+            json_node_at(array, 1)->size == 0,
+        "empty object"
+    );
+    const struct json_node *inner = json_node_at(json_node_at(array, 2), 1);
+    const struct json_node *x     = json_node_get(json_node_at(inner, 1), "x");
+    failures += _check(
+        json_node_is(x, JSON_NODE_INTEGER) && x->integer == 3, "nested value"
+    );
+    failures += _check_string(json_node_at(array, 3), "", 0);
+    failures += _check(json_node_at(array, 4) == NULL, "value out of range");
+    failures += _check(json_node_at(root, 0) == NULL, "index of an object");
+    failures += _check(json_node_get(array, "x") == NULL, "key of an array");
+
+    json_tape_finish(&tape);
+    return failures;
+}
+
+static int _check_invalid() {
+    struct json_tape tape;
+    json_tape_init(&tape);
+
+    int failures = 0;
+    for (size_t i = 0; i < ARRAY_LEN(invalid); i++) {
+        size_t len = strlen(invalid[i]);
+        if (json_tape_parse(&tape, invalid[i], len) == 0 ||
+            json_tape_parse_scalar(&tape, invalid[i], len) == 0) {
+            LOG_ERR("Parsed invalid JSON '%s'.", invalid[i]);
+            failures++;
+        }
+    }
+
+    // Deeper than any tree, the limit protects the stack.
+    char deep[600];
+    memset(deep, '[', sizeof(deep) / 2);
+    memset(deep + sizeof(deep) / 2, ']', sizeof(deep) / 2);
+    failures += _check(
+        json_tape_parse(&tape, deep, sizeof(deep)) != 0, "result for deep JSON"
+    );
+
+    json_tape_finish(&tape);
+    return failures;
+}
+
+static bool _same_tapes(const struct json_tape *a, const struct json_tape *b) {
+    if (a->nodes_len != b->nodes_len) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a->nodes_len; i++) {
+        const struct json_node *x = &a->nodes[i];
+        const struct json_node *y = &b->nodes[i];
+        if (x->type != y->type || x->size != y->size || x->skip != y->skip) {
+            return false;
+        }
+        if ((x->type == JSON_NODE_INTEGER && x->integer != y->integer) ||
+            (x->type == JSON_NODE_REAL && x->real != y->real) ||
+            (x->type == JSON_NODE_STRING &&
+             memcmp(x->string, y->string, x->size) != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Escaped quotes and backslashes at every position around the end of the
+ * first 64-byte block, where the escapes carry to the next one. The SIMD and
+ * scalar stages must give the same tape, with the expected string.
+ */
+static int _check_block_boundaries() {
+    static const char *escapes[]  = {"\\\"", "\\\\", "\\\\\\\"", "\\\\\\\\"};
+    static const char *expected[] = {"\"", "\\", "\\\"", "\\\\"};
+
+    struct json_tape simd, scalar;
+    json_tape_init(&simd);
+    json_tape_init(&scalar);
+
+    int failures = 0;
+    for (size_t e = 0; e < ARRAY_LEN(escapes); e++) {
+        for (int pad = 50; pad < 80; pad++) {
+            char json[256];
+            int  len = snprintf(
+                json, sizeof(json), "[\"%*s%s\",{\"k\":[1]}]", pad, "",
+                escapes[e]
+            );
+
+            if (json_tape_parse(&simd, json, len) != 0 ||
+                json_tape_parse_scalar(&scalar, json, len) != 0) {
+                LOG_ERR("Could not parse '%s'.", json);
+                failures++;
+                continue;
+            }
+
+            const char *value =
+                json_node_string(json_node_at(json_tape_root(&simd), 0));
+            if (value == NULL || strcmp(value + pad, expected[e]) != 0 ||
+                json_node_array_size(json_tape_root(&simd)) != 2) {
+                LOG_ERR("Unexpected values for '%s'.", json);
+                failures++;
+            }
+            if (!_same_tapes(&simd, &scalar)) {
+                LOG_ERR("SIMD and scalar tapes differ for '%s'.", json);
+                failures++;
+            }
+        }
+    }
+
+    json_tape_finish(&scalar);
+    json_tape_finish(&simd);
+    return failures;
+}
+
+int main() {
+    int failures  = 0;
+    failures     += _check_values();
+    failures     += _check_invalid();
+    failures     += _check_block_boundaries();
+
+    return failures == 0 ? 0 : 1;
+}
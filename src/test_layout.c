@@ -0,0 +1,277 @@
+#include "layout.h"
+#include "log.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// MIN_SANE_W and MIN_SANE_H of Sway, it refuses to make tiled windows smaller.
+#define SWAY_MIN_WIDTH  100
+#define SWAY_MIN_HEIGHT 60
+
+// Columns of the given widths, with 10px gaps.
+static struct siblings _columns(const int32_t *widths, int count, int focused) {
+    struct siblings siblings = {
+        .horizontal = true,
+        .count      = count,
+        .focused    = focused,
+    };
+
+    int32_t x = 0;
+    for (int i = 0; i < count; i++) {
+        siblings.nodes[i] = (struct sibling){
+            .id   = 10 + i,
+            .rect = {.x = x, .y = 0, .w = widths[i], .h = 1080},
+        };
+        x += widths[i] + 10;
+    }
+
+    return siblings;
+}
+
+static int _check_sizes(
+    const char *preset_str, const struct siblings *siblings,
+    const int32_t *expected
+) {
+    struct layout_preset preset;
+    int32_t              sizes[SWAY_WIN_MAX_SIBLINGS];
+    if (layout_preset_parse(&preset, preset_str) != 0 ||
+        layout_preset_compute(&preset, siblings, sizes) != 0) {
+        LOG_ERR("Could not compute layout `%s`.", preset_str);
+        return 1;
+    }
+
+    for (int i = 0; i < siblings->count; i++) {
+        if (sizes[i] != expected[i]) {
+            LOG_ERR(
+                "Layout `%s`: sizes[%d] = %d, expected %d.", preset_str, i,
+                sizes[i], expected[i]
+            );
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int _check_rejected(const char *preset_str, const struct siblings *s) {
+    struct layout_preset preset;
+    int32_t              sizes[SWAY_WIN_MAX_SIBLINGS];
+    if (layout_preset_parse(&preset, preset_str) == 0 &&
+        layout_preset_compute(&preset, s, sizes) == 0) {
+        LOG_ERR("Layout `%s` was not rejected.", preset_str);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Resize sibling `i` by `amount` like Sway's container_resize_tiled: a middle
+// child takes half of it from each neighbour unless only its edge with the
+// next one moves, the last child moves its edge with the previous one.
+static int _sway_resize(
+    int32_t *sizes, int count, int i, int32_t amount, bool edge, int32_t min
+) {
+    int prev = -1;
+    int next = i + 1;
+    if (!edge && i == count - 1) {
+        next   = i;
+        i      = i - 1;
+        amount = -amount;
+    } else if (!edge && i > 0) {
+        prev = i - 1;
+    }
+
+    int32_t sibling_amount = prev >= 0 ? ceil(amount / 2.0) : amount;
+    if (sizes[i] + amount < min || sizes[next] - sibling_amount < min ||
+        (prev >= 0 && sizes[prev] - sibling_amount < min)) {
+        return 1;
+    }
+
+    // Sway keeps fractions of the total and rounds them when arranging, the
+    // last child gets what is left.
+    double  total = 0;
+    int32_t left  = 0;
+
+    double fractions[SWAY_WIN_MAX_SIBLINGS] = {0};
+    for (int j = 0; j < count; j++) {
+        total += sizes[j];
+    }
+    for (int j = 0; j < count; j++) {
+        fractions[j] = sizes[j] / total;
+    }
+    fractions[i]    += amount / total;
+    fractions[next] -= (prev >= 0 ? amount / 2.0 : amount) / total;
+    if (prev >= 0) {
+        fractions[prev] -= amount / 2.0 / total;
+    }
+    for (int j = 0; j < count; j++) {
+        sizes[j]  = j < count - 1 ? lround(fractions[j] * total) : total - left;
+        left     += sizes[j];
+    }
+
+    return 0;
+}
+
+// Run `cmd` on the sizes of `siblings` as Sway would, into `sizes`.
+static int _sway_run(
+    const struct siblings *siblings, const char *cmd, int32_t *sizes
+) {
+    int32_t min = siblings->horizontal ? SWAY_MIN_WIDTH : SWAY_MIN_HEIGHT;
+    for (int i = 0; i < siblings->count; i++) {
+        const struct rect *rect = &siblings->nodes[i].rect;
+        sizes[i]                = siblings->horizontal ? rect->w : rect->h;
+    }
+
+    char *copy = strdup(cmd);
+    char *strtok_p;
+    int   failed = 0;
+    for (char *c = strtok_r(copy, ";", &strtok_p); c != NULL && !failed;
+         c       = strtok_r(NULL, ";", &strtok_p)) {
+        int     id;
+        char    verb[16], axis[16];
+        int32_t value;
+        if (sscanf(c, "[con_id=%d] resize %15s %15s %dpx", &id, verb, axis,
+                   &value) != 4) {
+            LOG_ERR("Unexpected command `%s`.", c);
+            failed = 1;
+            break;
+        }
+
+        int i = id - siblings->nodes[0].id;
+        if (strcmp(verb, "set") == 0) {
+            failed = _sway_resize(
+                sizes, siblings->count, i, value - sizes[i], false, min
+            );
+        } else {
+            failed = _sway_resize(
+                sizes, siblings->count, i,
+                strcmp(verb, "grow") == 0 ? value : -value, true, min
+            );
+        }
+        if (failed) {
+            LOG_ERR("Sway refuses `%s`.", c);
+        }
+    }
+
+    free(copy);
+    return failed;
+}
+
+// Apply the command of a layout with Sway's rules and check where the
+// siblings end up.
+static int _check_sway(
+    const char *preset_str, const struct siblings *siblings,
+    const int32_t *expected
+) {
+    struct layout_preset preset;
+    int32_t              sizes[SWAY_WIN_MAX_SIBLINGS];
+    int32_t              result[SWAY_WIN_MAX_SIBLINGS];
+    if (layout_preset_parse(&preset, preset_str) != 0 ||
+        layout_preset_compute(&preset, siblings, sizes) != 0) {
+        LOG_ERR("Could not compute layout `%s`.", preset_str);
+        return 1;
+    }
+
+    char *cmd    = layout_command(siblings, sizes);
+    int   failed = cmd == NULL || _sway_run(siblings, cmd, result) != 0;
+    for (int i = 0; !failed && i < siblings->count; i++) {
+        if (result[i] != expected[i]) {
+            LOG_ERR(
+                "Layout `%s` in Sway: sibling %d is %dpx, expected %d.",
+                preset_str, i, result[i], expected[i]
+            );
+            failed = 1;
+        }
+    }
+
+    free(cmd);
+    return failed;
+}
+
+// The simulation itself: setting the size of a middle child shrinks both of
+// its neighbours.
+static int _check_sway_split() {
+    struct siblings siblings = _columns((int32_t[]){300, 300, 300}, 3, 1);
+    int32_t         sizes[SWAY_WIN_MAX_SIBLINGS];
+    if (_sway_run(&siblings, "[con_id=11] resize set width 400px", sizes) !=
+            0 ||
+        sizes[0] != 250 || sizes[1] != 400 || sizes[2] != 250) {
+        LOG_ERR("Wrong simulation of Sway's split resize.");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int _check_command() {
+    // Rows this time.
+    struct siblings siblings = _columns((int32_t[]){100, 200, 300}, 3, 0);
+    siblings.horizontal      = false;
+    for (int i = 0; i < siblings.count; i++) {
+        siblings.nodes[i].rect.h = siblings.nodes[i].rect.w;
+    }
+
+    char *cmd = layout_command(&siblings, (int32_t[]){300, 200, 100});
+    int   failed =
+        cmd == NULL ||
+        strcmp(
+            cmd,
+            "[con_id=11] resize grow down 200px;"
+            "[con_id=10] resize grow down 200px"
+        ) != 0;
+    if (failed) {
+        LOG_ERR("Wrong layout command: %s", cmd);
+    }
+
+    free(cmd);
+    return failed;
+}
+
+int main() {
+    int failures = 0;
+
+    struct siblings three = _columns((int32_t[]){100, 501, 400}, 3, 1);
+    failures += _check_sizes("equal", &three, (int32_t[]){334, 334, 333});
+    failures += _check_sizes("golden", &three, (int32_t[]){192, 618, 191});
+    failures += _check_sizes("fixed:200", &three, (int32_t[]){200, 401, 400});
+    failures += _check_sizes(
+        "fixed:10%,50%", &three, (int32_t[]){100, 500, 401}
+    );
+
+    failures += _check_rejected("fixed:100,200,300,400", &three);
+    failures += _check_rejected("fixed:100,200,300", &three);
+    failures += _check_rejected("fixed:1000", &three);
+    failures += _check_rejected("fixed:1%", &three);
+    failures += _check_rejected("fixed:", &three);
+    failures += _check_rejected("fixed:10px", &three);
+    failures += _check_rejected("fixed:-10", &three);
+    failures += _check_rejected("spiral", &three);
+
+    struct siblings alone = _columns((int32_t[]){1000}, 1, 0);
+    failures += _check_rejected("equal", &alone);
+
+    failures += _check_command();
+    failures += _check_sway_split();
+
+    failures += _check_sway("equal", &three, (int32_t[]){334, 334, 333});
+    failures += _check_sway("golden", &three, (int32_t[]){192, 618, 191});
+
+    // The first ones grow out of the last one, it has to give space first.
+    struct siblings growing = _columns((int32_t[]){100, 100, 800}, 3, 0);
+    failures += _check_sway(
+        "fixed:400,400", &growing, (int32_t[]){400, 400, 200}
+    );
+
+    struct siblings five =
+        _columns((int32_t[]){600, 150, 150, 150, 150}, 5, 0);
+    failures += _check_sway(
+        "equal", &five, (int32_t[]){240, 240, 240, 240, 240}
+    );
+    failures += _check_sway(
+        "fixed:150,450,150", &five, (int32_t[]){150, 450, 150, 225, 225}
+    );
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+#include "bench.h"
+#include "log.h"
+#include "render.h"
+#include "render_pool.h"
+#include "render_thread.h"
+#include "surface_buffer.h"
+
+#include <cairo/cairo.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OUTPUT_WIDTH  1280
+#define OUTPUT_HEIGHT 720
+
+static void _buffer_init(
+    struct surface_buffer *buffer, uint32_t width, uint32_t height
+) {
+    memset(buffer, 0, sizeof(struct surface_buffer));
+    buffer->width         = width;
+    buffer->height        = height;
+    buffer->cairo_surface = cairo_image_surface_create(
+        CAIRO_FORMAT_ARGB32, buffer->width, buffer->height
+    );
+    buffer->cairo = cairo_create(buffer->cairo_surface);
+    buffer->data  = cairo_image_surface_get_data(buffer->cairo_surface);
+    buffer->state = SURFACE_BUFFER_READY;
+}
+
+static void _buffer_finish(struct surface_buffer *buffer) {
+    surface_buffer_split_tiles(buffer, 0);
+    cairo_destroy(buffer->cairo);
+    cairo_surface_destroy(buffer->cairo_surface);
+}
+
+static void _render(
+    struct state *state, struct surface_buffer *buffer, double scale,
+    size_t num_threads
+) {
+    struct render_pool pool;
+    render_pool_init(&pool, num_threads);
+    render_pool_render(&pool, state, buffer, scale, NULL);
+    render_pool_destroy(&pool);
+}
+
+// Wait for the frame handed over to the render thread.
+static struct surface_buffer *_wait_frame(struct render_thread *thread) {
+    struct pollfd pollfd = {.fd = thread->event_fd, .events = POLLIN};
+    struct rect   damage;
+    if (poll(&pollfd, 1, -1) < 0) {
+        return NULL;
+    }
+    return render_thread_take(thread, &damage);
+}
+
+// A frame rendered on the render thread is the state as it was handed over,
+// whatever the dispatch thread does to the state in the meantime.
+static int _check_render_thread(struct state *state) {
+    struct surface_buffer direct, threaded;
+    _buffer_init(&direct, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+    _buffer_init(&threaded, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+    _render(state, &direct, 1, 1);
+    size_t size = (size_t)OUTPUT_HEIGHT *
+                  cairo_image_surface_get_stride(direct.cairo_surface);
+
+    struct render_thread thread;
+    if (render_thread_init(&thread, 2) != 0) {
+        LOG_ERR("Could not start the render thread.");
+        _buffer_finish(&threaded);
+        _buffer_finish(&direct);
+        return 1;
+    }
+    render_thread_submit(&thread, state, &threaded, 1, NULL, (struct rect){0});
+
+    // Move the window and its guides, as a key press would.
+    struct focused_window window = state->focused_window;
+    state->focused_window.rect.x = window.rect.x + 100;
+    resize_parameters_compute_guides(
+        state->resize_params, &state->focused_window
+    );
+
+    int failures = 0;
+    if (_wait_frame(&thread) != &threaded) {
+        LOG_ERR("The render thread did not give the buffer back.");
+        failures++;
+    } else if (memcmp(direct.data, threaded.data, size) != 0) {
+        LOG_ERR("The render thread drew a state changed after hand-over.");
+        failures++;
+    }
+
+    state->focused_window = window;
+    resize_parameters_compute_guides(
+        state->resize_params, &state->focused_window
+    );
+
+    render_thread_finish(&thread);
+    _buffer_finish(&threaded);
+    _buffer_finish(&direct);
+    return failures;
+}
+
+// Before the tree is received, the first frame is the background alone and
+// nothing over it needs damage.
+static int _check_first_frame(struct state *state) {
+    struct surface_buffer buffer;
+    _buffer_init(&buffer, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+    state->focused_window_ready = false;
+    _render(state, &buffer, 1, 2);
+
+    int failures = 0;
+    if (render_extent(state).w != 0) {
+        LOG_ERR("The first frame has an extent.");
+        failures++;
+    }
+
+    int       stride = cairo_image_surface_get_stride(buffer.cairo_surface);
+    uint32_t *first  = (uint32_t *)buffer.data;
+    for (int y = 0; y < OUTPUT_HEIGHT && failures == 0; y++) {
+        uint32_t *row = (uint32_t *)((uint8_t *)buffer.data + y * stride);
+        for (int x = 0; x < OUTPUT_WIDTH; x++) {
+            if (row[x] != *first) {
+                LOG_ERR("The first frame draws over the background.");
+                failures++;
+                break;
+            }
+        }
+    }
+
+    state->focused_window_ready = true;
+    _buffer_finish(&buffer);
+    return failures;
+}
+
+/*
+ * Rendering in tiles on several threads must give the same pixels as
+ * rendering the whole buffer at once, at integer and fractional scales.
+ */
+int main() {
+    struct state state;
+    bench_state_init(&state, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+
+    static const double scales[]  = {1, 1.5, 2};
+    static const size_t threads[] = {2, 3, 8};
+    int                 failures  = 0;
+    for (size_t i = 0; i < ARRAY_LEN(scales); i++) {
+        uint32_t width  = OUTPUT_WIDTH * scales[i];
+        uint32_t height = OUTPUT_HEIGHT * scales[i];
+
+        struct surface_buffer whole;
+        _buffer_init(&whole, width, height);
+        _render(&state, &whole, scales[i], 1);
+        size_t size = (size_t)height *
+                      cairo_image_surface_get_stride(whole.cairo_surface);
+
+        for (size_t j = 0; j < ARRAY_LEN(threads); j++) {
+            struct surface_buffer tiled;
+            _buffer_init(&tiled, width, height);
+            _render(&state, &tiled, scales[i], threads[j]);
+
+            if (tiled.num_tiles < 2) {
+                LOG_ERR("Buffer not split with %zu threads.", threads[j]);
+                failures++;
+            }
+            if (memcmp(whole.data, tiled.data, size) != 0) {
+                LOG_ERR(
+                    "Rendering with %zu threads at scale %.1f differs.",
+                    threads[j], scales[i]
+                );
+                failures++;
+            }
+
+            _buffer_finish(&tiled);
+        }
+
+        _buffer_finish(&whole);
+    }
+
+    failures += _check_render_thread(&state);
+    failures += _check_first_frame(&state);
+
+    bench_state_finish(&state);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -91,5 +91,24 @@ int main() {
     }
 
     free_resize_params(params);
+
+    struct resize_parameter param;
+    enum resize_direction   direction;
+    if (resize_parameter_parse(&param, "x:v:-20%", &direction) != 0 ||
+        direction != RESIZE_VERTICAL || param.symbol != 'x' ||
+        param.value != -20 || !param.relative || !param.percentage) {
+        LOG_ERR("Could not parse a single guide.");
+        return 3;
+    }
+
+    static char *invalid_tokens[] = {"h:+10", "x:q:10", "x:h:", "x:h:10px"};
+    for (int i = 0; i < ARRAY_LEN(invalid_tokens); i++) {
+        if (resize_parameter_parse(&param, invalid_tokens[i], &direction) ==
+            0) {
+            LOG_ERR("Invalid guide `%s` parsed.", invalid_tokens[i]);
+            return 4;
+        }
+    }
+
     return 0;
 }
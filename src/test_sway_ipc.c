@@ -0,0 +1,172 @@
+#include "log.h"
+#include "sway_ipc.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define NUM_REQUESTS    200
+#define LARGE_REPLY_LEN (1 << 20)
+
+// Fake Sway answering each message with its payload, except for GET_TREE
+// which gets a large reply.
+static void *_serve(void *data) {
+    int fd = *(int *)data;
+
+    char *large = malloc(LARGE_REPLY_LEN);
+    memset(large, 'x', LARGE_REPLY_LEN);
+
+    for (;;) {
+        struct sway_ipc_msg *msg = sway_ipc_recv(fd);
+        if (msg == NULL) {
+            break;
+        }
+
+        if (msg->type == SWAY_MSG_GET_TREE) {
+            sway_ipc_send(fd, msg->type, large, LARGE_REPLY_LEN);
+        } else {
+            sway_ipc_send(fd, msg->type, msg->payload, msg->length);
+        }
+        free(msg);
+    }
+
+    free(large);
+    close(fd);
+    return NULL;
+}
+
+struct expected_reply {
+    int  index;
+    int *next_index;
+    int *failures;
+};
+
+static void _check_reply(void *data, struct sway_ipc_msg *msg) {
+    struct expected_reply *expected = data;
+
+    char payload[32];
+    snprintf(
+        payload, sizeof(payload), "resize set width %dpx", expected->index
+    );
+
+    if (msg == NULL || strcmp(msg->payload, payload) != 0 ||
+        *expected->next_index != expected->index) {
+        LOG_ERR("Unexpected reply for request %d.", expected->index);
+        (*expected->failures)++;
+    }
+    (*expected->next_index)++;
+}
+
+static void _check_large_reply(void *data, struct sway_ipc_msg *msg) {
+    int *failures = data;
+    if (msg == NULL || msg->length != LARGE_REPLY_LEN ||
+        strlen(msg->payload) != LARGE_REPLY_LEN) {
+        LOG_ERR("Large reply was not received whole.");
+        (*failures)++;
+    }
+}
+
+static void _expect_failure(void *data, struct sway_ipc_msg *msg) {
+    int *failures = data;
+    if (msg != NULL) {
+        LOG_ERR("Reply received after the connection was closed.");
+        (*failures)++;
+    }
+}
+
+static void _expect_no_call(void *data, struct sway_ipc_msg *msg) {
+    int *failures = data;
+    LOG_ERR("Handler called for a request dropped by finish.");
+    (*failures)++;
+}
+
+// Requests still pending when the client is finished are dropped silently.
+static int _check_finish_drops() {
+    int failures = 0;
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        LOG_ERR("Could not create socket pair.");
+        return 1;
+    }
+
+    struct sway_ipc_client client;
+    sway_ipc_client_init(&client, fds[0]);
+    sway_ipc_client_send(
+        &client, SWAY_MSG_GET_TREE, "", 0, _expect_no_call, &failures
+    );
+    sway_ipc_client_flush(&client);
+    sway_ipc_client_send(
+        &client, SWAY_MSG_GET_WORKSPACES, "", 0, _expect_no_call, &failures
+    );
+    sway_ipc_client_finish(&client);
+    close(fds[1]);
+
+    return failures;
+}
+
+int main() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        LOG_ERR("Could not create socket pair.");
+        return 1;
+    }
+
+    pthread_t server;
+    pthread_create(&server, NULL, _serve, &fds[1]);
+
+    struct sway_ipc_client client;
+    sway_ipc_client_init(&client, fds[0]);
+
+    // Pipeline many requests with a large reply in the middle, the replies
+    // must come back in order.
+    struct expected_reply expected[NUM_REQUESTS];
+    int                   next_index = 0;
+    int                   failures   = 0;
+    for (int i = 0; i < NUM_REQUESTS; i++) {
+        expected[i] = (struct expected_reply){
+            .index      = i,
+            .next_index = &next_index,
+            .failures   = &failures,
+        };
+
+        char payload[32];
+        int  len =
+            snprintf(payload, sizeof(payload), "resize set width %dpx", i);
+        sway_ipc_client_send(
+            &client, SWAY_MSG_RUN_COMMAND, payload, len, _check_reply,
+            &expected[i]
+        );
+
+        if (i == NUM_REQUESTS / 2) {
+            sway_ipc_client_send(
+                &client, SWAY_MSG_GET_TREE, "", 0, _check_large_reply,
+                &failures
+            );
+        }
+    }
+
+    if (sway_ipc_client_wait(&client) != 0 || next_index != NUM_REQUESTS) {
+        LOG_ERR("Only %d replies received.", next_index);
+        return 1;
+    }
+
+    // Requests in flight when the peer goes away get a NULL reply.
+    shutdown(fds[0], SHUT_WR);
+    pthread_join(server, NULL);
+    sway_ipc_client_send(
+        &client, SWAY_MSG_RUN_COMMAND, "nop", 3, _expect_failure, &failures
+    );
+    if (sway_ipc_client_wait(&client) == 0) {
+        LOG_ERR("Waiting on a closed connection succeeded.");
+        failures++;
+    }
+
+    sway_ipc_client_finish(&client);
+
+    failures += _check_finish_drops();
+
+    return failures == 0 ? 0 : 1;
+}
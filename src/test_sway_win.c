@@ -0,0 +1,151 @@
+#include "log.h"
+#include "sway_win.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE(id, x, y, w, h, extra)                                            \
+    "{\"id\":" #id ",\"type\":\"con\",\"rect\":{\"x\":" #x ",\"y\":" #y       \
+    ",\"width\":" #w ",\"height\":" #h "}," extra "}"
+
+// Horizontal workspace on an output at x = 100: a window, a vertical split
+// holding the focused window, and a tabbed container showing its second
+// child. One floating window.
+static const char *tree =
+    "{\"id\":1,\"type\":\"root\",\"focus\":[2],\"floating_nodes\":[],"
+    "\"rect\":{\"x\":0,\"y\":0,\"width\":1300,\"height\":800},\"nodes\":["
+    "{\"id\":2,\"type\":\"output\",\"name\":\"OUT-1\",\"focus\":[3],"
+    "\"floating_nodes\":[],"
+    "\"rect\":{\"x\":100,\"y\":0,\"width\":1200,\"height\":800},\"nodes\":["
+    "{\"id\":3,\"type\":\"workspace\",\"orientation\":\"horizontal\","
+    "\"layout\":\"splith\",\"focus\":[11,10,14,20],"
+    "\"rect\":{\"x\":100,\"y\":0,\"width\":1200,\"height\":800},"
+    "\"floating_nodes\":[" NODE(20, 300, 200, 200, 100, "\"nodes\":[]") "],"
+    "\"nodes\":[" NODE(10, 100, 0, 400, 800, "\"nodes\":[]") "," NODE(
+        11, 500, 0, 400, 800,
+        "\"orientation\":\"vertical\",\"layout\":\"splitv\","
+        "\"focus\":[12,13],\"nodes\":[" NODE(
+            12, 500, 0, 400, 400, "\"focused\":true,\"nodes\":[],"
+                                  "\"deco_rect\":{\"x\":0,\"y\":0,"
+                                  "\"width\":0,\"height\":0}"
+        ) "," NODE(13, 500, 400, 400, 400, "\"nodes\":[]") "]"
+    ) "," NODE(
+        14, 900, 0, 400, 800,
+        "\"orientation\":\"horizontal\",\"layout\":\"tabbed\","
+        "\"focus\":[16,15],\"nodes\":[" NODE(
+            15, 900, 30, 400, 770, "\"nodes\":[]"
+        ) "," NODE(
+            16, 900, 30, 400, 770,
+            "\"nodes\":[],\"deco_rect\":{\"x\":0,\"y\":0,\"width\":400,"
+            "\"height\":30}"
+        ) "]"
+    ) "]}]}]}";
+
+// The focused workspace is on the second output.
+static const char *workspaces =
+    "[{\"num\":1,\"name\":\"1\",\"focused\":false,\"output\":\"OUT-1\"},"
+    "{\"num\":2,\"name\":\"2\",\"focused\":true,\"output\":\"OUT-2\"}]";
+
+static int _check(bool ok, const char *what) {
+    if (!ok) {
+        LOG_ERR("Unexpected %s.", what);
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    struct json_tape tape;
+    json_tape_init(&tape);
+    if (json_tape_parse(&tape, tree, strlen(tree)) != 0) {
+        LOG_ERR("Could not parse test tree at offset %zu.", tape.error_offset);
+        return 1;
+    }
+
+    struct focused_window  fw;
+    struct visible_windows visible = {0};
+    if (find_visible_windows(&fw, &visible, json_tape_root(&tape)) != 0) {
+        LOG_ERR("Could not find the visible windows.");
+        return 1;
+    }
+
+    int failures = 0;
+    failures += _check(fw.id == 12, "focused window");
+    failures += _check(fw.rect.x == 400 && fw.rect.h == 400, "focused rect");
+
+    static const int expected_ids[] = {10, 12, 13, 16, 20};
+    failures += _check(visible.count == 5, "number of visible windows");
+    for (int i = 0; i < visible.count && i < 5; i++) {
+        failures += _check(visible.windows[i].id == expected_ids[i], "order");
+        failures += _check(visible.windows[i].output == NULL, "output");
+    }
+
+    if (visible.count == 5) {
+        // Left of the workspace, resizable to the right up to the split.
+        struct focused_window *left = &visible.windows[0];
+        failures += _check(
+            !left->resize_left && left->resize_right &&
+                left->resize_right_limit == 800,
+            "limits of the left window"
+        );
+
+        // Bottom of the split, with the horizontal limits of the split.
+        struct focused_window *bottom = &visible.windows[2];
+        failures += _check(
+            bottom->resize_top && !bottom->resize_bottom &&
+                bottom->resize_top_limit == 0 &&
+                bottom->resize_bottom_limit == 800 && bottom->resize_left &&
+                bottom->resize_left_limit == 0 && bottom->resize_right &&
+                bottom->resize_right_limit == 1200,
+            "limits of the bottom window"
+        );
+
+        // The title bar of the tab is part of the window.
+        struct focused_window *tab = &visible.windows[3];
+        failures += _check(
+            tab->rect.x == 800 && tab->rect.y == 0 && tab->rect.h == 800,
+            "rect of the tab"
+        );
+
+        struct focused_window *floating = &visible.windows[4];
+        failures += _check(
+            floating->floating && floating->rect.x == 200 &&
+                floating->resize_left_limit == 0 &&
+                floating->resize_right_limit == 1200,
+            "floating window"
+        );
+    }
+
+    // The focused window alone is the same as before.
+    struct focused_window alone;
+    failures += _check(
+        find_focused_window(&alone, json_tape_root(&tape)) == 0, "result"
+    );
+    failures += _check(
+        alone.id == fw.id && alone.resize_top == fw.resize_top &&
+            alone.resize_bottom_limit == fw.resize_bottom_limit &&
+            alone.siblings.count == fw.siblings.count,
+        "focused window without visible windows"
+    );
+
+    if (json_tape_parse(&tape, workspaces, strlen(workspaces)) != 0) {
+        LOG_ERR("Could not parse test workspaces.");
+        json_tape_finish(&tape);
+        return 1;
+    }
+    const char *output = find_focused_output(json_tape_root(&tape));
+    failures += _check(
+        output != NULL && strcmp(output, "OUT-2") == 0, "focused output"
+    );
+    failures += _check(
+        find_focused_output(json_node_at(json_tape_root(&tape), 0)) == NULL,
+        "output without focused workspace"
+    );
+    json_tape_finish(&tape);
+
+    free((void *)fw.output);
+    free((void *)alone.output);
+    visible_windows_finish(&visible);
+
+    return failures == 0 ? 0 : 1;
+}
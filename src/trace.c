@@ -0,0 +1,148 @@
+#include "trace.h"
+
+#include "log.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// A run records a few dozen events, this leaves room for long sessions.
+#define TRACE_MAX_EVENTS 4096
+
+struct trace_event {
+    const char *name;
+    const char *arg_name;
+    int64_t     arg;
+    uint64_t    id; // of async spans
+    uint64_t    ts_ns;
+    pid_t       tid;
+    char        phase;
+};
+
+static struct {
+    const char        *path;
+    uint64_t           start_ns;
+    atomic_size_t      num_events;
+    struct trace_event events[TRACE_MAX_EVENTS];
+} trace;
+
+static uint64_t _now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void _trace_record(
+    char phase, const char *name, const char *arg_name, int64_t arg,
+    uint64_t id
+) {
+    if (trace.path == NULL) {
+        return;
+    }
+
+    size_t i = atomic_fetch_add(&trace.num_events, 1);
+    if (i >= TRACE_MAX_EVENTS) {
+        return;
+    }
+
+    struct trace_event *event = &trace.events[i];
+    event->ts_ns              = _now_ns();
+    event->name               = name;
+    event->arg_name           = arg_name;
+    event->arg                = arg;
+    event->id                 = id;
+    event->tid                = gettid();
+    event->phase              = phase;
+}
+
+static void _trace_write() {
+    FILE *file = fopen(trace.path, "w");
+    if (file == NULL) {
+        LOG_ERR("Could not open trace file '%s'.", trace.path);
+        return;
+    }
+
+    size_t num_events = atomic_load(&trace.num_events);
+    if (num_events > TRACE_MAX_EVENTS) {
+        LOG_WARN("Trace truncated to %d events.", TRACE_MAX_EVENTS);
+        num_events = TRACE_MAX_EVENTS;
+    }
+
+    pid_t pid = getpid();
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    for (size_t i = 0; i < num_events; i++) {
+        struct trace_event *event = &trace.events[i];
+        fprintf(
+            file,
+            "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,"
+            "\"tid\":%d",
+            i == 0 ? "" : ",", event->name, event->phase,
+            (event->ts_ns - trace.start_ns) / 1e3, pid, event->tid
+        );
+        if (event->phase == 'i') {
+            fputs(",\"s\":\"t\"", file);
+        }
+        // Async spans are matched by category and id, the name keeps spans
+        // of different phases apart.
+        if (event->phase == 'b' || event->phase == 'e') {
+            fprintf(
+                file, ",\"cat\":\"%s\",\"id\":%llu", event->name,
+                (unsigned long long)event->id
+            );
+        }
+        if (event->arg_name != NULL) {
+            fprintf(
+                file, ",\"args\":{\"%s\":%lld}", event->arg_name,
+                (long long)event->arg
+            );
+        }
+        fputc('}', file);
+    }
+    fputs("\n]}\n", file);
+
+    fclose(file);
+}
+
+int trace_init(const char *path) {
+    trace.path     = path;
+    trace.start_ns = _now_ns();
+    atomic_store(&trace.num_events, 0);
+
+    if (atexit(_trace_write) != 0) {
+        LOG_ERR("Could not register trace writer.");
+        trace.path = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+bool trace_enabled() {
+    return trace.path != NULL;
+}
+
+void trace_begin(const char *name) {
+    _trace_record('B', name, NULL, 0, 0);
+}
+
+void trace_end(const char *name) {
+    _trace_record('E', name, NULL, 0, 0);
+}
+
+void trace_async_begin(const char *name, uint64_t id) {
+    _trace_record('b', name, NULL, 0, id);
+}
+
+void trace_async_end(const char *name, uint64_t id) {
+    _trace_record('e', name, NULL, 0, id);
+}
+
+void trace_instant(const char *name) {
+    _trace_record('i', name, NULL, 0, 0);
+}
+
+void trace_instant_arg(const char *name, const char *arg_name, int64_t arg) {
+    _trace_record('i', name, arg_name, arg, 0);
+}
@@ -0,0 +1,34 @@
+#ifndef __TRACE_H_INCLUDED__
+#define __TRACE_H_INCLUDED__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Monotonic clock trace spans, written as Chrome/Perfetto trace JSON.
+ *
+ * Nothing is recorded until `trace_init` is called. Event names must be
+ * string literals as only the pointer is kept. Spans started with
+ * `trace_begin` must be ended with `trace_end` on the same thread, and nest
+ * within the other spans of the thread.
+ */
+
+// Start recording. The trace is written to `path` when the program exits.
+int trace_init(const char *path);
+
+bool trace_enabled();
+
+void trace_begin(const char *name);
+void trace_end(const char *name);
+
+// Span that can overlap other spans of the thread, like a request waiting for
+// its reply while the next ones are sent. Spans of the same name are told
+// apart by `id`, each is shown on a track of its own.
+void trace_async_begin(const char *name, uint64_t id);
+void trace_async_end(const char *name, uint64_t id);
+void trace_instant(const char *name);
+
+// Instant event carrying a numeric argument, e.g. an input event timestamp.
+void trace_instant_arg(const char *name, const char *arg_name, int64_t arg);
+
+#endif
@@ -14,6 +14,24 @@ int max(int a, int b) {
     return a > b ? a : b;
 }
 
+struct rect rect_union(struct rect a, struct rect b) {
+    if (a.w <= 0 || a.h <= 0) {
+        return b;
+    }
+    if (b.w <= 0 || b.h <= 0) {
+        return a;
+    }
+
+    int32_t x = min(a.x, b.x);
+    int32_t y = min(a.y, b.y);
+    return (struct rect){
+        .x = x,
+        .y = y,
+        .w = max(a.x + a.w, b.x + b.w) - x,
+        .h = max(a.y + a.h, b.y + b.h) - y,
+    };
+}
+
 int str_to_rune(char *str, uint32_t *rune) {
     unsigned char *c = ((unsigned char *)str);
 
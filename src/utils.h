@@ -13,6 +13,9 @@ struct rect {
 
 int max(int a, int b);
 int min(int a, int b);
+
+// Smallest rectangle containing both, empty rectangles are ignored.
+struct rect rect_union(struct rect a, struct rect b);
 int find_str(char **strs, size_t len, char *to_find);
 
 // Extract first rune (32 bit UTF-8 code) in string.